@@ -0,0 +1,200 @@
+#include "AdaptiveSubdivider.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+bool AdaptiveSubdivider::operator()( FlatMesh& mesh,
+                                     int maxDepth,
+                                     FlatSubdivider::Workspace& workspace ) const {
+    if ( !mesh.isUniform( 3 ) ) { return false; }
+    FlatMesh adapted( workspace.arena );
+    for ( int i = 0; i < maxDepth; ++i )
+    {
+        if ( !refine( mesh, workspace, adapted ) ) { break; }
+        std::swap( mesh, adapted );
+    }
+    return true;
+}
+
+bool AdaptiveSubdivider::refine( const FlatMesh& mesh,
+                                 FlatSubdivider::Workspace& workspace,
+                                 FlatMesh& out ) const {
+    // the buffers of a level are served by the arena of the workspace, if any
+    Arena* arena    = workspace.arena;
+    Connectivity& c = workspace.connectivity;
+    c.build( mesh );
+    const size_t nv = mesh.nVertices();
+    const size_t ne = c.nEdges();
+    const size_t nf = mesh.nFaces();
+
+    // refinement priority of each edge, > 1 when a criterion requires a split
+    Vector3Array faceNormals( nf );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        const uint o     = mesh.faceOffsets[f];
+        const Vector3& a = mesh.positions[mesh.faceIndices[o]];
+        const Vector3 n  = ( mesh.positions[mesh.faceIndices[o + 1]] - a )
+                              .cross( mesh.positions[mesh.faceIndices[o + 2]] - a );
+        const Scalar l   = n.norm();
+        faceNormals[f]   = l > 0 ? Vector3( n / l ) : Vector3::Zero();
+    } );
+    ArenaVector<Scalar> priority( ne, arena );
+    parallelFor( 0, ne, [&]( size_t e ) {
+        const auto& edge = c.edges[e];
+        Scalar p         = 0;
+        if ( m_edgeLength > 0 )
+        { p = ( mesh.positions[edge.v1] - mesh.positions[edge.v0] ).norm() / m_edgeLength; }
+        if ( m_curvatureAngle > 0 && edge.nFaces == 2 )
+        {
+            const Scalar cosAngle = faceNormals[edge.f0].dot( faceNormals[edge.f1] );
+            const Scalar angle    = std::acos( std::clamp( cosAngle, Scalar( -1 ), Scalar( 1 ) ) );
+            p                     = std::max( p, angle / m_curvatureAngle );
+        }
+        priority[e] = p;
+    } );
+
+    ArenaVector<uint> candidates( arena );
+    for ( uint e = 0; e < ne; ++e )
+    {
+        if ( priority[e] > 1 ) { candidates.push_back( e ); }
+    }
+    if ( candidates.empty() ) { return false; }
+    std::sort( candidates.begin(), candidates.end(), [&priority]( uint a, uint b ) {
+        return priority[a] > priority[b] || ( priority[a] == priority[b] && a < b );
+    } );
+
+    // Split the k first candidates, then close the selection: a triangle with two split edges
+    // gets its third edge split. Returns the number of triangles of the refined mesh.
+    ArenaVector<uint8_t> split( arena );
+    ArenaVector<uint> pending( arena );
+    auto splitCount = [&]( uint f ) {
+        const uint o = mesh.faceOffsets[f];
+        return split[c.cornerEdges[o]] + split[c.cornerEdges[o + 1]] + split[c.cornerEdges[o + 2]];
+    };
+    auto select = [&]( size_t k ) {
+        split.assign( ne, 0 );
+        pending.clear();
+        auto mark = [&]( uint e ) {
+            if ( split[e] ) { return; }
+            split[e] = 1;
+            // faces of the edge, including all the faces of a non-manifold edge
+            const uint v0 = c.edges[e].v0;
+            const uint v1 = c.edges[e].v1;
+            for ( uint j = c.vertexFaceOffsets[v0]; j < c.vertexFaceOffsets[v0 + 1]; ++j )
+            {
+                const uint f = c.vertexFaces[j];
+                const uint o = mesh.faceOffsets[f];
+                if ( mesh.faceIndices[o] == v1 || mesh.faceIndices[o + 1] == v1 ||
+                     mesh.faceIndices[o + 2] == v1 )
+                { pending.push_back( f ); }
+            }
+        };
+        for ( size_t i = 0; i < k; ++i )
+        {
+            mark( candidates[i] );
+        }
+        while ( !pending.empty() )
+        {
+            const uint f = pending.back();
+            pending.pop_back();
+            if ( splitCount( f ) == 2 )
+            {
+                const uint o = mesh.faceOffsets[f];
+                for ( uint i = 0; i < 3; ++i )
+                {
+                    mark( c.cornerEdges[o + i] );
+                }
+            }
+        }
+        size_t triangles = nf;
+        for ( uint f = 0; f < nf; ++f )
+        {
+            const uint s = splitCount( f );
+            triangles += s == 3 ? 3 : s;
+        }
+        return triangles;
+    };
+
+    // largest prefix of the candidates fitting in the budget (the closure grows with k)
+    size_t k = candidates.size();
+    if ( m_triangleBudget > 0 && select( k ) > m_triangleBudget )
+    {
+        size_t lo = 0, hi = k;
+        while ( lo + 1 < hi )
+        {
+            const size_t mid = ( lo + hi ) / 2;
+            if ( select( mid ) <= m_triangleBudget ) { lo = mid; }
+            else
+            { hi = mid; }
+        }
+        k = lo;
+        if ( k == 0 ) { return false; }
+    }
+    select( k );
+
+    // new vertex of each split edge
+    ArenaVector<uint> edgeVertex( ne + 1, 0, arena );
+    std::copy( split.begin(), split.end(), edgeVertex.begin() );
+    const uint nSplit = exclusiveScan( edgeVertex );
+    ArenaVector<uint8_t> moved( nv, 0, arena );
+    for ( uint e = 0; e < ne; ++e )
+    {
+        if ( split[e] ) { moved[c.edges[e].v0] = moved[c.edges[e].v1] = 1; }
+    }
+
+    // Loop stencils of the moved vertices and split edges only, so that a level costs the size
+    // of its refined region rather than of the uniform refinement
+    out.positions.resize( nv + nSplit );
+    parallelFor( 0, nv, [&]( size_t v ) {
+        out.positions[v] =
+            moved[v] ? FlatSubdivider::loopVertexPoint( mesh, c, uint( v ) ) : mesh.positions[v];
+    } );
+    parallelFor( 0, ne, [&]( size_t e ) {
+        if ( split[e] )
+        { out.positions[nv + edgeVertex[e]] = FlatSubdivider::loopEdgePoint( mesh, c, uint( e ) ); }
+    } );
+
+    // faces: unchanged, bisected (one split edge) or 1 to 4 split
+    ArenaVector<uint> firstTriangle( nf + 1, 0, arena );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        const uint s     = splitCount( uint( f ) );
+        firstTriangle[f] = s == 0 ? 1 : s == 1 ? 2 : 4;
+    } );
+    const uint nTriangles = exclusiveScan( firstTriangle );
+    out.faceIndices.resize( 3 * size_t( nTriangles ) );
+    out.faceOffsets.resize( nTriangles + 1 );
+    parallelFor( 0, nTriangles + 1, [&]( size_t t ) { out.faceOffsets[t] = uint( 3 * t ); } );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        const uint o = mesh.faceOffsets[f];
+        uint* t      = out.faceIndices.data() + 3 * size_t( firstTriangle[f] );
+        uint corner[3], mid[3];
+        for ( uint i = 0; i < 3; ++i )
+        {
+            const uint e = c.cornerEdges[o + i];
+            corner[i]    = mesh.faceIndices[o + i];
+            mid[i]       = split[e] ? uint( nv ) + edgeVertex[e] : Connectivity::Invalid;
+        }
+        const uint s = splitCount( uint( f ) );
+        if ( s == 0 ) { std::copy( corner, corner + 3, t ); }
+        else if ( s == 1 )
+        {
+            const uint i = mid[0] != Connectivity::Invalid ? 0 : mid[1] != Connectivity::Invalid ? 1 : 2;
+            const uint a = corner[i], b = corner[( i + 1 ) % 3], d = corner[( i + 2 ) % 3];
+            const uint tris[6]{a, mid[i], d, mid[i], b, d};
+            std::copy( tris, tris + 6, t );
+        }
+        else
+        {
+            const uint tris[12]{corner[0], mid[0], mid[2], mid[0], corner[1], mid[1],
+                                mid[2],    mid[1], corner[2], mid[0], mid[1], mid[2]};
+            std::copy( tris, tris + 12, t );
+        }
+    } );
+    return true;
+}
+
+} // namespace Subdivision
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "FlatSubdivider.hpp"
+
+namespace Subdivision {
+
+/// Adaptive Loop subdivision with a triangle budget.
+///
+/// At each level, the edges meeting a refinement criterion (dihedral angle above
+/// curvatureAngle, or length above edgeLength) are split, by decreasing order of priority, as long
+/// as the refined mesh stays within the triangle budget.
+/// Triangles with 2 or 3 split edges are refined 1 to 4 (all edges split), triangles with one split
+/// edge are bisected, so that the transitions between levels have no T-junction and no crack.
+/// Split edges and their end vertices take the positions of the uniform Loop refinement, other
+/// vertices are left untouched.
+class AdaptiveSubdivider
+{
+  public:
+    /// \p curvatureAngle in radians, 0 disables the criterion, as 0 for \p edgeLength.
+    AdaptiveSubdivider( size_t triangleBudget, Scalar curvatureAngle, Scalar edgeLength ) :
+        m_triangleBudget( triangleBudget ),
+        m_curvatureAngle( curvatureAngle ),
+        m_edgeLength( edgeLength ) {}
+
+    /// Refine \p mesh at most \p maxDepth times, the buffers of each level being served by the
+    /// arena of \p workspace, if any.
+    /// Returns false if the mesh cannot be processed (triangles only).
+    bool operator()( FlatMesh& mesh, int maxDepth, FlatSubdivider::Workspace& workspace ) const;
+
+  private:
+    /// One adaptive level, returns false when nothing can be refined.
+    bool refine( const FlatMesh& mesh,
+                 FlatSubdivider::Workspace& workspace,
+                 FlatMesh& out ) const;
+
+    size_t m_triangleBudget;
+    Scalar m_curvatureAngle;
+    Scalar m_edgeLength;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,88 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace Subdivision {
+
+namespace {
+
+// constant initialized, usable by allocations made before main()
+std::atomic<bool> countAllocations{false};
+std::atomic<size_t> allocationCount{0};
+std::atomic<size_t> allocatedBytes{0};
+std::atomic<size_t> systemAllocationCount{0};
+
+void* allocate( std::size_t size ) {
+    countAllocation( size );
+    countSystemAllocation();
+    for ( ;; )
+    {
+        if ( void* p = std::malloc( size > 0 ? size : 1 ) ) { return p; }
+        std::new_handler handler = std::get_new_handler();
+        if ( handler == nullptr ) { throw std::bad_alloc(); }
+        handler();
+    }
+}
+
+} // namespace
+
+void setAllocationCounting( bool enabled ) {
+    countAllocations = enabled;
+}
+
+AllocationCounters allocationCounters() {
+    AllocationCounters counters;
+    counters.allocations       = allocationCount.load();
+    counters.bytes             = allocatedBytes.load();
+    counters.systemAllocations = systemAllocationCount.load();
+    return counters;
+}
+
+void countAllocation( size_t bytes ) {
+    if ( !countAllocations.load( std::memory_order_relaxed ) ) { return; }
+    allocationCount.fetch_add( 1, std::memory_order_relaxed );
+    allocatedBytes.fetch_add( bytes, std::memory_order_relaxed );
+}
+
+void countSystemAllocation() {
+    if ( !countAllocations.load( std::memory_order_relaxed ) ) { return; }
+    systemAllocationCount.fetch_add( 1, std::memory_order_relaxed );
+}
+
+} // namespace Subdivision
+
+// Replacement of the global allocation functions, to count allocations when profiling. Each
+// block is the pointer returned by malloc, freed as is. Aligned variants are not counted.
+void* operator new( std::size_t size ) {
+    return Subdivision::allocate( size );
+}
+void* operator new[]( std::size_t size ) {
+    return Subdivision::allocate( size );
+}
+void* operator new( std::size_t size, const std::nothrow_t& ) noexcept {
+    try
+    {
+        return Subdivision::allocate( size );
+    }
+    catch ( const std::bad_alloc& )
+    {
+        return nullptr;
+    }
+}
+void* operator new[]( std::size_t size, const std::nothrow_t& tag ) noexcept {
+    return operator new( size, tag );
+}
+void operator delete( void* p ) noexcept {
+    std::free( p );
+}
+void operator delete[]( void* p ) noexcept {
+    std::free( p );
+}
+void operator delete( void* p, std::size_t ) noexcept {
+    std::free( p );
+}
+void operator delete[]( void* p, std::size_t ) noexcept {
+    std::free( p );
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Subdivision {
+
+/// Process wide allocation counters.
+///
+/// The global operator new and delete of the application only forward to malloc and free, and
+/// count the calls while counting is enabled: no header is added to the blocks, so that blocks
+/// allocated and freed on either side of a library boundary stay compatible.
+struct AllocationCounters {
+    /// Calls to operator new, and blocks served by an Arena
+    size_t allocations{0};
+    size_t bytes{0};
+    /// Calls to malloc: by operator new, and for the chunks of an Arena
+    size_t systemAllocations{0};
+};
+
+/// Count the allocations (off by default, the Profiler enables it).
+void setAllocationCounting( bool enabled );
+
+/// Current value of the counters, which only change while counting is enabled.
+AllocationCounters allocationCounters();
+
+/// Count a block of \p bytes that is not served by operator new (Arena).
+void countAllocation( size_t bytes );
+
+/// Count a call to malloc that is not made by operator new (chunk of an Arena).
+void countSystemAllocation();
+
+} // namespace Subdivision
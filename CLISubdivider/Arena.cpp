@@ -0,0 +1,101 @@
+#include "Arena.hpp"
+#include "AllocationCounter.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace Subdivision {
+
+struct Arena::Chunk {
+    explicit Chunk( size_t s ) : size( s ) {}
+    Chunk* next{nullptr};
+    const size_t size;
+    size_t used{0};
+};
+
+namespace {
+
+constexpr size_t MaxChunkSize = size_t( 1 ) << 26;
+// the blocks of a chunk start after its header, aligned as malloc
+constexpr size_t ChunkHeader = ( sizeof( Arena::Chunk ) + alignof( std::max_align_t ) - 1 ) &
+                               ~( alignof( std::max_align_t ) - 1 );
+
+inline char* data( Arena::Chunk* chunk ) {
+    return reinterpret_cast<char*>( chunk ) + ChunkHeader;
+}
+
+/// Offset of the first block of \p alignment at or after \p used in \p chunk.
+inline size_t alignedOffset( Arena::Chunk* chunk, size_t used, size_t alignment ) {
+    const auto address = reinterpret_cast<std::uintptr_t>( data( chunk ) ) + used;
+    return used + ( ( alignment - address % alignment ) % alignment );
+}
+
+} // namespace
+
+Arena::~Arena() {
+    release();
+    std::free( m_spare );
+}
+
+void* Arena::allocate( size_t bytes, size_t alignment ) {
+    countAllocation( bytes );
+    size_t offset = m_head != nullptr ? alignedOffset( m_head, m_head->used, alignment ) : 0;
+    if ( m_head == nullptr || offset + bytes > m_head->size )
+    {
+        // worst case padding of the first block of a chunk
+        const size_t n = bytes + std::max( alignment, alignof( std::max_align_t ) );
+        Chunk* chunk;
+        if ( m_spare != nullptr && m_spare->size >= n )
+        {
+            chunk   = m_spare;
+            m_spare = nullptr;
+        }
+        else
+        {
+            const size_t size = std::max( m_chunkSize, n );
+            void* memory      = std::malloc( ChunkHeader + size );
+            if ( memory == nullptr ) { throw std::bad_alloc(); }
+            countSystemAllocation();
+            chunk       = new ( memory ) Chunk( size );
+            m_chunkSize = std::min( 2 * m_chunkSize, MaxChunkSize );
+        }
+        chunk->next = m_head;
+        m_head      = chunk;
+        ++m_chunks;
+        m_bytes += chunk->size;
+        offset = alignedOffset( chunk, 0, alignment );
+    }
+    m_head->used = offset + bytes;
+    ++m_allocations;
+    return data( m_head ) + offset;
+}
+
+void Arena::release() {
+    // the largest chunk is kept for the next job
+    Chunk* kept = m_spare;
+    for ( Chunk* chunk = m_head; chunk != nullptr; chunk = chunk->next )
+    {
+        if ( kept == nullptr || chunk->size > kept->size ) { kept = chunk; }
+    }
+    for ( Chunk* chunk = m_head; chunk != nullptr; )
+    {
+        Chunk* next = chunk->next;
+        if ( chunk != kept ) { std::free( chunk ); }
+        chunk = next;
+    }
+    if ( m_spare != nullptr && m_spare != kept ) { std::free( m_spare ); }
+    if ( kept != nullptr )
+    {
+        kept->next = nullptr;
+        kept->used = 0;
+    }
+    m_spare       = kept;
+    m_head        = nullptr;
+    m_allocations = 0;
+    m_chunks      = 0;
+    m_bytes       = 0;
+}
+
+} // namespace Subdivision
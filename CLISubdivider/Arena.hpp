@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace Subdivision {
+
+/// Monotonic allocator for the temporary buffers of a job, released in one step.
+///
+/// Blocks are carved from large chunks allocated with malloc, and deallocating one does nothing:
+/// memory is reclaimed by release(), once the job is done. The largest chunk is kept for the
+/// next job, so that consecutive jobs (batch and server modes) reuse pages that are already
+/// mapped, instead of malloc unmapping and mapping again the large blocks of each job.
+///
+/// The arena is passed explicitly, through an ArenaAllocator, to the containers it serves.
+/// It is not thread safe: blocks must be allocated by one thread at a time.
+class Arena
+{
+  public:
+    struct Chunk;
+
+    /// \param chunkSize size of the first chunk, the next ones double up to 64 MB. Larger blocks
+    /// get a chunk of their own.
+    explicit Arena( size_t chunkSize = size_t( 1 ) << 20 ) : m_chunkSize( chunkSize ) {}
+    ~Arena();
+    Arena( const Arena& ) = delete;
+    Arena& operator=( const Arena& ) = delete;
+
+    /// Block of \p bytes aligned on \p alignment (a power of two), valid until the next release.
+    void* allocate( size_t bytes, size_t alignment );
+
+    /// Release the chunks allocated since the last release, but the largest one which is kept
+    /// for the next job. The blocks allocated so far must not be used anymore.
+    void release();
+
+    /// Blocks allocated since the last release
+    inline size_t allocations() const { return m_allocations; }
+    /// Chunks used since the last release, and their total size in bytes
+    inline size_t chunks() const { return m_chunks; }
+    inline size_t bytes() const { return m_bytes; }
+
+  private:
+    Chunk* m_head{nullptr};
+    /// Empty chunk kept by release() for the next job
+    Chunk* m_spare{nullptr};
+    size_t m_chunkSize;
+    size_t m_allocations{0};
+    size_t m_chunks{0};
+    size_t m_bytes{0};
+};
+
+/// Standard allocator serving its blocks from an Arena, or from operator new without one.
+///
+/// A copy of a container is allocated with operator new, so that it can outlive the arena. Move
+/// assignment and swap carry the arena along with the blocks: a container is bound to an arena
+/// by assigning it an empty container built with that arena, and back to the heap by assigning
+/// it a default constructed one.
+template <typename T>
+class ArenaAllocator
+{
+  public:
+    static_assert( alignof( T ) <= alignof( std::max_align_t ), "Over-aligned type" );
+
+    using value_type                             = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    ArenaAllocator() = default;
+    /// Implicit, so that an Arena pointer can be given to the constructors of the containers.
+    ArenaAllocator( Arena* arena ) : m_arena( arena ) {}
+    template <typename U>
+    ArenaAllocator( const ArenaAllocator<U>& other ) : m_arena( other.arena() ) {}
+
+    T* allocate( size_t n ) {
+        if ( m_arena == nullptr ) { return static_cast<T*>( ::operator new( n * sizeof( T ) ) ); }
+        return static_cast<T*>( m_arena->allocate( n * sizeof( T ), alignof( T ) ) );
+    }
+    void deallocate( T* p, size_t ) {
+        if ( m_arena == nullptr ) { ::operator delete( p ); }
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+    /// Arena serving the blocks, null for operator new
+    inline Arena* arena() const { return m_arena; }
+
+  private:
+    Arena* m_arena{nullptr};
+};
+
+template <typename T, typename U>
+inline bool operator==( const ArenaAllocator<T>& a, const ArenaAllocator<U>& b ) {
+    return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+inline bool operator!=( const ArenaAllocator<T>& a, const ArenaAllocator<U>& b ) {
+    return a.arena() != b.arena();
+}
+
+/// Vector whose buffer is served by an Arena, or by operator new when it is built without one.
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace Subdivision
@@ -0,0 +1,291 @@
+#include "AttributeSubdivider.hpp"
+#include "Parallel.hpp"
+#include "StencilTable.hpp"
+
+#include <Core/Geometry/StandardAttribNames.hpp>
+#include <Core/Utils/Attribs.hpp>
+#include <Core/Utils/Log.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+namespace {
+
+/// One vertex attribute, one array per component.
+struct Channel {
+    std::string name;
+    /// 1 (Scalar) to 4 (Vector4)
+    uint nComponents{0};
+    bool faceVarying{false};
+    std::vector<std::vector<Scalar>> coarse;
+    std::vector<std::vector<Scalar>> refined;
+
+    template <typename T>
+    void read( const Utils::Attrib<T>& attrib ) {
+        const auto& data = attrib.data();
+        nComponents      = uint( attrib.getNumberOfComponents() );
+        coarse.assign( nComponents, std::vector<Scalar>( data.size() ) );
+        parallelFor( 0, data.size(), [&]( size_t v ) {
+            for ( uint c = 0; c < nComponents; ++c )
+            {
+                coarse[c][v] = component( data[v], c );
+            }
+        } );
+    }
+
+    /// Refined values at \p vertices (indices in refined) as an attribute container.
+    template <typename T>
+    typename Utils::Attrib<T>::Container write( const std::vector<uint>& vertices ) const {
+        typename Utils::Attrib<T>::Container data( vertices.size() );
+        parallelFor( 0, vertices.size(), [&]( size_t v ) {
+            for ( uint c = 0; c < nComponents; ++c )
+            {
+                component( data[v], c ) = refined[c][vertices[v]];
+            }
+        } );
+        return data;
+    }
+
+    static inline Scalar component( const Scalar& s, uint ) { return s; }
+    static inline Scalar& component( Scalar& s, uint ) { return s; }
+    template <typename V>
+    static inline Scalar component( const V& v, uint c ) {
+        return v( c );
+    }
+    template <typename V>
+    static inline Scalar& component( V& v, uint c ) {
+        return v( c );
+    }
+};
+
+/// Weld the vertices with the same original position, given by \p positionIndices (the vertices
+/// past its end are not welded): \p weld maps each vertex to its welded index,
+/// \p representatives gives the first vertex of each welded vertex, in index order.
+void weldVertices( size_t nv,
+                   const std::vector<uint>& positionIndices,
+                   std::vector<uint>& weld,
+                   std::vector<uint>& representatives ) {
+    // first vertex of each original position
+    const size_t nIndexed = std::min( nv, positionIndices.size() );
+    uint nPositions       = 0;
+    for ( size_t v = 0; v < nIndexed; ++v )
+    {
+        nPositions = std::max( nPositions, positionIndices[v] + 1 );
+    }
+    std::vector<uint> firstOfPosition( nPositions, uint( -1 ) );
+    std::vector<uint> first( nv );
+    for ( uint v = 0; v < nv; ++v )
+    {
+        if ( v >= nIndexed ) { first[v] = v; }
+        else
+        {
+            uint& f  = firstOfPosition[positionIndices[v]];
+            f        = std::min( f, v );
+            first[v] = f;
+        }
+    }
+    representatives.clear();
+    std::vector<uint> id( nv );
+    for ( uint v = 0; v < nv; ++v )
+    {
+        if ( first[v] == v )
+        {
+            id[v] = uint( representatives.size() );
+            representatives.push_back( v );
+        }
+    }
+    weld.resize( nv );
+    parallelFor( 0, nv, [&]( size_t v ) { weld[v] = id[first[v]]; } );
+}
+
+} // namespace
+
+bool AttributeSubdivider::operator()( Geometry::TriangleMesh& mesh,
+                                      int iterations,
+                                      const std::vector<uint>& positionIndices ) {
+    const Vector3Array& positions = mesh.vertices();
+    const auto& triangles         = mesh.getIndices();
+    const size_t nv               = positions.size();
+    const std::string positionName =
+        Geometry::getAttribName( Geometry::MeshAttrib::VERTEX_POSITION );
+    const std::string normalName = Geometry::getAttribName( Geometry::MeshAttrib::VERTEX_NORMAL );
+
+    std::vector<uint> weld, representatives;
+    weldVertices( nv, positionIndices, weld, representatives );
+
+    // gather the attributes, face-varying if they differ between copies of a welded vertex
+    std::vector<Channel> channels;
+    mesh.vertexAttribs().for_each_attrib( [&]( Utils::AttribBase* attrib ) {
+        if ( attrib->getName() == positionName || attrib->getSize() != nv ) { return; }
+        Channel channel;
+        channel.name = attrib->getName();
+        if ( attrib->isFloat() ) { channel.read( attrib->cast<Utils::Attrib<Scalar>>() ); }
+        else if ( attrib->isVector2() )
+        { channel.read( attrib->cast<Utils::Attrib<Vector2>>() ); }
+        else if ( attrib->isVector3() )
+        { channel.read( attrib->cast<Utils::Attrib<Vector3>>() ); }
+        else if ( attrib->isVector4() )
+        { channel.read( attrib->cast<Utils::Attrib<Vector4>>() ); }
+        else
+        {
+            LOG( logWARNING ) << "Attribute " << attrib->getName()
+                              << " has an unsupported type, it is dropped.";
+            return;
+        }
+        for ( size_t v = 0; v < nv && !channel.faceVarying; ++v )
+        {
+            const uint r = representatives[weld[v]];
+            for ( uint c = 0; c < channel.nComponents; ++c )
+            {
+                channel.faceVarying =
+                    channel.faceVarying || channel.coarse[c][v] != channel.coarse[c][r];
+            }
+        }
+        channels.push_back( std::move( channel ) );
+    } );
+    m_faceVarying.clear();
+    for ( const auto& channel : channels )
+    {
+        if ( channel.faceVarying ) { m_faceVarying.push_back( channel.name ); }
+    }
+
+    // welded topology, and the original one for face-varying attributes
+    FlatMesh welded;
+    welded.positions.resize( representatives.size() );
+    for ( size_t v = 0; v < representatives.size(); ++v )
+    {
+        welded.positions[v] = positions[representatives[v]];
+    }
+    welded.faceOffsets.resize( triangles.size() + 1 );
+    welded.faceIndices.resize( 3 * triangles.size() );
+    parallelFor( 0, triangles.size(), [&]( size_t t ) {
+        welded.faceOffsets[t + 1] = uint( 3 * ( t + 1 ) );
+        for ( uint i = 0; i < 3; ++i )
+        {
+            welded.faceIndices[3 * t + i] = weld[triangles[t]( i )];
+        }
+    } );
+    StencilTable weldedStencils, splitStencils;
+    FlatMesh refinedWelded, refinedSplit;
+    if ( !weldedStencils.build( welded, m_scheme, iterations, refinedWelded, m_arena ) )
+    { return false; }
+    const bool faceVarying = !m_faceVarying.empty();
+    if ( faceVarying &&
+         !splitStencils.build(
+             FlatMesh::fromTriangleMesh( mesh ), m_scheme, iterations, refinedSplit, m_arena ) )
+    { return false; }
+
+    // one fused pass per topology
+    std::vector<std::vector<Scalar>> coarsePositions( 3,
+                                                      std::vector<Scalar>( welded.nVertices() ) );
+    std::vector<std::vector<Scalar>> refinedPositions(
+        3, std::vector<Scalar>( weldedStencils.rows() ) );
+    parallelFor( 0, welded.nVertices(), [&]( size_t v ) {
+        for ( uint c = 0; c < 3; ++c )
+        {
+            coarsePositions[c][v] = welded.positions[v]( c );
+        }
+    } );
+    std::vector<const Scalar*> weldedIn, splitIn;
+    std::vector<Scalar*> weldedOut, splitOut;
+    for ( uint c = 0; c < 3; ++c )
+    {
+        weldedIn.push_back( coarsePositions[c].data() );
+        weldedOut.push_back( refinedPositions[c].data() );
+    }
+    for ( auto& channel : channels )
+    {
+        StencilTable& stencils = channel.faceVarying ? splitStencils : weldedStencils;
+        channel.refined.assign( channel.nComponents, std::vector<Scalar>( stencils.rows() ) );
+        for ( uint c = 0; c < channel.nComponents; ++c )
+        {
+            if ( !channel.faceVarying )
+            {
+                // welded values, from the representative vertices
+                std::vector<Scalar> values( welded.nVertices() );
+                for ( size_t v = 0; v < values.size(); ++v )
+                {
+                    values[v] = channel.coarse[c][representatives[v]];
+                }
+                channel.coarse[c] = std::move( values );
+            }
+            ( channel.faceVarying ? splitIn : weldedIn ).push_back( channel.coarse[c].data() );
+            ( channel.faceVarying ? splitOut : weldedOut ).push_back( channel.refined[c].data() );
+        }
+    }
+    weldedStencils.apply( weldedIn, weldedOut );
+    if ( faceVarying ) { splitStencils.apply( splitIn, splitOut ); }
+
+    // output vertices: the refined vertices of the original topology if there are face-varying
+    // attributes, mapped to the welded ones through the face corners
+    const FlatMesh& refined = faceVarying ? refinedSplit : refinedWelded;
+    std::vector<uint> toWelded( refined.nVertices() );
+    if ( faceVarying )
+    {
+        for ( size_t i = 0; i < refinedSplit.faceIndices.size(); ++i )
+        {
+            toWelded[refinedSplit.faceIndices[i]] = refinedWelded.faceIndices[i];
+        }
+    }
+    else
+    { std::iota( toWelded.begin(), toWelded.end(), 0 ); }
+    std::vector<uint> identity( refined.nVertices() );
+    std::iota( identity.begin(), identity.end(), 0 );
+
+    Vector3Array outPositions( refined.nVertices() );
+    parallelFor( 0, outPositions.size(), [&]( size_t v ) {
+        for ( uint c = 0; c < 3; ++c )
+        {
+            outPositions[v]( c ) = refinedPositions[c][toWelded[v]];
+        }
+    } );
+    // fan triangulation (quads are split in two)
+    Geometry::TriangleMesh::IndexContainerType outTriangles;
+    outTriangles.reserve( refined.faceIndices.size() - 2 * refined.nFaces() );
+    for ( size_t f = 0; f < refined.nFaces(); ++f )
+    {
+        const uint o = refined.faceOffsets[f];
+        for ( uint i = 1; i + 1 < refined.faceSize( f ); ++i )
+        {
+            const uint* face = refined.faceIndices.data() + o;
+            outTriangles.emplace_back( face[0], face[i], face[i + 1] );
+        }
+    }
+
+    Geometry::TriangleMesh out;
+    out.setVertices( std::move( outPositions ) );
+    out.setIndices( std::move( outTriangles ) );
+    for ( const auto& channel : channels )
+    {
+        const std::vector<uint>& vertices = channel.faceVarying ? identity : toWelded;
+        if ( channel.name == normalName && channel.nComponents == 3 )
+        {
+            Vector3Array normals = channel.write<Vector3>( vertices );
+            parallelFor( 0, normals.size(), [&normals]( size_t v ) { normals[v].normalize(); } );
+            out.setNormals( std::move( normals ) );
+            continue;
+        }
+        switch ( channel.nComponents )
+        {
+        case 1:
+            out.addAttrib<Scalar>( channel.name, channel.write<Scalar>( vertices ) );
+            break;
+        case 2:
+            out.addAttrib<Vector2>( channel.name, channel.write<Vector2>( vertices ) );
+            break;
+        case 3:
+            out.addAttrib<Vector3>( channel.name, channel.write<Vector3>( vertices ) );
+            break;
+        default:
+            out.addAttrib<Vector4>( channel.name, channel.write<Vector4>( vertices ) );
+        }
+    }
+    mesh = std::move( out );
+    return true;
+}
+
+} // namespace Subdivision
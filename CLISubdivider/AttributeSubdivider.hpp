@@ -0,0 +1,52 @@
+#pragma once
+
+#include "FlatSubdivider.hpp"
+
+#include <Core/Geometry/TriangleMesh.hpp>
+
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// Subdivision of every vertex attribute of a Ra::Core::Geometry::TriangleMesh: positions,
+/// normals, texture coordinates, colors and any Scalar, Vector2, Vector3 or Vector4 attribute.
+///
+/// The copies of a vertex made by the loader for the attribute seams (same original position index)
+/// are welded, so that the surface stays smooth across the seams. Distinct vertices that merely
+/// coincide are not, so that the topology is the one of the other modes. Attributes equal on all
+/// the copies of a welded vertex are refined on the welded topology, with the positions. The others
+/// (texture seams, hard normals) are face-varying: they are refined on the original topology, where
+/// the seams are boundaries, so that each side of a seam keeps its own values.
+///
+/// Attributes are stored as one Scalar array per component (structure of arrays), and the
+/// refinement of each topology is a single StencilTable traversal applying every stencil to all
+/// the components at once, instead of one pass per attribute.
+class AttributeSubdivider
+{
+  public:
+    /// The refinement levels of the stencil tables are served by \p arena when one is given.
+    explicit AttributeSubdivider( Scheme scheme, Arena* arena = nullptr ) :
+        m_scheme( scheme ), m_arena( arena ) {}
+
+    /// Refine \p mesh \p iterations times, with all its attributes. Normals are normalized,
+    /// Catmull-Clark quads are split in two triangles.
+    /// \p positionIndices gives the original position of each vertex (ObjReader), the vertices
+    /// past its end being their own position.
+    /// Returns false if the mesh cannot be processed.
+    bool operator()( Ra::Core::Geometry::TriangleMesh& mesh,
+                     int iterations,
+                     const std::vector<uint>& positionIndices = {} );
+
+    /// Names of the face-varying attributes of the last refined mesh.
+    inline const std::vector<std::string>& faceVaryingAttributes() const {
+        return m_faceVarying;
+    }
+
+  private:
+    Scheme m_scheme;
+    Arena* m_arena;
+    std::vector<std::string> m_faceVarying;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,229 @@
+#include "Batch.hpp"
+#include "Parallel.hpp"
+
+#include <Core/Utils/Log.hpp>
+#include <Core/Utils/Timer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace Subdivision {
+
+using namespace Ra::Core::Utils; // log, timer
+
+bool readManifest( const std::string& filename,
+                   const Settings& defaults,
+                   std::vector<BatchJob>& jobs ) {
+    std::ifstream in( filename );
+    if ( !in )
+    {
+        LOG( logERROR ) << "Cannot open manifest " << filename;
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while ( std::getline( in, line ) )
+    {
+        ++lineNumber;
+        std::istringstream fields( line );
+        BatchJob job;
+        job.settings = defaults;
+        if ( !( fields >> job.input ) || job.input[0] == '#' ) { continue; }
+        // both the type and the iteration count are optional: a numeric field is the count
+        bool valid     = bool( fields >> job.output );
+        bool hasScheme = false, hasIterations = false;
+        std::string field;
+        while ( valid && fields >> field )
+        {
+            const bool numeric = field.size() <= 3 &&
+                                 std::all_of( field.begin(), field.end(), []( unsigned char c ) {
+                                     return std::isdigit( c ) != 0;
+                                 } );
+            if ( numeric && !hasIterations )
+            {
+                job.settings.iterations = std::stoi( field );
+                hasIterations           = true;
+            }
+            else
+            {
+                valid = !hasScheme && !hasIterations &&
+                        schemeFromName( field, job.settings.scheme );
+                hasScheme = true;
+            }
+        }
+        if ( !valid )
+        {
+            LOG( logERROR ) << filename << ":" << lineNumber << ": invalid job \"" << line << "\"";
+            return false;
+        }
+        jobs.push_back( job );
+    }
+    return true;
+}
+
+bool listDirectory( const std::string& directory,
+                    const std::string& outputDirectory,
+                    const Settings& defaults,
+                    std::vector<BatchJob>& jobs ) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    std::vector<fs::path> files;
+    for ( const auto& entry : fs::directory_iterator( directory, error ) )
+    {
+        if ( entry.is_regular_file() && entry.path().extension() == ".obj" )
+        { files.push_back( entry.path() ); }
+    }
+    if ( error )
+    {
+        LOG( logERROR ) << "Cannot list " << directory << ": " << error.message();
+        return false;
+    }
+    fs::create_directories( outputDirectory, error );
+
+    std::sort( files.begin(), files.end() );
+    for ( const auto& f : files )
+    {
+        BatchJob job;
+        job.input    = f.string();
+        job.output   = ( fs::path( outputDirectory ) / f.stem() ).string();
+        job.settings = defaults;
+        jobs.push_back( job );
+    }
+    return true;
+}
+
+size_t BatchRunner::estimateMemory( const BatchJob& job ) {
+    // About 50 bytes of OBJ text per input triangle, and per output triangle about 150 bytes
+    // for the flat engine (mesh, connectivity, refined copy), 100 bytes for the direct engine
+    // (arrays, sort keys and edges) and 600 bytes for the half-edge structure of OpenMesh.
+    std::error_code error;
+    const auto fileSize       = std::filesystem::file_size( job.input, error );
+    const double inputTris    = error ? 12. : double( fileSize ) / 50.;
+    const double growth       = std::pow( 4., job.settings.iterations );
+    const double bytesPerTri  = job.settings.engine == Engine::Flat
+                                   ? 150.
+                                   : job.settings.engine == Engine::Direct ? 100. : 600.;
+    if ( job.settings.patchFaces > 0 )
+    {
+        // input mesh and connectivity, plus one refined patch (with its one-ring) per thread
+        const double patchTris = 2. * double( job.settings.patchFaces ) * growth;
+        return size_t( inputTris * 200. + threadCount() * patchTris * 150. );
+    }
+    if ( job.settings.triangleBudget > 0 )
+    {
+        return size_t( std::min( inputTris * growth, double( job.settings.triangleBudget ) ) *
+                       150. );
+    }
+    return size_t( inputTris * growth * bytesPerTri );
+}
+
+size_t BatchRunner::run( const std::vector<BatchJob>& jobs ) {
+    const unsigned int workers = std::max( 1u,
+                                           std::min<unsigned int>( m_workers > 0 ? m_workers
+                                                                                 : threadCount(),
+                                                                   unsigned( jobs.size() ) ) );
+    const unsigned int threadsPerJob = std::max( 1u, threadCount() / workers );
+
+    std::vector<JobResult> results( jobs.size() );
+    std::atomic<size_t> next{0};
+
+    // memory admission
+    std::mutex mutex;
+    std::condition_variable admission;
+    size_t memoryInUse = 0;
+    size_t running     = 0;
+
+    auto worker = [&]() {
+        ScopedThreadCount scopedThreads( threadsPerJob );
+        Pipeline pipeline( false );
+        for ( size_t j = next++; j < jobs.size(); j = next++ )
+        {
+            const size_t estimate = estimateMemory( jobs[j] );
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                admission.wait( lock, [&]() {
+                    return running == 0 || m_memoryBudget == 0 ||
+                           memoryInUse + estimate <= m_memoryBudget;
+                } );
+                memoryInUse += estimate;
+                ++running;
+            }
+
+            try
+            {
+                results[j] = pipeline.run( jobs[j].input, jobs[j].output, jobs[j].settings );
+            }
+            catch ( const std::exception& e )
+            {
+                // only this job fails, the other ones go on
+                LOG( logERROR ) << jobs[j].input << ": " << e.what();
+                results[j] = JobResult();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                memoryInUse -= estimate;
+                --running;
+            }
+            admission.notify_all();
+        }
+    };
+
+    auto start = Clock::now();
+    std::vector<std::thread> pool;
+    for ( unsigned int w = 0; w < workers; ++w )
+    {
+        pool.emplace_back( worker );
+    }
+    for ( auto& t : pool )
+    {
+        t.join();
+    }
+    const double wall = getIntervalSeconds( start, Clock::now() );
+
+    // summary
+    size_t failed = 0, inputBytes = 0, outputTriangles = 0;
+    double jobSeconds = 0;
+    std::cout << std::left << std::setw( 40 ) << "input" << std::right << std::setw( 12 )
+              << "in tris" << std::setw( 14 ) << "out tris" << std::setw( 10 ) << "load s"
+              << std::setw( 10 ) << "subdiv s" << std::setw( 10 ) << "save s" << std::setw( 12 )
+              << "Mtris/s"
+              << "\n";
+    for ( size_t j = 0; j < jobs.size(); ++j )
+    {
+        const JobResult& r = results[j];
+        std::cout << std::left << std::setw( 40 ) << jobs[j].input << std::right;
+        if ( !r.success )
+        {
+            ++failed;
+            std::cout << "  FAILED\n";
+            continue;
+        }
+        inputBytes += r.inputBytes;
+        outputTriangles += r.outputTriangles;
+        jobSeconds += r.seconds();
+        std::cout << std::setw( 12 ) << r.inputTriangles << std::setw( 14 ) << r.outputTriangles
+                  << std::fixed << std::setprecision( 3 ) << std::setw( 10 ) << r.loadSeconds
+                  << std::setw( 10 ) << r.subdivisionSeconds << std::setw( 10 ) << r.saveSeconds
+                  << std::setw( 12 ) << ( r.outputTriangles / std::max( r.seconds(), 1e-9 ) / 1e6 )
+                  << std::defaultfloat << "\n";
+    }
+    std::cout << jobs.size() - failed << " / " << jobs.size() << " meshes processed by "
+              << workers << " workers (" << threadsPerJob << " threads each) in " << wall
+              << "s (sum of job times " << jobSeconds << "s): "
+              << outputTriangles / std::max( wall, 1e-9 ) / 1e6 << " output Mtris/s, "
+              << inputBytes / std::max( wall, 1e-9 ) / 1e6 << " input MB/s." << std::endl;
+    return failed;
+}
+
+} // namespace Subdivision
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Pipeline.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// One mesh of a batch.
+struct BatchJob {
+    std::string input;
+    /// Output filename, without extension
+    std::string output;
+    Settings settings;
+};
+
+/// Read a manifest file.
+/// Each line lists "input output [scheme] [iterations]", either of the optional fields may be
+/// omitted (a numeric field is the iteration count); missing values are taken from \p defaults.
+/// Empty lines and lines starting with '#' are ignored.
+bool readManifest( const std::string& filename,
+                   const Settings& defaults,
+                   std::vector<BatchJob>& jobs );
+
+/// List every .obj file of \p directory, the outputs being written to \p outputDirectory with the
+/// same base name.
+bool listDirectory( const std::string& directory,
+                    const std::string& outputDirectory,
+                    const Settings& defaults,
+                    std::vector<BatchJob>& jobs );
+
+/// Process a list of jobs concurrently on a bounded pool of workers.
+///
+/// Each worker owns a Pipeline, so that the allocations are reused from one job to the next.
+/// A job is only started when its estimated peak memory fits in the memory budget (a job is
+/// always admitted when no other one is running). The per job threads of the flat engine and
+/// parallel loader are shared between the workers.
+class BatchRunner
+{
+  public:
+    /// \param workers number of concurrent jobs (0: one per core)
+    /// \param memoryBudget maximum estimated memory of the running jobs, in bytes (0: unlimited)
+    BatchRunner( unsigned int workers, size_t memoryBudget ) :
+        m_workers( workers ), m_memoryBudget( memoryBudget ) {}
+
+    /// Run all \p jobs, print a per-file and aggregate summary.
+    /// Returns the number of failed jobs.
+    size_t run( const std::vector<BatchJob>& jobs );
+
+    /// Heuristic peak memory estimate of \p job, in bytes.
+    static size_t estimateMemory( const BatchJob& job );
+
+  private:
+    unsigned int m_workers;
+    size_t m_memoryBudget;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,442 @@
+#include <Core/Geometry/CatmullClarkSubdivider.hpp>
+#include <Core/Geometry/LoopSubdivider.hpp>
+#include <Core/Geometry/MeshPrimitives.hpp>
+#include <Core/Geometry/deprecated/TopologicalMesh.hpp>
+#include <Core/Utils/Log.hpp>
+#include <Core/Utils/Timer.hpp>
+#include <IO/deprecated/OBJFileManager.hpp>
+
+#include <OpenMesh/Tools/Decimater/DecimaterT.hh>
+#include <OpenMesh/Tools/Decimater/ModQuadricT.hh>
+
+#include "Decimator.hpp"
+#include "FlatSubdivider.hpp"
+#include "ObjReader.hpp"
+#include "Parallel.hpp"
+#include "Pipeline.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef RADIUM_VERSION_STRING
+#    define RADIUM_VERSION_STRING "unknown"
+#endif
+
+/// Benchmark of the subdivision pipeline of Radium-CLI-Subdivider.
+/// Each stage of the application (load, topology construction, each subdivision iteration,
+/// conversion to TriangleMesh and save) is timed separately, for the OpenMesh engine used by
+/// default, the flat engine and the direct engine (loop only), on generated meshes and on the
+/// given OBJ files.
+/// Optionally, the subdivided mesh is then decimated, by the sequential OpenMesh decimater or by
+/// the parallel Decimator of the flat engine (the direct engine does not decimate).
+/// Results are written as JSON.
+
+using namespace Ra::Core;
+using namespace Ra::Core::Utils; // log, timer
+
+namespace {
+
+struct args {
+    std::string output{"subdivider-bench.json"};
+    Subdivision::Scheme scheme{Subdivision::Scheme::Loop};
+    int iterations{2};
+    int repetitions{3};
+    /// fraction of the subdivided faces kept by the decimation stage, 0 to skip it
+    double decimation{0};
+    std::vector<Subdivision::Engine> engines{
+        Subdivision::Engine::OpenMesh, Subdivision::Engine::Flat, Subdivision::Engine::Direct};
+    bool generated{true};
+    std::vector<std::string> files;
+};
+
+/// One input mesh: generated, or loaded from an OBJ file (by the load stage).
+struct Input {
+    std::string name;
+    std::string filename; ///< empty for generated meshes
+    std::function<Geometry::TriangleMesh()> generate;
+};
+
+/// Timings of one input and engine, each stage is the minimum over the repetitions.
+struct CaseResult {
+    std::string input;
+    std::string engine;
+    size_t inputVertices{0};
+    size_t inputFaces{0};
+    size_t outputVertices{0};
+    size_t outputFaces{0};
+    size_t decimatedFaces{0};
+    double load{0};
+    double build{0};
+    std::vector<double> iterations;
+    double decimation{0};
+    double toTriangleMesh{0};
+    double save{0};
+    /// Peak resident memory during the case, if it can be reset (peakRssPerCase)
+    size_t peakRss{0};
+
+    double subdivision() const {
+        double s = 0;
+        for ( double t : iterations )
+        {
+            s += t;
+        }
+        return s;
+    }
+};
+
+void keepMin( double& best, double t, int repetition ) {
+    best = repetition == 0 ? t : std::min( best, t );
+}
+
+/// Run \p input through the stages of main() with \p engine.
+bool runCase( const Input& input,
+              Subdivision::Engine engine,
+              const args& a,
+              const std::string& saveName,
+              CaseResult& result ) {
+    result.input  = input.name;
+    const bool flatEngine = engine != Subdivision::Engine::OpenMesh;
+    result.engine         = engine == Subdivision::Engine::Direct
+                        ? "direct"
+                        : flatEngine ? "flat" : "openmesh";
+    result.iterations.assign( size_t( a.iterations ), 0 );
+    const bool decimate = a.decimation > 0 && engine != Subdivision::Engine::Direct;
+
+    for ( int r = 0; r < a.repetitions; ++r )
+    {
+        // load (the flat and direct engines use the parallel reader)
+        Geometry::TriangleMesh mesh;
+        auto start = Clock::now();
+        if ( input.filename.empty() ) { mesh = input.generate(); }
+        else if ( flatEngine )
+        {
+            Subdivision::ObjReader reader;
+            if ( !reader.load( input.filename, mesh ) ) { return false; }
+        }
+        else if ( !Ra::IO::OBJFileManager().load( input.filename, mesh ) )
+        {
+            LOG( logERROR ) << "Cannot load " << input.filename;
+            return false;
+        }
+        keepMin( result.load, getIntervalSeconds( start, Clock::now() ), r );
+        result.inputVertices = mesh.vertices().size();
+        result.inputFaces    = mesh.getIndices().size();
+
+        if ( engine == Subdivision::Engine::Direct )
+        {
+            // no topology to build nor to convert back
+            Subdivision::TriangleMeshSubdivider subdivider;
+            for ( int i = 0; i < a.iterations; ++i )
+            {
+                start = Clock::now();
+                subdivider( mesh, 1 );
+                keepMin( result.iterations[i], getIntervalSeconds( start, Clock::now() ), r );
+            }
+        }
+        else if ( flatEngine )
+        {
+            start = Clock::now();
+            Subdivision::FlatMesh flatMesh = Subdivision::FlatMesh::fromTriangleMesh( mesh );
+            keepMin( result.build, getIntervalSeconds( start, Clock::now() ), r );
+
+            Subdivision::FlatSubdivider subdivider( a.scheme );
+            Subdivision::FlatSubdivider::Workspace workspace;
+            for ( int i = 0; i < a.iterations; ++i )
+            {
+                start = Clock::now();
+                if ( !subdivider( flatMesh, 1, workspace ) ) { return false; }
+                keepMin( result.iterations[i], getIntervalSeconds( start, Clock::now() ), r );
+            }
+            result.outputFaces = flatMesh.nFaces();
+
+            if ( decimate )
+            {
+                start = Clock::now();
+                Subdivision::Decimator decimator( size_t( a.decimation * flatMesh.nFaces() ), 0 );
+                if ( !decimator( flatMesh ) ) { return false; }
+                keepMin( result.decimation, getIntervalSeconds( start, Clock::now() ), r );
+            }
+
+            start = Clock::now();
+            mesh  = flatMesh.toTriangleMesh();
+            keepMin( result.toTriangleMesh, getIntervalSeconds( start, Clock::now() ), r );
+        }
+        else
+        {
+            start = Clock::now();
+            Geometry::deprecated::TopologicalMesh topologicalMesh( mesh );
+            keepMin( result.build, getIntervalSeconds( start, Clock::now() ), r );
+
+            std::unique_ptr<OpenMesh::Subdivider::Uniform::
+                                SubdividerT<Geometry::deprecated::TopologicalMesh, Scalar>>
+                subdivider;
+            if ( a.scheme == Subdivision::Scheme::CatmullClark )
+            { subdivider = std::make_unique<Geometry::CatmullClarkSubdivider>(); }
+            else
+            { subdivider = std::make_unique<Geometry::LoopSubdivider>(); }
+            subdivider->attach( topologicalMesh );
+            for ( int i = 0; i < a.iterations; ++i )
+            {
+                start = Clock::now();
+                ( *subdivider )( 1 );
+                keepMin( result.iterations[i], getIntervalSeconds( start, Clock::now() ), r );
+            }
+            subdivider->detach();
+            result.outputFaces = topologicalMesh.n_faces();
+
+            if ( decimate )
+            {
+                start = Clock::now();
+                topologicalMesh.request_vertex_status();
+                topologicalMesh.request_edge_status();
+                topologicalMesh.request_halfedge_status();
+                topologicalMesh.request_face_status();
+                OpenMesh::Decimater::DecimaterT<Geometry::deprecated::TopologicalMesh> decimater(
+                    topologicalMesh );
+                OpenMesh::Decimater::ModQuadricT<Geometry::deprecated::TopologicalMesh>::Handle
+                    quadric;
+                decimater.add( quadric );
+                decimater.module( quadric ).unset_max_err();
+                decimater.initialize();
+                decimater.decimate_to_faces( 0, size_t( a.decimation * result.outputFaces ) );
+                topologicalMesh.garbage_collection();
+                keepMin( result.decimation, getIntervalSeconds( start, Clock::now() ), r );
+            }
+
+            start = Clock::now();
+            mesh  = topologicalMesh.toTriangleMesh();
+            keepMin( result.toTriangleMesh, getIntervalSeconds( start, Clock::now() ), r );
+        }
+        result.outputVertices = mesh.vertices().size();
+        if ( decimate ) { result.decimatedFaces = mesh.getIndices().size(); }
+        else
+        { result.outputFaces = mesh.getIndices().size(); }
+
+        start = Clock::now();
+        if ( !Ra::IO::OBJFileManager().save( saveName, mesh ) )
+        {
+            LOG( logERROR ) << "Cannot save " << saveName;
+            return false;
+        }
+        keepMin( result.save, getIntervalSeconds( start, Clock::now() ), r );
+    }
+    result.peakRss = Subdivision::peakResidentMemory();
+    return true;
+}
+
+std::string jsonString( const std::string& s ) {
+    std::string ret = "\"";
+    for ( char c : s )
+    {
+        if ( c == '"' || c == '\\' ) { ret += '\\'; }
+        ret += c;
+    }
+    return ret + "\"";
+}
+
+/// \p peakRssPerCase: the peak memory was reset before each case, otherwise only the peak of
+/// the process, \p processPeakRss, is meaningful.
+void writeJson( std::ostream& out,
+                const args& a,
+                const std::vector<CaseResult>& results,
+                bool peakRssPerCase,
+                size_t processPeakRss ) {
+    out << "{\n"
+        << "  \"radiumVersion\": " << jsonString( RADIUM_VERSION_STRING ) << ",\n"
+        << "  \"threads\": " << Subdivision::threadCount() << ",\n"
+        << "  \"scheme\": "
+        << jsonString( a.scheme == Subdivision::Scheme::Loop ? "loop" : "catmull" ) << ",\n"
+        << "  \"iterations\": " << a.iterations << ",\n"
+        << "  \"repetitions\": " << a.repetitions << ",\n"
+        << "  \"decimation\": " << a.decimation << ",\n"
+        << "  \"processPeakRssBytes\": " << processPeakRss << ",\n"
+        << "  \"cases\": [";
+    for ( size_t c = 0; c < results.size(); ++c )
+    {
+        const CaseResult& r = results[c];
+        const double faces  = r.subdivision() > 0 ? r.outputFaces / r.subdivision() : 0;
+        out << ( c == 0 ? "\n" : ",\n" ) << "    {\n"
+            << "      \"input\": " << jsonString( r.input ) << ",\n"
+            << "      \"engine\": " << jsonString( r.engine ) << ",\n"
+            << "      \"inputVertices\": " << r.inputVertices << ",\n"
+            << "      \"inputFaces\": " << r.inputFaces << ",\n"
+            << "      \"outputVertices\": " << r.outputVertices << ",\n"
+            << "      \"outputFaces\": " << r.outputFaces << ",\n"
+            << "      \"decimatedFaces\": " << r.decimatedFaces << ",\n"
+            << "      \"seconds\": {\n"
+            << "        \"load\": " << r.load << ",\n"
+            << "        \"build\": " << r.build << ",\n"
+            << "        \"iterations\": [";
+        for ( size_t i = 0; i < r.iterations.size(); ++i )
+        {
+            out << ( i == 0 ? "" : ", " ) << r.iterations[i];
+        }
+        out << "],\n"
+            << "        \"decimation\": " << r.decimation << ",\n"
+            << "        \"toTriangleMesh\": " << r.toTriangleMesh << ",\n"
+            << "        \"save\": " << r.save << "\n"
+            << "      },\n"
+            << "      \"facesPerSecond\": " << faces;
+        if ( peakRssPerCase ) { out << ",\n      \"peakRssBytes\": " << r.peakRss; }
+        out << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void printHelp( char* argv[] ) {
+    std::cout << "Usage :\n"
+              << argv[0]
+              << " [-o results.json] [-s type] [-n iteration] [-r repetitions] [-e engine] "
+                 "[-d ratio] [-g generated] [-j threads] [file.obj ...]\n\n"
+              << "results \t (default is subdivider-bench.json) JSON output file\n"
+              << "type \t\t (default is loop) subdivider type name : catmull, loop\n"
+              << "iteration \t (default is 2) number of subdivision iterations, each one is "
+                 "timed\n"
+              << "repetitions \t (default is 3) each stage reports its best time\n"
+              << "engine \t\t (default is all) openmesh, flat, direct (loop only) or all\n"
+              << "ratio \t\t (default is 0, no decimation) decimate the subdivided (loop) mesh to "
+                 "this fraction of its faces, each engine with its decimater\n"
+              << "generated \t (default is 1) 0 to skip the generated box, spheres and tori\n"
+              << "threads \t (default is all cores) number of threads used by the flat engine\n"
+              << "file.obj \t additional inputs\n";
+}
+
+bool processArgs( int argc, char* argv[], args& ret ) {
+    for ( int i = 1; i < argc; ++i )
+    {
+        const std::string arg( argv[i] );
+        if ( arg.size() != 2 || arg[0] != '-' )
+        {
+            ret.files.push_back( arg );
+            continue;
+        }
+        if ( i + 1 >= argc ) { return false; }
+        const std::string value( argv[++i] );
+        if ( arg == "-o" ) { ret.output = value; }
+        else if ( arg == "-s" )
+        {
+            if ( !Subdivision::schemeFromName( value, ret.scheme ) ) { return false; }
+        }
+        else if ( arg == "-n" )
+        { ret.iterations = std::max( 0, std::stoi( value ) ); }
+        else if ( arg == "-r" )
+        { ret.repetitions = std::max( 1, std::stoi( value ) ); }
+        else if ( arg == "-e" )
+        {
+            Subdivision::Engine engine;
+            if ( value == "all" ) { continue; }
+            if ( !Subdivision::engineFromName( value, engine ) ) { return false; }
+            ret.engines = {engine};
+        }
+        else if ( arg == "-d" )
+        { ret.decimation = std::min( 1., std::max( 0., std::stod( value ) ) ); }
+        else if ( arg == "-g" )
+        { ret.generated = value != "0"; }
+        else if ( arg == "-j" )
+        { Subdivision::setThreadCount( uint( std::stoi( value ) ) ); }
+        else
+        { return false; }
+    }
+    return true;
+}
+
+} // namespace
+
+int main( int argc, char* argv[] ) {
+    args a;
+    if ( !processArgs( argc, argv, a ) )
+    {
+        printHelp( argv );
+        return 1;
+    }
+
+    if ( a.decimation > 0 && a.scheme != Subdivision::Scheme::Loop )
+    {
+        LOG( logWARNING ) << "Decimation requires triangles, it is skipped for catmull.";
+        a.decimation = 0;
+    }
+
+    std::vector<Input> inputs;
+    if ( a.generated )
+    {
+        inputs.push_back( {"box", "", []() { return Geometry::makeBox(); }} );
+        inputs.push_back(
+            {"geodesic-sphere-3", "", []() { return Geometry::makeGeodesicSphere( 1, 3 ); }} );
+        inputs.push_back(
+            {"geodesic-sphere-5", "", []() { return Geometry::makeGeodesicSphere( 1, 5 ); }} );
+        inputs.push_back( {"sphere-64x32", "", []() {
+                               return Geometry::makeParametricSphere<64, 32>( 1 );
+                           }} );
+        inputs.push_back( {"sphere-256x128", "", []() {
+                               return Geometry::makeParametricSphere<256, 128>( 1 );
+                           }} );
+        inputs.push_back( {"torus-64x32", "", []() {
+                               return Geometry::makeParametricTorus<64, 32>( 1, Scalar( 0.3 ) );
+                           }} );
+        inputs.push_back( {"torus-256x128", "", []() {
+                               return Geometry::makeParametricTorus<256, 128>( 1, Scalar( 0.3 ) );
+                           }} );
+    }
+    for ( const auto& file : a.files )
+    {
+        inputs.push_back( {std::filesystem::path( file ).filename().string(), file, {}} );
+    }
+
+    // saved meshes are only written to be timed
+    const auto directory = std::filesystem::temp_directory_path() / "radium-subdivider-bench";
+    std::filesystem::create_directories( directory );
+    const std::string saveName = ( directory / "output" ).string();
+
+    std::vector<CaseResult> results;
+    bool success          = true;
+    bool peakRssPerCase   = true;
+    size_t processPeakRss = 0;
+    for ( const auto& input : inputs )
+    {
+        for ( Subdivision::Engine engine : a.engines )
+        {
+            if ( engine == Subdivision::Engine::Direct &&
+                 a.scheme != Subdivision::Scheme::Loop )
+            { continue; }
+            CaseResult result;
+            // without a reset, the peak would be the one of the largest case so far
+            processPeakRss = std::max( processPeakRss, Subdivision::peakResidentMemory() );
+            peakRssPerCase = Subdivision::resetPeakResidentMemory() && peakRssPerCase;
+            if ( !runCase( input, engine, a, saveName, result ) )
+            {
+                LOG( logERROR ) << "Benchmark of " << input.name << " failed.";
+                success = false;
+                continue;
+            }
+            LOG( logINFO ) << input.name << " (" << result.engine << "): " << result.outputFaces
+                           << " faces in " << result.subdivision() << "s.";
+            if ( result.decimatedFaces > 0 )
+            {
+                LOG( logINFO ) << input.name << " (" << result.engine << "): decimated to "
+                               << result.decimatedFaces << " faces in " << result.decimation
+                               << "s.";
+            }
+            results.push_back( result );
+        }
+    }
+    std::error_code error;
+    std::filesystem::remove_all( directory, error );
+
+    std::ofstream out( a.output );
+    if ( !out )
+    {
+        LOG( logERROR ) << "Cannot write " << a.output;
+        return 1;
+    }
+    processPeakRss = std::max( processPeakRss, Subdivision::peakResidentMemory() );
+    writeJson( out, a, results, peakRssPerCase, processPeakRss );
+    LOG( logINFO ) << "Results written to " << a.output;
+    return success ? 0 : 1;
+}
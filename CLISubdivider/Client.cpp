@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#    define SUBDIVISION_USE_SOCKETS
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+/// Thin client of the server mode of Radium-CLI-Subdivider (--serve), with the same options.
+/// The input file is read here and sent with the options, the output filename is made absolute,
+/// and the server, which keeps its allocations and workers warm, processes the job.
+/// It does not link Radium, so that it starts as fast as possible. See Server.hpp for the
+/// protocol.
+
+namespace {
+
+constexpr const char* DefaultSocket = "/tmp/radium-subdivider.sock";
+
+void printHelp( char* argv[] ) {
+    std::cout << "Usage :\n"
+              << argv[0] << " [--socket path] -i input.obj -o output -s type -n iteration [...]\n"
+              << argv[0] << " [--socket path] --stop\n\n"
+              << "path \t\t (default is $RADIUM_SUBDIVIDER_SOCKET, or " << DefaultSocket
+              << ") socket of a server started with Radium-CLI-Subdivider --serve path\n"
+              << "--stop \t\t stop the server once its running jobs are done\n"
+              << "The other options are the ones of Radium-CLI-Subdivider, for a single mesh.\n";
+}
+
+#ifdef SUBDIVISION_USE_SOCKETS
+
+bool writeAll( int fd, const char* data, size_t size ) {
+    for ( size_t done = 0; done < size; )
+    {
+        const ssize_t n = ::write( fd, data + done, size - done );
+        if ( n <= 0 ) { return false; }
+        done += size_t( n );
+    }
+    return true;
+}
+
+#endif
+
+} // namespace
+
+int main( int argc, char* argv[] ) {
+#ifdef SUBDIVISION_USE_SOCKETS
+    const char* environment = std::getenv( "RADIUM_SUBDIVIDER_SOCKET" );
+    std::string socketPath  = environment != nullptr ? environment : DefaultSocket;
+    std::string input;
+    bool stop = false;
+    std::vector<std::string> arguments;
+    for ( int i = 1; i < argc; ++i )
+    {
+        const std::string arg( argv[i] );
+        if ( arg == "--socket" && i + 1 < argc ) { socketPath = argv[++i]; }
+        else if ( arg == "--stop" )
+        { stop = true; }
+        else if ( arg == "-h" || arg == "--help" )
+        {
+            printHelp( argv );
+            return 0;
+        }
+        else if ( arg == "-i" && i + 1 < argc )
+        { input = argv[++i]; }
+        else if ( arg == "-o" && i + 1 < argc )
+        {
+            // the server may run in another directory
+            arguments.push_back( arg );
+            arguments.push_back( std::filesystem::absolute( argv[++i] ).string() );
+        }
+        else
+        { arguments.push_back( arg ); }
+    }
+    if ( !stop && arguments.empty() )
+    {
+        printHelp( argv );
+        return 1;
+    }
+
+    std::string request;
+    std::vector<char> mesh;
+    if ( stop ) { request = "QUIT\n"; }
+    else
+    {
+        if ( !input.empty() )
+        {
+            std::ifstream file( input, std::ios::binary );
+            if ( !file )
+            {
+                std::cerr << "Cannot open " << input << std::endl;
+                return 1;
+            }
+            mesh.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+        }
+        request = "JOB " + std::to_string( arguments.size() ) + " " +
+                  std::to_string( mesh.size() ) + "\n";
+        for ( const auto& a : arguments )
+        {
+            request += a + "\n";
+        }
+    }
+
+    sockaddr_un address{};
+    if ( socketPath.size() >= sizeof( address.sun_path ) )
+    {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return 1;
+    }
+    address.sun_family = AF_UNIX;
+    std::copy( socketPath.begin(), socketPath.end(), address.sun_path );
+    const int fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( fd < 0 ||
+         ::connect( fd, reinterpret_cast<const sockaddr*>( &address ), sizeof( address ) ) != 0 )
+    {
+        std::cerr << "Cannot connect to " << socketPath
+                  << ", start the server with Radium-CLI-Subdivider --serve " << socketPath
+                  << std::endl;
+        return 1;
+    }
+    if ( !writeAll( fd, request.data(), request.size() ) ||
+         !writeAll( fd, mesh.data(), mesh.size() ) )
+    {
+        std::cerr << "Cannot send the request." << std::endl;
+        ::close( fd );
+        return 1;
+    }
+    ::shutdown( fd, SHUT_WR );
+
+    std::string response;
+    char buffer[256];
+    for ( ssize_t n; ( n = ::read( fd, buffer, sizeof( buffer ) ) ) > 0; )
+    {
+        response.append( buffer, size_t( n ) );
+    }
+    ::close( fd );
+    if ( response.compare( 0, 3, "OK " ) != 0 )
+    {
+        std::cerr << ( response.empty() ? "No response from the server.\n" : response );
+        return 1;
+    }
+    if ( !stop )
+    {
+        size_t vertices = 0, faces = 0;
+        double seconds  = 0;
+        std::istringstream( response.substr( 3 ) ) >> vertices >> faces >> seconds;
+        std::cout << "Done in " << seconds << "s: " << vertices << " vertices, " << faces
+                  << " faces." << std::endl;
+    }
+    return 0;
+#else
+    printHelp( argv );
+    std::cerr << "The client is only available on Unix-like systems." << std::endl;
+    return 1;
+#endif
+}
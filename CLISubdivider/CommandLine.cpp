@@ -0,0 +1,252 @@
+#include "CommandLine.hpp"
+
+#include <cctype>
+#include <iostream>
+
+namespace Subdivision {
+
+void printHelp( const std::string& program ) {
+    std::cout << "Usage :\n"
+              << program << " -i input.obj -o output -s type -n iteration [-e engine] [-l loader] [-f format] [-j threads] [-t budget [-c angle] [-d length]] [-p patch] [-q quads] [--limit] [--attributes] [--lod [pack]] [--vcache [size]] [--weld [epsilon]] [--manifold mode] [--no-arena] [--profile [report.json]]\n"
+              << program << " -i input.obj -o output -r faces|-x error [-e engine] [-l loader] [-f format] [-j threads] [--weld [epsilon]] [--manifold mode]\n"
+              << program << " -b manifest|directory [-o outputDirectory] -s type -n iteration [-w workers] [-m memory] [...]\n"
+              << program << " -a sequence [-i rest.obj] -o output -s type -n iteration [...]\n"
+              << program << " --serve socket|- [-w workers] [-j threads]\n\n"
+              << " the format extension (.obj, .ply, .rbm) is added automatically to output filename\n"
+              << "input\t\t the name (with .obj extension) of the file to load, if no input is "
+                 "given, a simple cube is used\n"
+              << "type \t\t is a string for the subdivider type name : catmull, loop\n"
+              << "iteration \t (default is 1) is a positive integer to specify the number of "
+                 "iteration of subdivision\n"
+              << "engine \t\t (default is openmesh) subdivision implementation : openmesh, flat "
+                 "(multithreaded, index based), direct (loop only, in place on the mesh arrays)\n"
+              << "loader \t\t (default is radium) obj reader : radium, mmap (memory-mapped, "
+                 "multithreaded)\n"
+              << "format \t\t (default is obj) output format : obj, ply (binary little-endian), "
+                 "rbm (raw binary mesh, see README)\n"
+              << "threads \t (default is all cores) number of threads used by the flat engine\n"
+              << "budget \t\t adaptive loop subdivision: maximum number of output triangles, "
+                 "iteration is then the maximum depth\n"
+              << "angle \t\t (default is 10) adaptive subdivision: edges with a larger dihedral "
+                 "angle (degrees) are refined, 0 to disable\n"
+              << "length \t\t (default is 0, disabled) adaptive subdivision: edges longer than "
+                 "length are refined\n"
+              << "patch \t\t out-of-core tiled subdivision: number of input faces per patch, "
+                 "patches are refined in parallel and streamed to a ply or rbm file\n"
+              << "quads \t\t (default is 0) 1 to save the catmull quads instead of triangulating "
+                 "them (flat engine)\n"
+              << "--limit \t project the vertices onto the limit surface and use the limit "
+                 "normals (flat engine)\n"
+              << "--attributes \t subdivide all the vertex attributes, texture coordinates "
+                 "(read by the mmap loader) across their seams as face-varying data\n"
+              << "--lod \t\t save every level from 0 to iteration, to output_lod0, output_lod1, "
+                 "... or, with pack, to a single rbm file holding one record per level\n"
+              << "--vcache \t reorder the output triangles and vertices for a vertex cache of "
+                 "size entries (default is 16), and print the ACMR and ATVR before and after\n"
+              << "--weld \t merge the vertices closer than epsilon (default is 0, identical "
+                 "positions) after loading, to connect faces that have their own vertices\n"
+              << "mode \t\t (default is check with the openmesh engine, off otherwise) manifold "
+                 "check before the topology is built: off, check (reject degenerate or duplicate "
+                 "faces, non-manifold edges and vertices), repair (drop the faces, split the "
+                 "vertices)\n"
+              << "--no-arena \t allocate the buffers of the manifold check and of the refinement "
+                 "with malloc instead of a per-job arena released in one step\n"
+              << "faces \t\t decimation: target number of faces, with quadric error metrics "
+                 "(openmesh: OpenMesh decimater, flat: parallel collapses)\n"
+              << "error \t\t decimation: maximum quadric error of a collapse (sum of squared "
+                 "distances to the planes of the merged faces)\n"
+              << "--profile \t print the wall and CPU time, peak memory, allocations and malloc "
+                 "calls of each phase, and write them to report.json if given\n"
+              << "manifest \t batch mode: text file listing one job per line: input output "
+                 "[type] [iteration]\n"
+              << "directory \t batch mode: all the .obj files of the directory are processed, "
+                 "results are written in outputDirectory\n"
+              << "workers \t (default is all cores) number of meshes processed concurrently\n"
+              << "memory \t\t (default is unlimited) estimated memory budget of the concurrent "
+                 "jobs, in MB\n"
+              << "sequence \t animation with a fixed topology, refined with precomputed stencils: "
+                 "text file listing one .obj frame per line, or .pos stream (float32 xyz per "
+                 "vertex and per frame) of the rest mesh given by -i. Frame i is saved to "
+                 "output_i\n"
+              << "socket \t\t server mode: jobs are received on this Unix domain socket, or on "
+                 "the standard input with -, and processed by warm workers. The client sends the "
+                 "options of a single mesh job and the input file\n\n";
+    /// \FIXME Use Radium::IO to load and save meshes.
+    std::cout
+        << "Warning: The Subdivide application does not use Radium::IO for loading/saving "
+        << "files. Input *.obj files must list only vertex position (v) and vertex normal (vn), "
+        << "and the face list (with --attributes, the mmap loader also reads texture coordinates "
+        << "(vt)).\n"
+        << "Other features of the OBJ file format are not supported and might lead to "
+        << "unexpected behaviors." << std::endl;
+}
+
+Arguments parseArguments( const std::vector<std::string>& argv ) {
+    const int argc = int( argv.size() );
+    Arguments ret;
+    bool outputFilenameSet{false};
+    bool subdividerSet{false};
+
+    for ( int i = 1; i < argc; i += 2 )
+    {
+        if ( std::string( argv[i] ) == std::string( "-i" ) )
+        {
+            if ( i + 1 < argc ) { ret.inputFilename = argv[i + 1]; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-o" ) )
+        {
+            if ( i + 1 < argc )
+            {
+                ret.outputFilename = argv[i + 1];
+                outputFilenameSet  = true;
+            }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-s" ) )
+        {
+            if ( i + 1 < argc )
+            {
+                std::string a{argv[i + 1]};
+                subdividerSet = schemeFromName( a, ret.settings.scheme );
+            }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-e" ) )
+        {
+            if ( i + 1 < argc )
+            { engineFromName( std::string( argv[i + 1] ), ret.settings.engine ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-l" ) )
+        {
+            if ( i + 1 < argc ) { ret.settings.parallelLoader = std::string( argv[i + 1] ) == "mmap"; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-f" ) )
+        {
+            if ( i + 1 < argc )
+            { outputFormatFromName( std::string( argv[i + 1] ), ret.settings.format ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-j" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.threads = uint( std::stoi( std::string( argv[i + 1] ) ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-n" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.settings.iterations = std::stoi( std::string( argv[i + 1] ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-t" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.settings.triangleBudget = size_t( std::stoull( std::string( argv[i + 1] ) ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-c" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.settings.curvatureAngle = Scalar( std::stod( std::string( argv[i + 1] ) ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-d" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.settings.edgeLength = Scalar( std::stod( std::string( argv[i + 1] ) ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-p" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.settings.patchFaces = size_t( std::stoull( std::string( argv[i + 1] ) ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-q" ) )
+        {
+            if ( i + 1 < argc ) { ret.settings.quadOutput = std::string( argv[i + 1] ) != "0"; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-r" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.settings.decimateFaces = size_t( std::stoull( std::string( argv[i + 1] ) ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-x" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.settings.decimateError = Scalar( std::stod( std::string( argv[i + 1] ) ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-b" ) )
+        {
+            if ( i + 1 < argc ) { ret.batch = argv[i + 1]; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-w" ) )
+        {
+            if ( i + 1 < argc ) { ret.workers = uint( std::stoi( std::string( argv[i + 1] ) ) ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "--profile" ) )
+        {
+            ret.profile = true;
+            // the report filename is optional
+            if ( i + 1 < argc && argv[i + 1][0] != '-' ) { ret.profileFilename = argv[i + 1]; }
+            else
+            { --i; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "--limit" ) )
+        {
+            ret.settings.limitSurface = true;
+            --i; // no value
+        }
+        else if ( std::string( argv[i] ) == std::string( "--lod" ) )
+        {
+            ret.settings.lodChain = true;
+            // the container is optional
+            if ( i + 1 < argc && std::string( argv[i + 1] ) == "pack" )
+            { ret.settings.lodContainer = true; }
+            else
+            { --i; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "--vcache" ) )
+        {
+            ret.settings.vertexCache = 16;
+            // the cache size is optional
+            if ( i + 1 < argc && std::isdigit( argv[i + 1][0] ) )
+            { ret.settings.vertexCache = uint( std::stoi( std::string( argv[i + 1] ) ) ); }
+            else
+            { --i; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "--weld" ) )
+        {
+            ret.settings.weld = true;
+            // the epsilon is optional
+            if ( i + 1 < argc && ( std::isdigit( argv[i + 1][0] ) || argv[i + 1][0] == '.' ) )
+            { ret.settings.weldEpsilon = Scalar( std::stod( std::string( argv[i + 1] ) ) ); }
+            else
+            { --i; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "--manifold" ) )
+        {
+            if ( i + 1 < argc )
+            { manifoldCheckFromName( std::string( argv[i + 1] ), ret.settings.manifold ); }
+        }
+        else if ( std::string( argv[i] ) == std::string( "--no-arena" ) )
+        {
+            ret.settings.arena = false;
+            --i; // no value
+        }
+        else if ( std::string( argv[i] ) == std::string( "--attributes" ) )
+        {
+            ret.settings.attributes = true;
+            --i; // no value
+        }
+        else if ( std::string( argv[i] ) == std::string( "--serve" ) )
+        {
+            if ( i + 1 < argc ) { ret.serve = argv[i + 1]; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-a" ) )
+        {
+            if ( i + 1 < argc ) { ret.sequence = argv[i + 1]; }
+        }
+        else if ( std::string( argv[i] ) == std::string( "-m" ) )
+        {
+            if ( i + 1 < argc )
+            { ret.memoryBudget = size_t( std::stoull( std::string( argv[i + 1] ) ) ) << 20; }
+        }
+    }
+    ret.valid = !ret.serve.empty() || ( ( outputFilenameSet || !ret.batch.empty() ) &&
+                                        ( subdividerSet || ret.settings.decimation() ) );
+    return ret;
+}
+
+} // namespace Subdivision
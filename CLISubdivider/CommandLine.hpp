@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Pipeline.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// Options of the command line, also forwarded by the client to the server.
+struct Arguments {
+    bool valid{false};
+    std::string outputFilename;
+    std::string inputFilename;
+    Settings settings;
+    /// Manifest file or directory processed in batch mode, empty otherwise
+    std::string batch;
+    unsigned int workers{0};
+    size_t memoryBudget{0};
+    /// Animated sequence (frame list or .pos stream), empty otherwise
+    std::string sequence;
+    bool profile{false};
+    /// Machine-readable (JSON) profiling report, empty for the table only
+    std::string profileFilename;
+    /// Threads of the flat engine and parallel loader (0: all cores)
+    unsigned int threads{0};
+    /// Socket of the server mode ("-" for the standard input and output), empty otherwise
+    std::string serve;
+};
+
+/// Print the usage of the application, run as \p program.
+void printHelp( const std::string& program );
+
+/// Parse the command line \p argv, argv[0] being the program.
+/// Arguments::valid is false if the output or the operation is missing.
+Arguments parseArguments( const std::vector<std::string>& argv );
+
+} // namespace Subdivision
@@ -0,0 +1,417 @@
+#include "Decimator.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+namespace {
+
+/// Key of the edges that cannot collapse
+constexpr uint64_t NoCandidate = std::numeric_limits<uint64_t>::max();
+/// Weight of the planes holding the boundary edges, relative to the face planes
+constexpr double BoundaryWeight = 100;
+/// Maximum number of independent sets merged in a round
+constexpr char SelectionPasses = 4;
+/// Smallest cosine between the normals of a face before and after a collapse
+constexpr Scalar MinNormalCosine = Scalar( 0.2 );
+
+/// Unique sort key of edge \p e: its cost (the bits of a non negative float are ordered like its
+/// value) then its index.
+inline uint64_t edgeKey( double cost, uint e ) {
+    const float c =
+        float( std::min( std::max( cost, 0. ), double( std::numeric_limits<float>::max() ) ) );
+    uint32_t bits;
+    std::memcpy( &bits, &c, sizeof( bits ) );
+    return ( uint64_t( bits ) << 32 ) | e;
+}
+
+/// Sorted neighbours of \p v.
+void gatherNeighbours( const FlatMesh& mesh,
+                       const Connectivity& c,
+                       uint v,
+                       std::vector<uint>& neighbours ) {
+    neighbours.clear();
+    for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+    {
+        const uint f = c.vertexFaces[j];
+        for ( uint i = 0; i < 3; ++i )
+        {
+            const uint w = mesh.faceIndices[3 * f + i];
+            if ( w != v ) { neighbours.push_back( w ); }
+        }
+    }
+    std::sort( neighbours.begin(), neighbours.end() );
+    neighbours.erase( std::unique( neighbours.begin(), neighbours.end() ), neighbours.end() );
+}
+
+size_t countCommon( const std::vector<uint>& a, const std::vector<uint>& b ) {
+    size_t n = 0;
+    for ( auto i = a.begin(), j = b.begin(); i != a.end() && j != b.end(); )
+    {
+        if ( *i < *j ) { ++i; }
+        else if ( *j < *i )
+        { ++j; }
+        else
+        {
+            ++n;
+            ++i;
+            ++j;
+        }
+    }
+    return n;
+}
+
+/// Position minimizing \p q for the collapse of ( \p a, \p b ), and its error.
+/// Falls back to the best of the end points and the midpoint when the quadric is singular or its
+/// minimum is far from the edge.
+double optimalPosition( const Decimator::Quadric& q,
+                        const Vector3& a,
+                        const Vector3& b,
+                        Vector3& position ) {
+    const double* m = q.q;
+    Eigen::Matrix3d A;
+    A << m[0], m[1], m[2], m[1], m[4], m[5], m[2], m[5], m[7];
+    const double scale  = A.trace() / 3;
+    const Vector3 mid   = Scalar( 0.5 ) * ( a + b );
+    const Scalar length = ( b - a ).norm();
+    if ( scale > 0 && std::abs( A.determinant() ) > 1e-9 * scale * scale * scale )
+    {
+        const Eigen::Vector3d x = A.inverse() * Eigen::Vector3d( -m[3], -m[6], -m[8] );
+        position                = x.cast<Scalar>();
+        if ( ( position - mid ).norm() <= 2 * length ) { return q.error( position ); }
+    }
+    position    = mid;
+    double best = q.error( mid );
+    for ( const Vector3* p : {&a, &b} )
+    {
+        const double e = q.error( *p );
+        if ( e < best )
+        {
+            best     = e;
+            position = *p;
+        }
+    }
+    return best;
+}
+
+/// Pseudo-random priority of edge \p e in round \p round, unique per edge: the independent sets
+/// of a smooth cost field would be sparse (few local minima), random ones are dense.
+inline uint64_t edgePriority( uint e, size_t round ) {
+    uint32_t h = e ^ uint32_t( round * 0x9e3779b9u );
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return ( uint64_t( h ) << 32 ) | e;
+}
+
+inline void atomicMin( std::atomic<uint64_t>& value, uint64_t v ) {
+    uint64_t current = value.load( std::memory_order_relaxed );
+    while ( v < current && !value.compare_exchange_weak( current, v, std::memory_order_relaxed ) )
+    {}
+}
+
+} // namespace
+
+void Decimator::Quadric::addPlane( const Vector3& n, Scalar d, double w ) {
+    const double x = n.x(), y = n.y(), z = n.z(), t = d;
+    q[0] += w * x * x;
+    q[1] += w * x * y;
+    q[2] += w * x * z;
+    q[3] += w * x * t;
+    q[4] += w * y * y;
+    q[5] += w * y * z;
+    q[6] += w * y * t;
+    q[7] += w * z * z;
+    q[8] += w * z * t;
+    q[9] += w * t * t;
+}
+
+Decimator::Quadric& Decimator::Quadric::operator+=( const Quadric& other ) {
+    for ( int i = 0; i < 10; ++i )
+    {
+        q[i] += other.q[i];
+    }
+    return *this;
+}
+
+double Decimator::Quadric::error( const Vector3& p ) const {
+    const double x = p.x(), y = p.y(), z = p.z();
+    return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x + q[4] * y * y +
+           2 * q[5] * y * z + 2 * q[6] * y + q[7] * z * z + 2 * q[8] * z + q[9];
+}
+
+void Decimator::initQuadrics( const FlatMesh& mesh, const Connectivity& c ) {
+    m_quadrics.assign( mesh.nVertices(), Quadric() );
+    parallelFor( 0, mesh.nVertices(), [&]( size_t v ) {
+        Quadric& q = m_quadrics[v];
+        for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+        {
+            const uint f     = c.vertexFaces[j];
+            const uint* face = mesh.faceIndices.data() + 3 * f;
+            const uint i     = face[0] == v ? 0 : face[1] == v ? 1 : 2;
+            const Vector3& p = mesh.positions[v];
+            Vector3 n        = ( mesh.positions[face[1]] - mesh.positions[face[0]] )
+                            .cross( mesh.positions[face[2]] - mesh.positions[face[0]] );
+            if ( n.norm() == 0 ) { continue; }
+            n.normalize();
+            q.addPlane( n, -n.dot( p ) );
+            // planes orthogonal to the face through its boundary edges
+            for ( uint k : {i, ( i + 2 ) % 3} )
+            {
+                if ( !c.edges[c.cornerEdges[3 * f + k]].isBoundary() ) { continue; }
+                const uint other = face[k == i ? ( i + 1 ) % 3 : k];
+                Vector3 m        = ( mesh.positions[other] - p ).cross( n );
+                if ( m.norm() == 0 ) { continue; }
+                m.normalize();
+                q.addPlane( m, -m.dot( p ), BoundaryWeight );
+            }
+        }
+    } );
+}
+
+bool Decimator::operator()( FlatMesh& mesh ) {
+    m_rounds = 0;
+    if ( !mesh.isUniform( 3 ) ) { return false; }
+    Connectivity c;
+    c.build( mesh );
+    initQuadrics( mesh, c );
+
+    std::vector<uint64_t> keys, candidates;
+    Vector3Array targets;
+    std::vector<char> boundary;
+    std::vector<std::atomic<uint64_t>> claims( mesh.nVertices() );
+    std::vector<std::atomic<char>> locked( mesh.nVertices() );
+    std::vector<char> selected;
+    std::vector<uint> remap, vertexOffsets, faceOffsets;
+    FlatMesh compact;
+    std::vector<Quadric> quadrics;
+    while ( m_targetFaces == 0 || mesh.nFaces() > m_targetFaces )
+    {
+        if ( m_rounds > 0 ) { c.build( mesh ); }
+        const size_t nv = mesh.nVertices();
+        const size_t ne = c.nEdges();
+        const size_t nf = mesh.nFaces();
+
+        boundary.assign( nv, 0 );
+        parallelFor( 0, nv, [&]( size_t v ) {
+            for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+            {
+                const uint f = c.vertexFaces[j];
+                for ( uint i = 0; i < 3; ++i )
+                {
+                    if ( mesh.faceIndices[3 * f + i] != v ) { continue; }
+                    boundary[v] = boundary[v] || c.edges[c.cornerEdges[3 * f + i]].isBoundary() ||
+                                  c.edges[c.cornerEdges[3 * f + ( i + 2 ) % 3]].isBoundary();
+                }
+            }
+        } );
+
+        // cost and target position of every valid collapse
+        keys.resize( ne );
+        targets.resize( ne );
+        parallelForRange(
+            0,
+            ne,
+            [&]( size_t first, size_t last ) {
+                std::vector<uint> na, nb;
+                for ( size_t e = first; e < last; ++e )
+                {
+                    keys[e]                     = NoCandidate;
+                    const Connectivity::Edge& edge = c.edges[e];
+                    const uint a                   = edge.v0;
+                    const uint b                   = edge.v1;
+                    if ( !edge.isManifold() ) { continue; }
+                    // a collapse between two boundaries would pinch the surface
+                    if ( boundary[a] && boundary[b] && !edge.isBoundary() ) { continue; }
+                    gatherNeighbours( mesh, c, a, na );
+                    gatherNeighbours( mesh, c, b, nb );
+                    // two valence 3 vertices: the collapse of a tetrahedron
+                    if ( !edge.isBoundary() && na.size() <= 3 && nb.size() <= 3 ) { continue; }
+                    // the opposite corners lose a face, interior ones must keep three
+                    bool degenerate = false;
+                    for ( uint f : {edge.f0, edge.f1} )
+                    {
+                        if ( f == Connectivity::Invalid ) { continue; }
+                        const uint* face = mesh.faceIndices.data() + 3 * f;
+                        const uint o     = face[0] != a && face[0] != b
+                                           ? face[0]
+                                           : face[1] != a && face[1] != b ? face[1] : face[2];
+                        const uint faces = c.vertexFaceOffsets[o + 1] - c.vertexFaceOffsets[o];
+                        degenerate       = degenerate || ( !boundary[o] && faces <= 3 );
+                    }
+                    if ( degenerate ) { continue; }
+                    // link condition: the only common neighbours are the opposite corners
+                    if ( countCommon( na, nb ) != edge.nFaces ) { continue; }
+
+                    Quadric q = m_quadrics[a];
+                    q += m_quadrics[b];
+                    Vector3 p;
+                    const double cost =
+                        optimalPosition( q, mesh.positions[a], mesh.positions[b], p );
+                    if ( m_maxError > 0 && cost > m_maxError ) { continue; }
+
+                    // no face may flip
+                    bool flip = false;
+                    for ( uint v : {a, b} )
+                    {
+                        for ( uint j = c.vertexFaceOffsets[v];
+                              j < c.vertexFaceOffsets[v + 1] && !flip;
+                              ++j )
+                        {
+                            const uint* face = mesh.faceIndices.data() + 3 * c.vertexFaces[j];
+                            Vector3 before[3], after[3];
+                            int moved = 0;
+                            for ( uint i = 0; i < 3; ++i )
+                            {
+                                before[i] = after[i] = mesh.positions[face[i]];
+                                if ( face[i] == a || face[i] == b )
+                                {
+                                    after[i] = p;
+                                    ++moved;
+                                }
+                            }
+                            if ( moved == 2 ) { continue; } // removed by the collapse
+                            const Vector3 n0 =
+                                ( before[1] - before[0] ).cross( before[2] - before[0] );
+                            const Vector3 n1 = ( after[1] - after[0] ).cross( after[2] - after[0] );
+                            flip = n1.dot( n0 ) <= MinNormalCosine * n1.norm() * n0.norm();
+                        }
+                    }
+                    if ( flip ) { continue; }
+                    targets[e] = p;
+                    keys[e]    = edgeKey( cost, uint( e ) );
+                }
+            },
+            256 );
+
+        // the cheapest quarter of the candidates, no more than needed to reach the target
+        candidates.clear();
+        std::copy_if( keys.begin(), keys.end(), std::back_inserter( candidates ), []( uint64_t k ) {
+            return k != NoCandidate;
+        } );
+        if ( candidates.empty() ) { break; }
+        size_t k = ( candidates.size() + 3 ) / 4;
+        if ( m_targetFaces > 0 )
+        { k = std::min( k, std::max<size_t>( 1, ( nf - m_targetFaces + 1 ) / 2 ) ); }
+        std::nth_element( candidates.begin(), candidates.begin() + ( k - 1 ), candidates.end() );
+        const uint64_t threshold = candidates[k - 1];
+
+        // independent set: each vertex is claimed by the candidate of highest priority among the
+        // edges whose faces contain it. An edge is selected if it holds both its end points, then
+        // no other selected edge has an end point on its faces (the relation is symmetric).
+        // Further passes select among the candidates whose end points are still free.
+        auto forEachRegionVertex = [&]( const Connectivity::Edge& edge, auto&& f ) {
+            for ( uint v : {edge.v0, edge.v1} )
+            {
+                for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+                {
+                    const uint* face = mesh.faceIndices.data() + 3 * c.vertexFaces[j];
+                    f( face[0] );
+                    f( face[1] );
+                    f( face[2] );
+                }
+            }
+        };
+        auto isFree = [&]( size_t e ) {
+            return keys[e] <= threshold && selected[e] == 0 &&
+                   locked[c.edges[e].v0].load( std::memory_order_relaxed ) == 0 &&
+                   locked[c.edges[e].v1].load( std::memory_order_relaxed ) == 0;
+        };
+        selected.assign( ne, 0 );
+        parallelFor( 0, nv, [&]( size_t v ) { locked[v].store( 0, std::memory_order_relaxed ); } );
+        size_t nCollapses = 0;
+        for ( char pass = 1; pass <= SelectionPasses; ++pass )
+        {
+            parallelFor( 0, nv, [&]( size_t v ) {
+                claims[v].store( NoCandidate, std::memory_order_relaxed );
+            } );
+            parallelFor( 0, ne, [&]( size_t e ) {
+                if ( !isFree( e ) ) { return; }
+                const uint64_t priority = edgePriority( uint( e ), m_rounds );
+                forEachRegionVertex( c.edges[e],
+                                     [&]( uint w ) { atomicMin( claims[w], priority ); } );
+            } );
+            std::atomic<size_t> nSelected{0};
+            parallelFor( 0, ne, [&]( size_t e ) {
+                if ( !isFree( e ) ) { return; }
+                const uint64_t priority = edgePriority( uint( e ), m_rounds );
+                if ( claims[c.edges[e].v0].load( std::memory_order_relaxed ) == priority &&
+                     claims[c.edges[e].v1].load( std::memory_order_relaxed ) == priority )
+                {
+                    selected[e] = pass;
+                    nSelected.fetch_add( 1, std::memory_order_relaxed );
+                }
+            } );
+            if ( nSelected == 0 ) { break; }
+            nCollapses += nSelected;
+            parallelFor( 0, ne, [&]( size_t e ) {
+                if ( selected[e] != pass ) { return; }
+                forEachRegionVertex( c.edges[e], [&]( uint w ) {
+                    locked[w].store( 1, std::memory_order_relaxed );
+                } );
+            } );
+        }
+
+        // collapse the selected edges, the kept vertex is v0
+        remap.resize( nv );
+        parallelFor( 0, nv, [&]( size_t v ) { remap[v] = uint( v ); } );
+        parallelFor( 0, ne, [&]( size_t e ) {
+            if ( selected[e] == 0 ) { return; }
+            const uint a      = c.edges[e].v0;
+            const uint b      = c.edges[e].v1;
+            remap[b]          = a;
+            mesh.positions[a] = targets[e];
+            m_quadrics[a] += m_quadrics[b];
+        } );
+        ++m_rounds;
+        if ( nCollapses == 0 ) { break; }
+
+        // compaction: removed vertices and degenerate faces
+        vertexOffsets.resize( nv + 1 );
+        parallelFor( 0, nv, [&]( size_t v ) { vertexOffsets[v] = remap[v] == v ? 1 : 0; } );
+        vertexOffsets[nv] = 0;
+        const uint nVertices = exclusiveScan( vertexOffsets );
+        faceOffsets.resize( nf + 1 );
+        parallelFor( 0, nf, [&]( size_t f ) {
+            const uint* face = mesh.faceIndices.data() + 3 * f;
+            const uint a = remap[face[0]], b = remap[face[1]], d = remap[face[2]];
+            faceOffsets[f]   = a != b && b != d && d != a ? 1 : 0;
+        } );
+        faceOffsets[nf]     = 0;
+        const uint nFaces   = exclusiveScan( faceOffsets );
+
+        compact.positions.resize( nVertices );
+        quadrics.resize( nVertices );
+        parallelFor( 0, nv, [&]( size_t v ) {
+            if ( remap[v] != v ) { return; }
+            compact.positions[vertexOffsets[v]] = mesh.positions[v];
+            quadrics[vertexOffsets[v]]          = m_quadrics[v];
+        } );
+        compact.faceOffsets.resize( nFaces + 1 );
+        compact.faceIndices.resize( 3 * size_t( nFaces ) );
+        parallelFor( 0, nf, [&]( size_t f ) {
+            if ( faceOffsets[f] == faceOffsets[f + 1] ) { return; }
+            const uint out                = faceOffsets[f];
+            compact.faceOffsets[out + 1] = 3 * ( out + 1 );
+            for ( uint i = 0; i < 3; ++i )
+            {
+                compact.faceIndices[3 * out + i] =
+                    vertexOffsets[remap[mesh.faceIndices[3 * f + i]]];
+            }
+        } );
+        compact.faceOffsets[0] = 0;
+        std::swap( mesh, compact );
+        std::swap( m_quadrics, quadrics );
+    }
+    return true;
+}
+
+} // namespace Subdivision
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "FlatMesh.hpp"
+
+#include <Core/Types.hpp>
+
+#include <vector>
+
+namespace Subdivision {
+
+/// Parallel quadric error metric (Garland and Heckbert) decimation of a triangle FlatMesh.
+///
+/// Edge collapses are processed by rounds instead of one at a time from a priority queue.
+/// In each round, the cost and optimal position of every edge are computed in parallel from the
+/// vertex quadrics, and an independent set is selected among the cheapest quarter of the valid
+/// edges: each vertex is claimed (atomic minimum) by the edge of highest pseudo-random priority
+/// whose faces contain it, and an edge holding both its end points collapses. A few such passes
+/// are merged, each one among the edges away from the already selected ones. The selected
+/// collapses touch disjoint regions, so they are applied concurrently without locks, after which
+/// the mesh is compacted and the next round starts.
+///
+/// A collapse is rejected if it breaks the link condition, pinches the boundary, leaves a vertex
+/// with less than three faces, or flips a face. Boundary edges get a constraint quadric, so that
+/// the boundary is preserved.
+class Decimator
+{
+  public:
+    /// Decimate down to \p targetFaces faces (0 for no target), without collapsing edges of
+    /// quadric error larger than \p maxError (sum of the squared distances to the planes of the
+    /// merged faces, 0 for no bound).
+    Decimator( size_t targetFaces, Scalar maxError ) :
+        m_targetFaces( targetFaces ), m_maxError( maxError ) {}
+
+    /// Decimate \p mesh in place. Returns false if the faces are not all triangles.
+    bool operator()( FlatMesh& mesh );
+
+    /// Number of collapse rounds of the last run.
+    inline size_t rounds() const { return m_rounds; }
+
+    /// Quadric of a vertex: symmetric 4x4 matrix, upper triangle stored row by row.
+    struct Quadric {
+        double q[10]{};
+
+        void addPlane( const Ra::Core::Vector3& normal, Scalar d, double weight = 1 );
+        Quadric& operator+=( const Quadric& other );
+        double error( const Ra::Core::Vector3& p ) const;
+    };
+
+  private:
+    /// Vertex quadrics of the input mesh, with the boundary constraints.
+    void initQuadrics( const FlatMesh& mesh, const Connectivity& c );
+
+    size_t m_targetFaces;
+    Scalar m_maxError;
+    size_t m_rounds{0};
+    std::vector<Quadric> m_quadrics;
+};
+
+} // namespace Subdivision
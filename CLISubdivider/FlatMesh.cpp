@@ -0,0 +1,225 @@
+#include "FlatMesh.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+bool FlatMesh::isUniform( uint n ) const {
+    for ( size_t f = 0; f < nFaces(); ++f )
+    {
+        if ( faceSize( f ) != n ) { return false; }
+    }
+    return true;
+}
+
+FlatMesh FlatMesh::fromTriangleMesh( const Geometry::TriangleMesh& mesh ) {
+    FlatMesh ret;
+    ret.assign( mesh );
+    return ret;
+}
+
+void FlatMesh::assign( const Geometry::TriangleMesh& mesh ) {
+    positions.assign( mesh.vertices().begin(), mesh.vertices().end() );
+
+    const auto& tris = mesh.getIndices();
+    faceOffsets.resize( tris.size() + 1 );
+    faceIndices.resize( 3 * tris.size() );
+    parallelFor( 0, tris.size(), [&]( size_t t ) {
+        faceOffsets[t] = uint( 3 * t );
+        for ( int i = 0; i < 3; ++i )
+        {
+            faceIndices[3 * t + i] = tris[t]( i );
+        }
+    } );
+    faceOffsets.back() = uint( 3 * tris.size() );
+}
+
+Vector3Array FlatMesh::vertexNormals() const {
+    Vector3Array faceNormals( nFaces() );
+    parallelFor( 0, nFaces(), [&]( size_t f ) {
+        const uint o      = faceOffsets[f];
+        const Vector3& p0 = positions[faceIndices[o]];
+        Vector3 n         = Vector3::Zero();
+        for ( uint i = 1; i + 1 < faceSize( f ); ++i )
+        {
+            n += ( positions[faceIndices[o + i]] - p0 )
+                     .cross( positions[faceIndices[o + i + 1]] - p0 );
+        }
+        faceNormals[f] = n;
+    } );
+
+    ArenaVector<uint> vfOffsets, vfFaces;
+    Connectivity::buildVertexFaces( *this, vfOffsets, vfFaces );
+    Vector3Array normals( nVertices() );
+    parallelFor( 0, nVertices(), [&]( size_t v ) {
+        Vector3 n = Vector3::Zero();
+        for ( uint j = vfOffsets[v]; j < vfOffsets[v + 1]; ++j )
+        {
+            n += faceNormals[vfFaces[j]];
+        }
+        normals[v] = n.normalized();
+    } );
+    return normals;
+}
+
+Geometry::TriangleMesh FlatMesh::toTriangleMesh() const {
+    Geometry::TriangleMesh mesh;
+
+    // a face of size k gives k-2 triangles
+    const size_t nTris = faceIndices.size() - 2 * nFaces();
+    Geometry::TriangleMesh::IndexContainerType tris( nTris );
+    parallelFor( 0, nFaces(), [&]( size_t f ) {
+        const uint o    = faceOffsets[f];
+        const size_t t0 = o - 2 * f;
+        for ( uint i = 1; i + 1 < faceSize( f ); ++i )
+        {
+            tris[t0 + i - 1] =
+                Vector3ui( faceIndices[o], faceIndices[o + i], faceIndices[o + i + 1] );
+        }
+    } );
+
+    mesh.setVertices( positions );
+    mesh.setNormals( vertexNormals() );
+    mesh.setIndices( std::move( tris ) );
+    return mesh;
+}
+
+void Connectivity::buildVertexFaces( const FlatMesh& mesh,
+                                     ArenaVector<uint>& offsets,
+                                     ArenaVector<uint>& faces ) {
+    const size_t nv = mesh.nVertices();
+    const size_t nf = mesh.nFaces();
+
+    std::vector<std::atomic<uint>> counts( nv );
+    parallelFor( 0, nv, [&]( size_t v ) { counts[v].store( 0, std::memory_order_relaxed ); } );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        for ( uint c = mesh.faceOffsets[f]; c < mesh.faceOffsets[f + 1]; ++c )
+        {
+            counts[mesh.faceIndices[c]].fetch_add( 1, std::memory_order_relaxed );
+        }
+    } );
+
+    offsets.resize( nv + 1 );
+    uint sum = 0;
+    for ( size_t v = 0; v < nv; ++v )
+    {
+        offsets[v] = sum;
+        sum += counts[v].load( std::memory_order_relaxed );
+        counts[v].store( offsets[v], std::memory_order_relaxed );
+    }
+    offsets[nv] = sum;
+
+    faces.resize( sum );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        for ( uint c = mesh.faceOffsets[f]; c < mesh.faceOffsets[f + 1]; ++c )
+        {
+            faces[counts[mesh.faceIndices[c]].fetch_add( 1, std::memory_order_relaxed )] =
+                uint( f );
+        }
+    } );
+
+    // make the table independent of the thread scheduling
+    parallelFor( 0, nv, [&]( size_t v ) {
+        std::sort( faces.begin() + offsets[v], faces.begin() + offsets[v + 1] );
+    } );
+}
+
+uint Connectivity::findEdge( uint a, uint b ) const {
+    if ( a > b ) { std::swap( a, b ); }
+    auto first = edges.begin() + vertexEdgeOffsets[a];
+    auto last  = edges.begin() + vertexEdgeOffsets[a + 1];
+    auto it =
+        std::lower_bound( first, last, b, []( const Edge& e, uint v ) { return e.v1 < v; } );
+    return ( it != last && it->v1 == b ) ? uint( it - edges.begin() ) : Invalid;
+}
+
+void Connectivity::build( const FlatMesh& mesh ) {
+    const size_t nv = mesh.nVertices();
+    const size_t nf = mesh.nFaces();
+    buildVertexFaces( mesh, vertexFaceOffsets, vertexFaces );
+
+    // Collect, for vertex v, the sorted unique neighbours w > v. Each edge is then owned by its
+    // smallest vertex, which gives an edge table sorted by ( v0, v1 ) without a global sort.
+    auto forEachOwnedEdge = [&]( size_t v, std::vector<uint>& buffer ) {
+        buffer.clear();
+        for ( uint j = vertexFaceOffsets[v]; j < vertexFaceOffsets[v + 1]; ++j )
+        {
+            const uint f = vertexFaces[j];
+            const uint o = mesh.faceOffsets[f];
+            const uint k = mesh.faceSize( f );
+            for ( uint i = 0; i < k; ++i )
+            {
+                if ( mesh.faceIndices[o + i] != v ) { continue; }
+                const uint next = mesh.faceIndices[o + ( i + 1 ) % k];
+                const uint prev = mesh.faceIndices[o + ( i + k - 1 ) % k];
+                if ( next > v ) { buffer.push_back( next ); }
+                if ( prev > v ) { buffer.push_back( prev ); }
+            }
+        }
+        std::sort( buffer.begin(), buffer.end() );
+        buffer.erase( std::unique( buffer.begin(), buffer.end() ), buffer.end() );
+    };
+
+    vertexEdgeOffsets.assign( nv + 1, 0 );
+    parallelForRange( 0, nv, [&]( size_t b, size_t e ) {
+        std::vector<uint> buffer;
+        for ( size_t v = b; v < e; ++v )
+        {
+            forEachOwnedEdge( v, buffer );
+            vertexEdgeOffsets[v] = uint( buffer.size() );
+        }
+    } );
+    // the last (zero) slot receives the total edge count
+    exclusiveScan( vertexEdgeOffsets );
+
+    edges.clear();
+    edges.resize( vertexEdgeOffsets[nv] );
+    parallelForRange( 0, nv, [&]( size_t b, size_t e ) {
+        std::vector<uint> buffer;
+        for ( size_t v = b; v < e; ++v )
+        {
+            forEachOwnedEdge( v, buffer );
+            uint out = vertexEdgeOffsets[v];
+            for ( uint w : buffer )
+            {
+                edges[out].v0 = uint( v );
+                edges[out].v1 = w;
+                ++out;
+            }
+        }
+    } );
+
+    cornerEdges.resize( mesh.faceIndices.size() );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        const uint o = mesh.faceOffsets[f];
+        const uint k = mesh.faceSize( f );
+        for ( uint i = 0; i < k; ++i )
+        {
+            cornerEdges[o + i] =
+                findEdge( mesh.faceIndices[o + i], mesh.faceIndices[o + ( i + 1 ) % k] );
+        }
+    } );
+
+    // Adjacent faces of edge e are the faces around v0 having a corner mapped to e.
+    parallelFor( 0, edges.size(), [&]( size_t e ) {
+        Edge& edge = edges[e];
+        for ( uint j = vertexFaceOffsets[edge.v0]; j < vertexFaceOffsets[edge.v0 + 1]; ++j )
+        {
+            const uint f = vertexFaces[j];
+            for ( uint c = mesh.faceOffsets[f]; c < mesh.faceOffsets[f + 1]; ++c )
+            {
+                if ( cornerEdges[c] != e ) { continue; }
+                if ( edge.nFaces == 0 ) { edge.f0 = f; }
+                else if ( edge.nFaces == 1 )
+                { edge.f1 = f; }
+                ++edge.nFaces;
+            }
+        }
+    } );
+}
+
+} // namespace Subdivision
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Arena.hpp"
+
+#include <Core/Geometry/TriangleMesh.hpp>
+#include <Core/Types.hpp>
+
+#include <vector>
+
+namespace Subdivision {
+
+/// Compact polygon mesh: positions plus faces stored as a CSR array
+/// (face f spans faceIndices[faceOffsets[f]] to faceIndices[faceOffsets[f+1]]).
+/// The face arrays are served by \p arena when one is given, the positions stay a Vector3Array,
+/// the array taken by the TriangleMesh and the limit surface.
+struct FlatMesh {
+    explicit FlatMesh( Arena* arena = nullptr ) :
+        faceOffsets( 1, 0, arena ), faceIndices( arena ) {}
+
+    Ra::Core::Vector3Array positions;
+    ArenaVector<uint> faceOffsets;
+    ArenaVector<uint> faceIndices;
+
+    inline size_t nVertices() const { return positions.size(); }
+    inline size_t nFaces() const { return faceOffsets.size() - 1; }
+    inline uint faceSize( size_t f ) const { return faceOffsets[f + 1] - faceOffsets[f]; }
+
+    /// True if all faces have exactly \p n vertices.
+    bool isUniform( uint n ) const;
+
+    static FlatMesh fromTriangleMesh( const Ra::Core::Geometry::TriangleMesh& mesh );
+    /// Same as fromTriangleMesh, reusing the current buffers.
+    void assign( const Ra::Core::Geometry::TriangleMesh& mesh );
+
+    /// Area weighted vertex normals.
+    Ra::Core::Vector3Array vertexNormals() const;
+
+    /// Fan triangulation of the faces, with area weighted vertex normals.
+    Ra::Core::Geometry::TriangleMesh toTriangleMesh() const;
+};
+
+/// Index based connectivity of a FlatMesh: edge table, vertex to face table
+/// and, for each face corner, the edge going to the next corner.
+/// All the tables are served by \p arena when one is given.
+struct Connectivity {
+    static constexpr uint Invalid = uint( -1 );
+
+    explicit Connectivity( Arena* arena = nullptr ) :
+        edges( arena ),
+        vertexEdgeOffsets( arena ),
+        vertexFaceOffsets( arena ),
+        vertexFaces( arena ),
+        cornerEdges( arena ) {}
+
+    struct Edge {
+        uint v0;                 ///< smallest vertex index
+        uint v1;                 ///< largest vertex index
+        uint f0{Invalid};        ///< first adjacent face
+        uint f1{Invalid};        ///< second adjacent face
+        uint nFaces{0};          ///< number of adjacent faces (> 2 means non-manifold)
+        inline bool isBoundary() const { return nFaces == 1; }
+        inline bool isManifold() const { return nFaces <= 2; }
+    };
+
+    /// Edges sorted by ( v0, v1 ).
+    ArenaVector<Edge> edges;
+    /// Edges of vertex v with v == v0 are edges[vertexEdgeOffsets[v]] to
+    /// edges[vertexEdgeOffsets[v+1]].
+    ArenaVector<uint> vertexEdgeOffsets;
+    /// Faces incident to vertex v are vertexFaces[vertexFaceOffsets[v]] to
+    /// vertexFaces[vertexFaceOffsets[v+1]], sorted by index.
+    ArenaVector<uint> vertexFaceOffsets;
+    ArenaVector<uint> vertexFaces;
+    /// Parallel to FlatMesh::faceIndices: edge from each corner to the next one.
+    ArenaVector<uint> cornerEdges;
+
+    /// Build all tables in parallel.
+    void build( const FlatMesh& mesh );
+
+    /// Index of the edge ( a, b ), or Invalid.
+    uint findEdge( uint a, uint b ) const;
+
+    inline size_t nEdges() const { return edges.size(); }
+
+    /// Build the vertex to face table only.
+    static void buildVertexFaces( const FlatMesh& mesh,
+                                  ArenaVector<uint>& offsets,
+                                  ArenaVector<uint>& faces );
+};
+
+} // namespace Subdivision
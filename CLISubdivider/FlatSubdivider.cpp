@@ -0,0 +1,245 @@
+#include "FlatSubdivider.hpp"
+#include "Parallel.hpp"
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+bool schemeFromName( const std::string& name, Scheme& scheme ) {
+    if ( name == "catmull" ) { scheme = Scheme::CatmullClark; }
+    else if ( name == "loop" )
+    { scheme = Scheme::Loop; }
+    else
+    { return false; }
+    return true;
+}
+
+namespace {
+
+/// One-ring information around a vertex, gathered from its incident faces.
+struct VertexRing {
+    uint nFaces{0};
+    /// Sum over incident faces of the next and previous corner positions.
+    /// For an interior vertex each neighbour appears twice.
+    Vector3 neighbourSum{Vector3::Zero()};
+    uint nBoundary{0};
+    Vector3 boundarySum{Vector3::Zero()};
+    bool nonManifold{false};
+
+    /// Fixed vertices: isolated, non-manifold or corner (not exactly 2 boundary edges).
+    inline bool isFixed() const {
+        return nFaces == 0 || nonManifold || ( nBoundary != 0 && nBoundary != 2 );
+    }
+    inline bool isBoundary() const { return nBoundary == 2; }
+};
+
+VertexRing gatherRing( const FlatMesh& mesh, const Connectivity& c, uint v ) {
+    VertexRing ring;
+    for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+    {
+        const uint f = c.vertexFaces[j];
+        const uint o = mesh.faceOffsets[f];
+        const uint k = mesh.faceSize( f );
+        for ( uint i = 0; i < k; ++i )
+        {
+            if ( mesh.faceIndices[o + i] != v ) { continue; }
+            const uint cNext = o + ( i + 1 ) % k;
+            const uint cPrev = o + ( i + k - 1 ) % k;
+            const Vector3& next = mesh.positions[mesh.faceIndices[cNext]];
+            const Vector3& prev = mesh.positions[mesh.faceIndices[cPrev]];
+            ring.neighbourSum += next + prev;
+            ++ring.nFaces;
+
+            const auto& eOut = c.edges[c.cornerEdges[o + i]];
+            const auto& eIn  = c.edges[c.cornerEdges[cPrev]];
+            if ( eOut.isBoundary() )
+            {
+                ++ring.nBoundary;
+                ring.boundarySum += next;
+            }
+            if ( eIn.isBoundary() )
+            {
+                ++ring.nBoundary;
+                ring.boundarySum += prev;
+            }
+            ring.nonManifold = ring.nonManifold || !eOut.isManifold() || !eIn.isManifold();
+        }
+    }
+    return ring;
+}
+
+} // namespace
+
+bool FlatSubdivider::operator()( FlatMesh& mesh, int iterations ) const {
+    Workspace workspace;
+    return ( *this )( mesh, iterations, workspace );
+}
+
+bool FlatSubdivider::operator()( FlatMesh& mesh, int iterations, Workspace& workspace ) const {
+    if ( m_scheme == Scheme::Loop && !mesh.isUniform( 3 ) ) { return false; }
+    for ( int i = 0; i < iterations; ++i )
+    {
+        workspace.connectivity.build( mesh );
+        refine( mesh, workspace.connectivity, workspace.refined );
+        std::swap( mesh, workspace.refined );
+    }
+    return true;
+}
+
+FlatMesh FlatSubdivider::refine( const FlatMesh& mesh, const Connectivity& c ) const {
+    FlatMesh ret;
+    refine( mesh, c, ret );
+    return ret;
+}
+
+void FlatSubdivider::refine( const FlatMesh& mesh, const Connectivity& c, FlatMesh& out ) const {
+    if ( m_scheme == Scheme::Loop ) { refineLoop( mesh, c, out ); }
+    else
+    { refineCatmullClark( mesh, c, out ); }
+}
+
+Vector3 FlatSubdivider::loopVertexPoint( const FlatMesh& mesh, const Connectivity& c, uint v ) {
+    const VertexRing ring = gatherRing( mesh, c, v );
+    const Vector3& p      = mesh.positions[v];
+    if ( ring.isFixed() ) { return p; }
+    if ( ring.isBoundary() ) { return Scalar( 0.75 ) * p + Scalar( 0.125 ) * ring.boundarySum; }
+    const uint n      = ring.nFaces;
+    const Scalar beta = loopBeta( n );
+    return ( 1 - n * beta ) * p + beta * Scalar( 0.5 ) * ring.neighbourSum;
+}
+
+Vector3 FlatSubdivider::loopEdgePoint( const FlatMesh& mesh, const Connectivity& c, uint e ) {
+    const auto& edge  = c.edges[e];
+    const Vector3& p0 = mesh.positions[edge.v0];
+    const Vector3& p1 = mesh.positions[edge.v1];
+    if ( edge.nFaces != 2 ) { return Scalar( 0.5 ) * ( p0 + p1 ); }
+    // opposite vertex of a triangle: the corner after the edge end
+    auto opposite = [&]( uint f ) {
+        const uint o = mesh.faceOffsets[f];
+        for ( uint i = 0; i < 3; ++i )
+        {
+            if ( c.cornerEdges[o + i] == e )
+            { return mesh.positions[mesh.faceIndices[o + ( i + 2 ) % 3]]; }
+        }
+        return mesh.positions[mesh.faceIndices[o]];
+    };
+    return Scalar( 3. / 8. ) * ( p0 + p1 ) +
+           Scalar( 1. / 8. ) * ( opposite( edge.f0 ) + opposite( edge.f1 ) );
+}
+
+void FlatSubdivider::refineLoop( const FlatMesh& mesh, const Connectivity& c, FlatMesh& ret ) const {
+    const size_t nv = mesh.nVertices();
+    const size_t ne = c.nEdges();
+    const size_t nf = mesh.nFaces();
+
+    ret.positions.resize( nv + ne );
+
+    // vertex points
+    parallelFor( 0, nv, [&]( size_t v ) {
+        ret.positions[v] = loopVertexPoint( mesh, c, uint( v ) );
+    } );
+
+    // edge points
+    parallelFor( 0, ne, [&]( size_t e ) {
+        ret.positions[nv + e] = loopEdgePoint( mesh, c, uint( e ) );
+    } );
+
+    // 1 to 4 split
+    ret.faceOffsets.resize( 4 * nf + 1 );
+    ret.faceIndices.resize( 12 * nf );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        const uint o   = mesh.faceOffsets[f];
+        const uint a   = mesh.faceIndices[o];
+        const uint b   = mesh.faceIndices[o + 1];
+        const uint d   = mesh.faceIndices[o + 2];
+        const uint eab = uint( nv ) + c.cornerEdges[o];
+        const uint ebd = uint( nv ) + c.cornerEdges[o + 1];
+        const uint eda = uint( nv ) + c.cornerEdges[o + 2];
+        const uint tris[12]{a, eab, eda, eab, b, ebd, eda, ebd, d, eab, ebd, eda};
+        for ( int i = 0; i < 12; ++i )
+        {
+            ret.faceIndices[12 * f + i] = tris[i];
+        }
+        for ( int i = 0; i < 4; ++i )
+        {
+            ret.faceOffsets[4 * f + i] = uint( 12 * f + 3 * i );
+        }
+    } );
+    ret.faceOffsets.back() = uint( 12 * nf );
+}
+
+void FlatSubdivider::refineCatmullClark( const FlatMesh& mesh,
+                                         const Connectivity& c,
+                                         FlatMesh& ret ) const {
+    const size_t nv = mesh.nVertices();
+    const size_t ne = c.nEdges();
+    const size_t nf = mesh.nFaces();
+    const size_t fp = nv + ne; // index of the first face point
+
+    ret.positions.resize( nv + ne + nf );
+
+    // face points
+    parallelFor( 0, nf, [&]( size_t f ) {
+        Vector3 sum = Vector3::Zero();
+        for ( uint i = mesh.faceOffsets[f]; i < mesh.faceOffsets[f + 1]; ++i )
+        {
+            sum += mesh.positions[mesh.faceIndices[i]];
+        }
+        ret.positions[fp + f] = sum / Scalar( mesh.faceSize( f ) );
+    } );
+
+    // edge points
+    parallelFor( 0, ne, [&]( size_t e ) {
+        const auto& edge = c.edges[e];
+        const Vector3 s  = mesh.positions[edge.v0] + mesh.positions[edge.v1];
+        if ( edge.nFaces != 2 ) { ret.positions[nv + e] = Scalar( 0.5 ) * s; }
+        else
+        {
+            ret.positions[nv + e] =
+                Scalar( 0.25 ) * ( s + ret.positions[fp + edge.f0] + ret.positions[fp + edge.f1] );
+        }
+    } );
+
+    // vertex points
+    parallelFor( 0, nv, [&]( size_t v ) {
+        const VertexRing ring = gatherRing( mesh, c, uint( v ) );
+        const Vector3& p      = mesh.positions[v];
+        if ( ring.isFixed() ) { ret.positions[v] = p; }
+        else if ( ring.isBoundary() )
+        { ret.positions[v] = Scalar( 0.75 ) * p + Scalar( 0.125 ) * ring.boundarySum; }
+        else
+        {
+            const Scalar n = Scalar( ring.nFaces );
+            Vector3 F      = Vector3::Zero();
+            for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+            {
+                F += ret.positions[fp + c.vertexFaces[j]];
+            }
+            F /= n;
+            // average of the incident edge midpoints
+            const Vector3 R  = Scalar( 0.5 ) * ( p + ring.neighbourSum / ( 2 * n ) );
+            ret.positions[v] = ( F + 2 * R + ( n - 3 ) * p ) / n;
+        }
+    } );
+
+    // each corner of a coarse face gives one quad
+    const size_t nCorners = mesh.faceIndices.size();
+    ret.faceOffsets.resize( nCorners + 1 );
+    ret.faceIndices.resize( 4 * nCorners );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        const uint o = mesh.faceOffsets[f];
+        const uint k = mesh.faceSize( f );
+        for ( uint i = 0; i < k; ++i )
+        {
+            const uint q              = o + i;
+            ret.faceOffsets[q]        = 4 * q;
+            ret.faceIndices[4 * q]     = mesh.faceIndices[q];
+            ret.faceIndices[4 * q + 1] = uint( nv ) + c.cornerEdges[q];
+            ret.faceIndices[4 * q + 2] = uint( fp + f );
+            ret.faceIndices[4 * q + 3] = uint( nv ) + c.cornerEdges[o + ( i + k - 1 ) % k];
+        }
+    } );
+    ret.faceOffsets.back() = uint( 4 * nCorners );
+}
+
+} // namespace Subdivision
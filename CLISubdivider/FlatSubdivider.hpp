@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FlatMesh.hpp"
+
+#include <cmath>
+#include <string>
+
+namespace Subdivision {
+
+enum class Scheme { Loop, CatmullClark };
+
+/// Parse "loop" or "catmull". Returns false if the name is unknown.
+bool schemeFromName( const std::string& name, Scheme& scheme );
+
+/// Weight of each neighbour of an interior vertex of valence \p n in the Loop vertex rule.
+inline Scalar loopBeta( uint n ) {
+    const Scalar t = Scalar( 3. / 8. ) + Scalar( 0.25 ) * std::cos( Scalar( 2 * M_PI ) / n );
+    return ( Scalar( 5. / 8. ) - t * t ) / n;
+}
+
+/// Multithreaded uniform subdivision over the FlatMesh / Connectivity layout.
+/// Vertex, edge and face points are computed with the Loop or Catmull-Clark stencils,
+/// boundaries use the cubic B-spline rules, and corners or non-manifold vertices are kept fixed.
+///
+/// The refined mesh stores the vertex points first (same indices as the coarse vertices),
+/// then one point per coarse edge, then (Catmull-Clark only) one point per coarse face.
+class FlatSubdivider
+{
+  public:
+    /// Buffers reused between refinement steps (and between meshes when kept by the caller),
+    /// served by \p arena when one is given.
+    struct Workspace {
+        explicit Workspace( Arena* arena = nullptr ) :
+            arena( arena ), connectivity( arena ), refined( arena ) {}
+
+        Arena* arena;
+        Connectivity connectivity;
+        FlatMesh refined;
+    };
+
+    explicit FlatSubdivider( Scheme scheme ) : m_scheme( scheme ) {}
+
+    /// Refine \p mesh \p iterations times.
+    /// Returns false if the mesh cannot be processed (Loop requires triangles).
+    bool operator()( FlatMesh& mesh, int iterations ) const;
+    bool operator()( FlatMesh& mesh, int iterations, Workspace& workspace ) const;
+
+    /// One refinement step, using precomputed connectivity of \p mesh.
+    /// Catmull-Clark always outputs quads.
+    FlatMesh refine( const FlatMesh& mesh, const Connectivity& c ) const;
+    /// Same as above, reusing the buffers of \p out.
+    void refine( const FlatMesh& mesh, const Connectivity& c, FlatMesh& out ) const;
+
+    inline Scheme scheme() const { return m_scheme; }
+
+    /// Loop vertex point of the vertex \p v of the triangle mesh \p mesh.
+    static Ra::Core::Vector3
+    loopVertexPoint( const FlatMesh& mesh, const Connectivity& c, uint v );
+    /// Loop edge point of the edge \p e of the triangle mesh \p mesh.
+    static Ra::Core::Vector3 loopEdgePoint( const FlatMesh& mesh, const Connectivity& c, uint e );
+
+  private:
+    void refineLoop( const FlatMesh& mesh, const Connectivity& c, FlatMesh& out ) const;
+    void refineCatmullClark( const FlatMesh& mesh, const Connectivity& c, FlatMesh& out ) const;
+
+    Scheme m_scheme;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,304 @@
+#include "LimitSurface.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+namespace {
+
+constexpr uint Invalid = Connectivity::Invalid;
+
+/// Limit position and tangent weights of one vertex.
+struct VertexStencil {
+    std::vector<uint> indices;
+    std::vector<Scalar> position;
+    std::vector<Scalar> tangentU;
+    std::vector<Scalar> tangentV;
+
+    void clear() {
+        indices.clear();
+        position.clear();
+        tangentU.clear();
+        tangentV.clear();
+    }
+    void add( uint i, Scalar p, Scalar u, Scalar v ) {
+        indices.push_back( i );
+        position.push_back( p );
+        tangentU.push_back( u );
+        tangentV.push_back( v );
+    }
+    inline size_t size() const { return indices.size(); }
+};
+
+/// A face around a vertex: the next, previous and (quads) opposite corners, and the edges from
+/// the vertex to the next corner and from the previous corner to the vertex.
+struct RingFace {
+    uint next;
+    uint prev;
+    uint opposite;
+    uint nextEdge;
+    uint prevEdge;
+};
+
+/// Gather the faces of \p v in \p ring, ordered counterclockwise (for counterclockwise faces)
+/// and starting after the boundary if any. Returns false when the vertex is fixed: corner,
+/// non-manifold, several fans or inconsistent orientation.
+bool orderedRing( const FlatMesh& mesh,
+                  const Connectivity& c,
+                  uint v,
+                  std::vector<RingFace>& ring,
+                  bool& boundary ) {
+    ring.clear();
+    uint nBoundary   = 0;
+    bool nonManifold = false;
+    for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+    {
+        const uint f = c.vertexFaces[j];
+        const uint o = mesh.faceOffsets[f];
+        const uint k = mesh.faceSize( f );
+        uint i       = 0;
+        while ( mesh.faceIndices[o + i] != v )
+        {
+            ++i;
+        }
+        RingFace r;
+        r.next     = mesh.faceIndices[o + ( i + 1 ) % k];
+        r.prev     = mesh.faceIndices[o + ( i + k - 1 ) % k];
+        r.opposite = k == 4 ? mesh.faceIndices[o + ( i + 2 ) % k] : Invalid;
+        r.nextEdge = c.cornerEdges[o + i];
+        r.prevEdge = c.cornerEdges[o + ( i + k - 1 ) % k];
+        for ( uint e : {r.nextEdge, r.prevEdge} )
+        {
+            nBoundary += c.edges[e].isBoundary() ? 1 : 0;
+            nonManifold = nonManifold || !c.edges[e].isManifold();
+        }
+        ring.push_back( r );
+    }
+    boundary = nBoundary == 2;
+    if ( ring.empty() || nonManifold || ( nBoundary != 0 && nBoundary != 2 ) ) { return false; }
+
+    // the face after r shares the edge ( v, r.prev ): its next corner is r.prev
+    if ( boundary )
+    {
+        auto first = std::find_if( ring.begin(), ring.end(), [&c]( const RingFace& r ) {
+            return c.edges[r.nextEdge].isBoundary();
+        } );
+        std::iter_swap( ring.begin(), first );
+    }
+    for ( size_t i = 1; i < ring.size(); ++i )
+    {
+        auto next = std::find_if( ring.begin() + i, ring.end(), [&]( const RingFace& r ) {
+            return r.next == ring[i - 1].prev;
+        } );
+        if ( next == ring.end() ) { return false; }
+        std::iter_swap( ring.begin() + i, next );
+    }
+    return boundary ? c.edges[ring.back().prevEdge].isBoundary()
+                    : ring.back().prev == ring.front().next;
+}
+
+/// Limit stencils of \p v. The tangents are ordered so that u x v is along the face normals.
+void computeStencil( const FlatMesh& mesh,
+                     const Connectivity& c,
+                     Scheme scheme,
+                     uint v,
+                     std::vector<RingFace>& ring,
+                     VertexStencil& s ) {
+    s.clear();
+    bool boundary;
+    if ( !orderedRing( mesh, c, v, ring, boundary ) )
+    {
+        // fixed vertex, tangents of its first face
+        s.add( v, 1, ring.empty() ? 0 : -1, ring.empty() ? 0 : -1 );
+        if ( !ring.empty() )
+        {
+            s.add( ring[0].next, 0, 1, 0 );
+            s.add( ring[0].prev, 0, 0, 1 );
+        }
+        return;
+    }
+
+    const uint n = uint( ring.size() );
+    if ( boundary )
+    {
+        // cubic B-spline along the boundary: u across (towards the inside), v along
+        const uint first = ring.front().next;
+        const uint last  = ring.back().prev;
+        s.add( v, Scalar( 4. / 6. ), 0, 0 );
+        s.add( first, Scalar( 1. / 6. ), 0, -1 );
+        s.add( last, Scalar( 1. / 6. ), 0, 1 );
+        if ( scheme == Scheme::Loop )
+        {
+            // Hoppe et al. 1994, ring q_0 = first ... q_n = last
+            if ( n == 1 )
+            {
+                s.tangentU[0] = -2;
+                s.tangentU[1] = s.tangentU[2] = 1;
+            }
+            else if ( n == 2 )
+            {
+                s.tangentU[0] = -1;
+                s.add( ring[1].next, 0, 1, 0 );
+            }
+            else
+            {
+                // negated, to point inside as for n < 3
+                const Scalar theta = Scalar( M_PI ) / n;
+                s.tangentU[1] = s.tangentU[2] = -std::sin( theta );
+                for ( uint i = 1; i < n; ++i )
+                {
+                    const Scalar w = ( 2 - 2 * std::cos( theta ) ) * std::sin( i * theta );
+                    s.add( ring[i].next, 0, w, 0 );
+                }
+            }
+        }
+        else
+        {
+            // direction of the inner ring: inner edge neighbours and face diagonals
+            const Scalar w = Scalar( 1 ) / Scalar( 2 * n - 1 );
+            s.tangentU[0]  = -1;
+            for ( uint i = 0; i < n; ++i )
+            {
+                if ( i > 0 ) { s.add( ring[i].next, 0, w, 0 ); }
+                s.add( ring[i].opposite, 0, w, 0 );
+            }
+        }
+        return;
+    }
+
+    const Scalar angle = Scalar( 2 * M_PI ) / n;
+    if ( scheme == Scheme::Loop )
+    {
+        // limit weight of the center: 3 / ( 8 beta ), normalized with the n neighbours
+        const Scalar center = Scalar( 3 ) / ( 8 * loopBeta( n ) );
+        s.add( v, center / ( center + n ), 0, 0 );
+        for ( uint i = 0; i < n; ++i )
+        {
+            s.add( ring[i].next, 1 / ( center + n ), std::cos( i * angle ), std::sin( i * angle ) );
+        }
+        return;
+    }
+
+    // Catmull-Clark, Halstead et al. 1993
+    const Scalar a = 1 + std::cos( angle ) +
+                     std::cos( angle / 2 ) * std::sqrt( 2 * ( 9 + std::cos( angle ) ) );
+    const Scalar norm = Scalar( 1 ) / ( n * ( n + 5 ) );
+    s.add( v, n * n * norm, 0, 0 );
+    for ( uint i = 0; i < n; ++i )
+    {
+        s.add( ring[i].next, 4 * norm, a * std::cos( i * angle ), a * std::sin( i * angle ) );
+        s.add( ring[i].opposite,
+               norm,
+               std::cos( i * angle ) + std::cos( ( i + 1 ) * angle ),
+               std::sin( i * angle ) + std::sin( ( i + 1 ) * angle ) );
+    }
+}
+
+} // namespace
+
+bool LimitSurface::build( const FlatMesh& mesh, const Connectivity& c, Scheme scheme ) {
+    if ( !mesh.isUniform( scheme == Scheme::Loop ? 3 : 4 ) ) { return false; }
+    m_nVertices           = mesh.nVertices();
+    const size_t nPackets = ( m_nVertices + Width - 1 ) / Width;
+
+    // packets are padded to their largest stencil
+    auto forEachPacket = [&]( auto&& f ) {
+        parallelForRange(
+            0,
+            nPackets,
+            [&]( size_t b, size_t e ) {
+                std::vector<RingFace> ring;
+                VertexStencil s;
+                for ( size_t p = b; p < e; ++p )
+                {
+                    for ( size_t l = 0; l < Width && p * Width + l < m_nVertices; ++l )
+                    {
+                        computeStencil( mesh, c, scheme, uint( p * Width + l ), ring, s );
+                        f( p, l, s );
+                    }
+                }
+            },
+            64 );
+    };
+    m_packetOffsets.assign( nPackets + 1, 0 );
+    forEachPacket( [this]( size_t p, size_t, const VertexStencil& s ) {
+        m_packetOffsets[p] = std::max( m_packetOffsets[p], uint( s.size() ) );
+    } );
+    const size_t nEntries = exclusiveScan( m_packetOffsets ) * Width;
+
+    m_indices.assign( nEntries, 0 );
+    m_position.assign( nEntries, 0 );
+    m_tangentU.assign( nEntries, 0 );
+    m_tangentV.assign( nEntries, 0 );
+    forEachPacket( [this]( size_t p, size_t l, const VertexStencil& s ) {
+        for ( size_t k = 0; k < s.size(); ++k )
+        {
+            const size_t i = ( m_packetOffsets[p] + k ) * Width + l;
+            m_indices[i]   = s.indices[k];
+            m_position[i]  = s.position[k];
+            m_tangentU[i]  = s.tangentU[k];
+            m_tangentV[i]  = s.tangentV[k];
+        }
+    } );
+    return true;
+}
+
+void LimitSurface::apply( Vector3Array& positions, Vector3Array& normals ) const {
+    m_x.resize( m_nVertices );
+    m_y.resize( m_nVertices );
+    m_z.resize( m_nVertices );
+    parallelFor( 0, m_nVertices, [&]( size_t v ) {
+        m_x[v] = positions[v]( 0 );
+        m_y[v] = positions[v]( 1 );
+        m_z[v] = positions[v]( 2 );
+    } );
+
+    normals.resize( m_nVertices );
+    parallelFor(
+        0,
+        m_packetOffsets.size() - 1,
+        [&]( size_t p ) {
+            // one accumulator per lane and per component
+            Scalar px[Width]{}, py[Width]{}, pz[Width]{};
+            Scalar ux[Width]{}, uy[Width]{}, uz[Width]{};
+            Scalar vx[Width]{}, vy[Width]{}, vz[Width]{};
+            for ( size_t k = m_packetOffsets[p]; k < m_packetOffsets[p + 1]; ++k )
+            {
+                const uint* index   = m_indices.data() + k * Width;
+                const Scalar* wp    = m_position.data() + k * Width;
+                const Scalar* wu    = m_tangentU.data() + k * Width;
+                const Scalar* wv    = m_tangentV.data() + k * Width;
+                for ( size_t l = 0; l < Width; ++l )
+                {
+                    const Scalar x = m_x[index[l]];
+                    const Scalar y = m_y[index[l]];
+                    const Scalar z = m_z[index[l]];
+                    px[l] += wp[l] * x;
+                    py[l] += wp[l] * y;
+                    pz[l] += wp[l] * z;
+                    ux[l] += wu[l] * x;
+                    uy[l] += wu[l] * y;
+                    uz[l] += wu[l] * z;
+                    vx[l] += wv[l] * x;
+                    vy[l] += wv[l] * y;
+                    vz[l] += wv[l] * z;
+                }
+            }
+            for ( size_t l = 0; l < Width && p * Width + l < m_nVertices; ++l )
+            {
+                const size_t v = p * Width + l;
+                positions[v]   = Vector3( px[l], py[l], pz[l] );
+                const Vector3 n =
+                    Vector3( ux[l], uy[l], uz[l] ).cross( Vector3( vx[l], vy[l], vz[l] ) );
+                const Scalar length = n.norm();
+                normals[v]          = length > 0 ? Vector3( n / length ) : n;
+            }
+        },
+        64 );
+}
+
+} // namespace Subdivision
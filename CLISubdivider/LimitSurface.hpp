@@ -0,0 +1,52 @@
+#pragma once
+
+#include "FlatSubdivider.hpp"
+
+#include <Core/Types.hpp>
+
+#include <vector>
+
+namespace Subdivision {
+
+/// Projection of the vertices of a subdivided mesh onto the Loop or Catmull-Clark limit surface,
+/// with the analytic limit normals.
+///
+/// build() derives three stencils per vertex from its ordered one-ring: the limit position and
+/// two limit tangents, whose cross product is the normal. Interior vertices use the eigenvector
+/// masks of the schemes, boundary vertices the cubic B-spline limit along the boundary and, across
+/// it, the tangent of Hoppe et al. (Loop) or the direction of the inner ring (Catmull-Clark).
+/// Corners, non-manifold vertices and vertices of inconsistently oriented faces keep their
+/// position and take the normal of their first face.
+///
+/// apply() evaluates the stencils on a structure of arrays copy of the positions. Vertices are
+/// processed by packets of Width lanes whose stencils are stored entry-major (padded with zero
+/// weights), so that the inner loop over the lanes of a packet is vectorized by the compiler.
+class LimitSurface
+{
+  public:
+    static constexpr size_t Width = 8;
+
+    /// Build the stencils of \p mesh, whose connectivity is \p c.
+    /// Returns false if the faces are not all triangles (Loop) or all quads (Catmull-Clark).
+    bool build( const FlatMesh& mesh, const Connectivity& c, Scheme scheme );
+
+    /// Replace \p positions by their limit positions and fill \p normals with the limit normals.
+    /// \p positions must be the positions of the mesh given to build().
+    void apply( Ra::Core::Vector3Array& positions, Ra::Core::Vector3Array& normals ) const;
+
+  private:
+    size_t m_nVertices{0};
+    /// Entries of packet p are [m_packetOffsets[p], m_packetOffsets[p+1]), entry k of lane l
+    /// is stored at k * Width + l in the arrays below.
+    std::vector<uint> m_packetOffsets{0};
+    std::vector<uint> m_indices;
+    std::vector<Scalar> m_position;
+    std::vector<Scalar> m_tangentU;
+    std::vector<Scalar> m_tangentV;
+    /// SoA copy of the input positions
+    mutable std::vector<Scalar> m_x;
+    mutable std::vector<Scalar> m_y;
+    mutable std::vector<Scalar> m_z;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,86 @@
+#include "LodChain.hpp"
+#include "Parallel.hpp"
+
+#include <VertexCacheOptimizer.hpp>
+
+#include <Core/Utils/Log.hpp>
+
+#include <future>
+
+namespace Subdivision {
+
+using namespace Ra::Core::Utils; // log
+
+bool LodChain::run( FlatMesh& mesh, const std::string& output ) {
+    if ( m_settings.scheme == Scheme::Loop && !mesh.isUniform( 3 ) )
+    {
+        LOG( logERROR ) << "Loop subdivision requires a triangle mesh.";
+        return false;
+    }
+    FlatSubdivider subdivider( m_settings.scheme );
+    FlatSubdivider::Workspace workspace;
+    // the writer shares the cores of the caller (several jobs may run concurrently)
+    const unsigned int nThreads = threadCount();
+    bool saved                  = true;
+    for ( int level = 0;; ++level )
+    {
+        std::future<bool> writing =
+            std::async( std::launch::async, [this, &mesh, &output, level, nThreads]() {
+                ScopedThreadCount threads( nThreads );
+                return save( mesh, output, level );
+            } );
+        if ( level < m_settings.iterations )
+        {
+            // refine level + 1 while the writer reads the same, unmodified, level
+            ProfileScope phase( m_profiler, "subdivision" );
+            workspace.connectivity.build( mesh );
+            subdivider.refine( mesh, workspace.connectivity, workspace.refined );
+        }
+        {
+            ProfileScope phase( m_profiler, "wait for writer" );
+            saved = writing.get() && saved;
+        }
+        if ( !saved || level == m_settings.iterations ) { break; }
+        std::swap( mesh, workspace.refined );
+    }
+    m_vertexCount = mesh.nVertices();
+    m_faceCount   = mesh.nFaces();
+    return saved;
+}
+
+bool LodChain::save( const FlatMesh& level, const std::string& output, int index ) const {
+    const bool quads = m_settings.quadOutput && m_settings.scheme == Scheme::CatmullClark &&
+                       level.isUniform( 4 );
+    Ra::Core::Geometry::TriangleMesh triangles;
+    Ra::Core::Vector3Array normals;
+    MeshBuffers buffers;
+    if ( quads )
+    {
+        normals = level.vertexNormals();
+        buffers = MeshBuffers::fromFlatMesh( level, normals );
+    }
+    else
+    {
+        triangles = level.toTriangleMesh();
+        if ( m_settings.vertexCache > 0 )
+        { VertexCacheOptimizer( m_settings.vertexCache )( triangles ); }
+        buffers = MeshBuffers::fromTriangleMesh( triangles );
+    }
+
+    if ( m_settings.lodContainer )
+    {
+        // records are appended in level order, the previous writer is done
+        const std::string filename = output + ".rbm";
+        if ( !writeBinaryMesh( filename, buffers, index > 0 ) )
+        {
+            LOG( logERROR ) << "Cannot save level " << index << " to " << filename;
+            return false;
+        }
+        return true;
+    }
+    const std::string filename = output + "_lod" + std::to_string( index );
+    return quads ? saveMesh( filename, m_settings, buffers )
+                 : saveMesh( filename, m_settings, triangles );
+}
+
+} // namespace Subdivision
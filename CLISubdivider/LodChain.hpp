@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Pipeline.hpp"
+
+#include <string>
+
+namespace Subdivision {
+
+/// Uniform subdivision saving every level, from the input (level 0) to Settings::iterations, in a
+/// single run.
+///
+/// Each level is refined once from the previous one with the FlatSubdivider. Level k is saved by a
+/// background thread while level k + 1 is computed: both only read level k, and its buffers are
+/// reused once the writer is done with them.
+/// Level k is saved to output + "_lod" + k + extension, or, with Settings::lodContainer, appended
+/// to a single rbm file holding one record (header and buffers) per level, level 0 first.
+/// Triangle levels are reordered for the vertex cache by the writer, with Settings::vertexCache.
+class LodChain
+{
+  public:
+    explicit LodChain( const Settings& settings ) : m_settings( settings ) {}
+
+    /// Report the subdivision and wait phases to \p profiler (not owned), null to disable.
+    /// The writer thread is not profiled.
+    inline void setProfiler( Profiler* profiler ) { m_profiler = profiler; }
+
+    /// Refine \p mesh and save all its levels to \p output. \p mesh receives the finest level.
+    /// Returns false on error.
+    bool run( FlatMesh& mesh, const std::string& output );
+
+    /// Size of the finest level.
+    inline size_t vertexCount() const { return m_vertexCount; }
+    inline size_t faceCount() const { return m_faceCount; }
+
+  private:
+    /// Save \p level, run by the writer thread.
+    bool save( const FlatMesh& level, const std::string& output, int index ) const;
+
+    Settings m_settings;
+    Profiler* m_profiler{nullptr};
+    size_t m_vertexCount{0};
+    size_t m_faceCount{0};
+};
+
+} // namespace Subdivision
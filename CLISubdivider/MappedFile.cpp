@@ -0,0 +1,77 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#    define SUBDIVISION_USE_MMAP
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace Subdivision {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open( const std::string& filename ) {
+    close();
+#ifdef SUBDIVISION_USE_MMAP
+    int fd = ::open( filename.c_str(), O_RDONLY );
+    if ( fd < 0 ) { return false; }
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        ::close( fd );
+        return false;
+    }
+    m_size = size_t( st.st_size );
+    if ( m_size > 0 )
+    {
+        void* p = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if ( p != MAP_FAILED )
+        {
+            madvise( p, m_size, MADV_SEQUENTIAL );
+            m_data   = static_cast<const char*>( p );
+            m_mapped = true;
+        }
+    }
+    ::close( fd );
+    if ( m_mapped || m_size == 0 )
+    {
+        m_open = true;
+        return true;
+    }
+#endif
+    // fallback: read the whole file
+    std::ifstream in( filename, std::ios::binary | std::ios::ate );
+    if ( !in ) { return false; }
+    m_size = size_t( in.tellg() );
+    m_buffer.resize( m_size );
+    in.seekg( 0 );
+    if ( m_size > 0 && !in.read( m_buffer.data(), std::streamsize( m_size ) ) )
+    {
+        m_buffer.clear();
+        m_size = 0;
+        return false;
+    }
+    m_data = m_buffer.data();
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef SUBDIVISION_USE_MMAP
+    if ( m_mapped ) { munmap( const_cast<char*>( m_data ), m_size ); }
+#endif
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_data   = nullptr;
+    m_size   = 0;
+    m_open   = false;
+    m_mapped = false;
+}
+
+} // namespace Subdivision
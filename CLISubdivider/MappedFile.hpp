@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// Read-only view of a whole file.
+/// The file is memory-mapped when the platform allows it, and read into memory otherwise.
+class MappedFile
+{
+  public:
+    MappedFile() = default;
+    MappedFile( const MappedFile& ) = delete;
+    MappedFile& operator=( const MappedFile& ) = delete;
+    ~MappedFile();
+
+    /// Map \p filename. Returns false if the file cannot be opened.
+    bool open( const std::string& filename );
+    void close();
+
+    inline const char* data() const { return m_data; }
+    inline size_t size() const { return m_size; }
+    inline bool isOpen() const { return m_open; }
+
+  private:
+    const char* m_data{nullptr};
+    size_t m_size{0};
+    bool m_open{false};
+    bool m_mapped{false};
+    /// Used when mapping is not available.
+    std::vector<char> m_buffer;
+};
+
+} // namespace Subdivision
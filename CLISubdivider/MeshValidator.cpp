@@ -0,0 +1,304 @@
+#include "MeshValidator.hpp"
+#include "Parallel.hpp"
+
+#include <Core/Utils/Attribs.hpp>
+#include <Core/Utils/Log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <sstream>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+using namespace Ra::Core::Utils; // log
+
+namespace {
+
+constexpr uint Invalid = std::numeric_limits<uint>::max();
+
+/// Sorted vertices of a face, then the face index, so that the first of duplicates is kept.
+struct FaceKey {
+    std::array<uint, 3> vertices;
+    uint face;
+};
+
+/// Neighbour of a vertex through one of its faces.
+struct Neighbour {
+    uint vertex;
+    /// Corner of the face, relative to the first corner of the vertex
+    uint corner;
+    /// The face uses the edge from the vertex to the neighbour
+    bool outgoing;
+};
+
+inline uint findRoot( std::vector<uint>& parent, uint i ) {
+    while ( parent[i] != i )
+    {
+        parent[i] = parent[parent[i]];
+        i         = parent[i];
+    }
+    return i;
+}
+
+/// Union of two sets, rooted at their smallest element.
+inline void unite( std::vector<uint>& parent, uint a, uint b ) {
+    a = findRoot( parent, a );
+    b = findRoot( parent, b );
+    if ( a < b ) { parent[b] = a; }
+    else
+    { parent[a] = b; }
+}
+
+template <typename T>
+void appendCopies( AttribBase* attrib, const ArenaVector<uint>& origin ) {
+    auto& typed    = attrib->cast<Attrib<T>>();
+    auto& data     = typed.getDataWithLock();
+    const size_t n = data.size();
+    data.resize( n + origin.size() );
+    for ( size_t i = 0; i < origin.size(); ++i )
+    {
+        data[n + i] = data[origin[i]];
+    }
+    typed.unlock();
+}
+
+} // namespace
+
+bool manifoldCheckFromName( const std::string& name, ManifoldCheck& check ) {
+    if ( name == "off" ) { check = ManifoldCheck::Off; }
+    else if ( name == "check" )
+    { check = ManifoldCheck::Check; }
+    else if ( name == "repair" )
+    { check = ManifoldCheck::Repair; }
+    else
+    { return false; }
+    return true;
+}
+
+std::string MeshDefects::toString() const {
+    std::ostringstream out;
+    const char* separator = "";
+    auto item = [&out, &separator]( size_t count, const char* what ) {
+        if ( count == 0 ) { return; }
+        out << separator << count << " " << what;
+        separator = ", ";
+    };
+    item( degenerateFaces, "degenerate faces" );
+    item( duplicateFaces, "duplicate faces" );
+    item( nonManifoldEdges, "non-manifold edges" );
+    item( inconsistentEdges, "inconsistently oriented edges" );
+    item( nonManifoldVertices, "non-manifold vertices" );
+    return empty() ? "no defect" : out.str();
+}
+
+MeshDefects
+MeshValidator::analyze( const Geometry::TriangleMesh::IndexContainerType& triangles,
+                        size_t nVertices ) {
+    const size_t nf = triangles.size();
+    MeshDefects defects;
+
+    // degenerate faces
+    m_faceDefect.assign( nf, 0 );
+    std::atomic<size_t> degenerate{0};
+    parallelForRange( 0, nf, [&]( size_t first, size_t last ) {
+        size_t count = 0;
+        for ( size_t f = first; f < last; ++f )
+        {
+            const auto& t = triangles[f];
+            if ( t( 0 ) == t( 1 ) || t( 1 ) == t( 2 ) || t( 2 ) == t( 0 ) ||
+                 t( 0 ) >= nVertices || t( 1 ) >= nVertices || t( 2 ) >= nVertices )
+            {
+                m_faceDefect[f] = 1;
+                ++count;
+            }
+        }
+        degenerate += count;
+    } );
+    defects.degenerateFaces = degenerate;
+
+    // duplicate faces are consecutive once sorted by their sorted vertices
+    ArenaVector<FaceKey> keys( nf, m_arena );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        const auto& t = triangles[f];
+        keys[f]       = {{t( 0 ), t( 1 ), t( 2 )}, uint( f )};
+        if ( m_faceDefect[f] != 0 ) { keys[f].vertices = {Invalid, Invalid, Invalid}; }
+        std::sort( keys[f].vertices.begin(), keys[f].vertices.end() );
+    } );
+    parallelSort( keys, []( const FaceKey& a, const FaceKey& b ) {
+        return a.vertices != b.vertices ? a.vertices < b.vertices : a.face < b.face;
+    } );
+    std::atomic<size_t> duplicate{0};
+    parallelForRange( 1, nf, [&]( size_t first, size_t last ) {
+        size_t count = 0;
+        for ( size_t i = first; i < last; ++i )
+        {
+            if ( keys[i].vertices == keys[i - 1].vertices && keys[i].vertices[0] != Invalid )
+            {
+                m_faceDefect[keys[i].face] = 2;
+                ++count;
+            }
+        }
+        duplicate += count;
+    } );
+    defects.duplicateFaces = duplicate;
+
+    // corners of the valid faces, grouped by vertex
+    m_corners.resize( 3 * nf );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        for ( uint i = 0; i < 3; ++i )
+        {
+            const uint64_t vertex = m_faceDefect[f] == 0 ? triangles[f]( i ) : Invalid;
+            m_corners[3 * f + i]  = ( vertex << 32 ) | ( 3 * f + i );
+        }
+    } );
+    parallelSort( m_corners, std::less<uint64_t>() );
+    m_corners.resize( size_t(
+        std::lower_bound( m_corners.begin(), m_corners.end(), uint64_t( Invalid ) << 32 ) -
+        m_corners.begin() ) );
+    const size_t nc = m_corners.size();
+    ArenaVector<uint> begin( nVertices, 0, m_arena ), end( nVertices, 0, m_arena );
+    parallelFor( 0, nc, [&]( size_t j ) {
+        const size_t v = size_t( m_corners[j] >> 32 );
+        if ( j == 0 || ( m_corners[j - 1] >> 32 ) != v ) { begin[v] = uint( j ); }
+        if ( j + 1 == nc || ( m_corners[j + 1] >> 32 ) != v ) { end[v] = uint( j + 1 ); }
+    } );
+
+    // fans of each vertex: its faces linked across the edges of exactly two faces of opposite
+    // orientations
+    m_cornerFan.assign( nc, 0 );
+    m_fans.assign( nVertices, 0 );
+    std::atomic<size_t> nonManifoldEdges{0}, inconsistentEdges{0}, nonManifoldVertices{0};
+    parallelForRange( 0, nVertices, [&]( size_t first, size_t last ) {
+        std::vector<Neighbour> neighbours;
+        std::vector<uint> parent, fanOfRoot;
+        size_t edges = 0, inconsistent = 0, vertices = 0;
+        for ( size_t v = first; v < last; ++v )
+        {
+            const uint n = end[v] - begin[v];
+            if ( n == 0 ) { continue; }
+            neighbours.clear();
+            parent.resize( n );
+            for ( uint j = 0; j < n; ++j )
+            {
+                const uint corner = uint( m_corners[begin[v] + j] );
+                const auto& t     = triangles[corner / 3];
+                parent[j]         = j;
+                neighbours.push_back( {t( ( corner + 1 ) % 3 ), j, true} );
+                neighbours.push_back( {t( ( corner + 2 ) % 3 ), j, false} );
+            }
+            std::sort(
+                neighbours.begin(), neighbours.end(), []( const Neighbour& a, const Neighbour& b ) {
+                    return a.vertex < b.vertex;
+                } );
+            for ( size_t i = 0; i < neighbours.size(); )
+            {
+                size_t k = i + 1;
+                while ( k < neighbours.size() && neighbours[k].vertex == neighbours[i].vertex )
+                {
+                    ++k;
+                }
+                if ( k - i == 2 && neighbours[i].outgoing != neighbours[i + 1].outgoing )
+                { unite( parent, neighbours[i].corner, neighbours[i + 1].corner ); }
+                else if ( neighbours[i].vertex > v ) // each edge is counted by its first vertex
+                {
+                    edges += k - i > 2 ? 1 : 0;
+                    inconsistent += k - i == 2 ? 1 : 0;
+                }
+                i = k;
+            }
+            // fans are numbered in the order of their first corner, their root
+            uint fans = 0;
+            fanOfRoot.resize( n );
+            for ( uint j = 0; j < n; ++j )
+            {
+                const uint root = findRoot( parent, j );
+                if ( root == j ) { fanOfRoot[j] = fans++; }
+                m_cornerFan[begin[v] + j] = fanOfRoot[root];
+            }
+            m_fans[v] = fans;
+            vertices += fans > 1 ? 1 : 0;
+        }
+        nonManifoldEdges += edges;
+        inconsistentEdges += inconsistent;
+        nonManifoldVertices += vertices;
+    } );
+    defects.nonManifoldEdges    = nonManifoldEdges;
+    defects.inconsistentEdges   = inconsistentEdges;
+    defects.nonManifoldVertices = nonManifoldVertices;
+    return defects;
+}
+
+bool MeshValidator::repair( Geometry::TriangleMesh& mesh ) {
+    const size_t nv = mesh.vertices().size();
+
+    // a new vertex for each fan but the first
+    ArenaVector<uint> added( nv, m_arena );
+    for ( size_t v = 0; v < nv; ++v )
+    {
+        added[v] = m_fans[v] > 1 ? m_fans[v] - 1 : 0;
+    }
+    m_addedVertices = exclusiveScan( added );
+    bool copyable   = true;
+    mesh.vertexAttribs().for_each_attrib( [&copyable, nv]( AttribBase* attrib ) {
+        copyable = copyable && ( attrib->getSize() != nv || attrib->isFloat() ||
+                                 attrib->isVector2() || attrib->isVector3() ||
+                                 attrib->isVector4() );
+    } );
+    if ( m_addedVertices > 0 && !copyable )
+    {
+        LOG( logWARNING ) << "An attribute has an unsupported type, vertices cannot be split.";
+        m_addedVertices = 0;
+        return false;
+    }
+    ArenaVector<uint> origin( m_addedVertices, m_arena );
+    parallelFor( 0, nv, [&]( size_t v ) {
+        for ( uint fan = 1; fan < m_fans[v]; ++fan )
+        {
+            origin[added[v] + fan - 1] = uint( v );
+        }
+    } );
+    mesh.vertexAttribs().for_each_attrib( [&origin, nv]( AttribBase* attrib ) {
+        if ( attrib->getSize() != nv ) { return; }
+        if ( attrib->isFloat() ) { appendCopies<Scalar>( attrib, origin ); }
+        else if ( attrib->isVector2() )
+        { appendCopies<Vector2>( attrib, origin ); }
+        else if ( attrib->isVector3() )
+        { appendCopies<Vector3>( attrib, origin ); }
+        else
+        { appendCopies<Vector4>( attrib, origin ); }
+    } );
+
+    // corners of the other fans use the new vertices, and the defective faces are dropped
+    auto triangles = mesh.getIndices();
+    parallelFor( 0, m_corners.size(), [&]( size_t j ) {
+        const uint fan = m_cornerFan[j];
+        if ( fan == 0 ) { return; }
+        const uint corner              = uint( m_corners[j] );
+        const size_t v                 = size_t( m_corners[j] >> 32 );
+        triangles[corner / 3]( corner % 3 ) = uint( nv + added[v] + fan - 1 );
+    } );
+    size_t kept = 0;
+    for ( size_t f = 0; f < triangles.size(); ++f )
+    {
+        if ( m_faceDefect[f] == 0 ) { triangles[kept++] = triangles[f]; }
+    }
+    m_droppedFaces = triangles.size() - kept;
+    triangles.resize( kept );
+    mesh.setIndices( std::move( triangles ) );
+    return true;
+}
+
+bool MeshValidator::operator()( Geometry::TriangleMesh& mesh ) {
+    m_droppedFaces  = 0;
+    m_addedVertices = 0;
+    m_defects       = analyze( mesh.getIndices(), mesh.vertices().size() );
+    if ( m_defects.empty() ) { return true; }
+    if ( !m_repair || !repair( mesh ) ) { return false; }
+    // splitting the fans of a vertex may not separate all the faces of an edge
+    return analyze( mesh.getIndices(), mesh.vertices().size() ).empty();
+}
+
+} // namespace Subdivision
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Arena.hpp"
+
+#include <Core/Geometry/TriangleMesh.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// Manifold check of the input, before the OpenMesh TopologicalMesh is built.
+enum class ManifoldCheck {
+    /// Check when the TopologicalMesh is built (openmesh engine), off otherwise
+    Auto,
+    Off,
+    /// Reject meshes with defects
+    Check,
+    /// Repair the defects (MeshValidator), reject the meshes that remain invalid
+    Repair
+};
+
+/// Parse a manifold check name: off, check or repair. Returns false if the name is unknown.
+bool manifoldCheckFromName( const std::string& name, ManifoldCheck& check );
+
+/// Defects of a triangle mesh that a half-edge structure cannot represent.
+struct MeshDefects {
+    /// Faces with a repeated or out of range vertex
+    size_t degenerateFaces{0};
+    /// Faces with the same vertices as a previous face, whatever their orientation
+    size_t duplicateFaces{0};
+    /// Edges of more than two faces
+    size_t nonManifoldEdges{0};
+    /// Edges of two faces that use it in the same direction
+    size_t inconsistentEdges{0};
+    /// Vertices whose faces form several fans (bow ties, vertices of the above edges)
+    size_t nonManifoldVertices{0};
+
+    inline bool empty() const {
+        return degenerateFaces + duplicateFaces + nonManifoldEdges + inconsistentEdges +
+                   nonManifoldVertices ==
+               0;
+    }
+    /// One line summary, for the log.
+    std::string toString() const;
+};
+
+/// Parallel detection, and optional repair, of the defects that make the construction of a
+/// TopologicalMesh fail or crawl, so that bad files are rejected before minutes of work.
+///
+/// Duplicate faces are found by sorting the faces by their sorted vertices, and the corners by
+/// sorting them by vertex, both with parallelSort. The faces around each vertex are then linked,
+/// in parallel, across the edges shared by exactly two faces of opposite orientations: several
+/// resulting fans make a non-manifold vertex, and the other edges are counted as non-manifold
+/// (more than two faces) or inconsistent (same orientation).
+///
+/// The repair drops the degenerate and duplicate faces, and splits every non-manifold vertex
+/// into one vertex per fan, with copies of its attributes. Non-manifold and inconsistent edges
+/// are separated in the process, as their faces end up in different fans.
+///
+/// The buffers of the check, all released with the validator, are served by \p arena when one is
+/// given.
+class MeshValidator
+{
+  public:
+    explicit MeshValidator( bool repair = false, Arena* arena = nullptr ) :
+        m_repair( repair ),
+        m_arena( arena ),
+        m_faceDefect( arena ),
+        m_corners( arena ),
+        m_cornerFan( arena ),
+        m_fans( arena ) {}
+
+    /// Check \p mesh, and repair it in repair mode. Returns true if \p mesh is (now) free of
+    /// defects.
+    bool operator()( Ra::Core::Geometry::TriangleMesh& mesh );
+
+    /// Defects of the input of the last run.
+    inline const MeshDefects& defects() const { return m_defects; }
+    /// Faces dropped and vertices added by the last repair.
+    inline size_t droppedFaces() const { return m_droppedFaces; }
+    inline size_t addedVertices() const { return m_addedVertices; }
+
+  private:
+    /// Find the defects of \p triangles. Sets the members below.
+    MeshDefects
+    analyze( const Ra::Core::Geometry::TriangleMesh::IndexContainerType& triangles,
+             size_t nVertices );
+    /// Drop the defective faces and split the vertices of several fans.
+    bool repair( Ra::Core::Geometry::TriangleMesh& mesh );
+
+    bool m_repair;
+    Arena* m_arena;
+    MeshDefects m_defects;
+    size_t m_droppedFaces{0};
+    size_t m_addedVertices{0};
+
+    /// Per face: 0 if valid, 1 if degenerate, 2 if duplicate
+    ArenaVector<char> m_faceDefect;
+    /// Corners (3 * face + corner) of the valid faces, sorted by vertex, with their vertex in the
+    /// high bits
+    ArenaVector<uint64_t> m_corners;
+    /// Fan of each corner of m_corners, and number of fans of each vertex
+    ArenaVector<uint> m_cornerFan;
+    ArenaVector<uint> m_fans;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,429 @@
+#include "MeshWriter.hpp"
+#include "Parallel.hpp"
+
+#include <Core/Geometry/StandardAttribNames.hpp>
+#include <Core/Utils/Log.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+bool outputFormatFromName( const std::string& name, OutputFormat& format ) {
+    if ( name == "obj" ) { format = OutputFormat::Obj; }
+    else if ( name == "ply" )
+    { format = OutputFormat::Ply; }
+    else if ( name == "rbm" )
+    { format = OutputFormat::Binary; }
+    else
+    { return false; }
+    return true;
+}
+
+std::string outputExtension( OutputFormat format ) {
+    switch ( format )
+    {
+    case OutputFormat::Ply:
+        return ".ply";
+    case OutputFormat::Binary:
+        return ".rbm";
+    default:
+        return ".obj";
+    }
+}
+
+MeshBuffers MeshBuffers::fromTriangleMesh( const Geometry::TriangleMesh& mesh ) {
+    MeshBuffers ret;
+    ret.positions   = mesh.vertices().data();
+    ret.vertexCount = mesh.vertices().size();
+    ret.normals = mesh.normals().size() == ret.vertexCount ? mesh.normals().data() : nullptr;
+    auto texcoords = mesh.getAttribHandle<Vector3>(
+        Geometry::getAttribName( Geometry::MeshAttrib::VERTEX_TEXCOORD ) );
+    if ( mesh.isValid( texcoords ) && mesh.getAttrib( texcoords ).data().size() == ret.vertexCount )
+    { ret.texcoords = mesh.getAttrib( texcoords ).data().data(); }
+    ret.indices = mesh.getIndices().empty() ? nullptr : mesh.getIndices()[0].data();
+    ret.faceCount = mesh.getIndices().size();
+    ret.faceSize  = 3;
+    return ret;
+}
+
+MeshBuffers MeshBuffers::fromFlatMesh( const FlatMesh& mesh, const Vector3Array& normals ) {
+    MeshBuffers ret;
+    ret.positions   = mesh.positions.data();
+    ret.vertexCount = mesh.nVertices();
+    ret.normals     = normals.size() == ret.vertexCount ? normals.data() : nullptr;
+    ret.indices     = mesh.faceIndices.empty() ? nullptr : mesh.faceIndices.data();
+    ret.faceCount   = mesh.nFaces();
+    ret.faceSize    = mesh.nFaces() > 0 ? mesh.faceSize( 0 ) : 3;
+    return ret;
+}
+
+namespace {
+
+static_assert( sizeof( Vector3ui ) == 3 * sizeof( uint ), "Vector3ui must be packed" );
+
+bool isLittleEndian() {
+    const uint16_t one = 1;
+    char c;
+    std::memcpy( &c, &one, 1 );
+    return c == 1;
+}
+
+/// Output file with a large write buffer. Blocks larger than the buffer are written directly.
+class BufferedFile
+{
+  public:
+    static constexpr size_t BufferSize = size_t( 1 ) << 23;
+
+    explicit BufferedFile( const std::string& filename, bool append = false ) :
+        m_file( std::fopen( filename.c_str(), append ? "ab" : "wb" ) ) {
+        if ( m_file ) { std::setvbuf( m_file, nullptr, _IOFBF, BufferSize ); }
+    }
+    ~BufferedFile() {
+        if ( m_file ) { std::fclose( m_file ); }
+    }
+
+    inline bool isOpen() const { return m_file != nullptr; }
+    inline bool good() const { return m_good; }
+
+    void write( const void* data, size_t size ) {
+        if ( m_good && size > 0 ) { m_good = std::fwrite( data, 1, size, m_file ) == size; }
+    }
+
+    /// Write vectors as float32 triplets, converting when Scalar is not float.
+    void writeVector3( const Vector3* data, size_t n ) {
+        if ( std::is_same<Scalar, float>::value && sizeof( Vector3 ) == 3 * sizeof( float ) )
+        {
+            write( data, n * sizeof( Vector3 ) );
+            return;
+        }
+        std::vector<float> block;
+        const size_t blockSize = BufferSize / ( 3 * sizeof( float ) );
+        for ( size_t b = 0; b < n; b += blockSize )
+        {
+            const size_t e = std::min( n, b + blockSize );
+            block.resize( 3 * ( e - b ) );
+            for ( size_t i = b; i < e; ++i )
+            {
+                for ( int k = 0; k < 3; ++k )
+                {
+                    block[3 * ( i - b ) + k] = float( data[i]( k ) );
+                }
+            }
+            write( block.data(), block.size() * sizeof( float ) );
+        }
+    }
+
+    bool close() {
+        if ( m_file )
+        {
+            m_good = ( std::fclose( m_file ) == 0 ) && m_good;
+            m_file = nullptr;
+        }
+        return m_good;
+    }
+
+  private:
+    std::FILE* m_file;
+    bool m_good{true};
+};
+
+/// Write \p n text lines, formatted in parallel by blocks and written in order.
+/// \p format( i, out ) writes line i (at most \p maxLineSize characters) to out and returns its
+/// length.
+template <typename Format>
+void writeLines( BufferedFile& file, size_t n, size_t maxLineSize, Format&& format ) {
+    const size_t linesPerBlock = size_t( 1 ) << 14;
+    const size_t nBlocks       = ( n + linesPerBlock - 1 ) / linesPerBlock;
+    // a few blocks per thread are kept in memory at a time
+    const size_t batch = 4 * size_t( threadCount() );
+    std::vector<std::string> blocks( std::min( batch, nBlocks ) );
+    for ( size_t b0 = 0; b0 < nBlocks; b0 += batch )
+    {
+        const size_t b1 = std::min( nBlocks, b0 + batch );
+        parallelFor(
+            b0,
+            b1,
+            [&]( size_t b ) {
+                const size_t first = b * linesPerBlock;
+                const size_t last  = std::min( n, first + linesPerBlock );
+                std::string& text  = blocks[b - b0];
+                // room for the terminating null character of snprintf
+                text.resize( ( last - first ) * maxLineSize + 1 );
+                char* out = &text[0];
+                for ( size_t i = first; i < last; ++i )
+                {
+                    out += format( i, out );
+                }
+                text.resize( size_t( out - text.data() ) );
+            },
+            1 );
+        for ( size_t b = b0; b < b1; ++b )
+        {
+            file.write( blocks[b - b0].data(), blocks[b - b0].size() );
+        }
+    }
+}
+
+} // namespace
+
+bool writeObj( const std::string& filename, const MeshBuffers& mesh ) {
+    using namespace Ra::Core::Utils; // log
+    BufferedFile file( filename );
+    if ( !file.isOpen() )
+    {
+        LOG( logERROR ) << "Cannot open " << filename << " for writing.";
+        return false;
+    }
+
+    // same number format as the ostream of Ra::IO::OBJFileManager
+    const size_t vectorLineSize = 48;
+    auto vectorLine = [vectorLineSize]( const char* prefix, const Vector3& v, char* out ) {
+        return std::snprintf( out,
+                              vectorLineSize + 1,
+                              "%s %g %g %g\n",
+                              prefix,
+                              double( v( 0 ) ),
+                              double( v( 1 ) ),
+                              double( v( 2 ) ) );
+    };
+    writeLines( file, mesh.vertexCount, vectorLineSize, [&]( size_t i, char* out ) {
+        return vectorLine( "v", mesh.positions[i], out );
+    } );
+    if ( mesh.normals != nullptr )
+    {
+        writeLines( file, mesh.vertexCount, vectorLineSize, [&]( size_t i, char* out ) {
+            return vectorLine( "vn", mesh.normals[i], out );
+        } );
+    }
+    if ( mesh.texcoords != nullptr )
+    {
+        writeLines( file, mesh.vertexCount, vectorLineSize, [&]( size_t i, char* out ) {
+            const Vector3& t = mesh.texcoords[i];
+            return std::snprintf(
+                out, vectorLineSize + 1, "vt %g %g\n", double( t( 0 ) ), double( t( 1 ) ) );
+        } );
+    }
+
+    // 1-based indices, "f a/a/a b/b/b ..." with the texture coordinates and normals that exist
+    const char* corner = mesh.texcoords != nullptr
+                             ? ( mesh.normals != nullptr ? " %u/%u/%u" : " %u/%u" )
+                             : ( mesh.normals != nullptr ? " %u//%u" : " %u" );
+    writeLines( file, mesh.faceCount, 2 + 34 * mesh.faceSize, [&]( size_t f, char* out ) {
+        const uint* face = mesh.indices + f * mesh.faceSize;
+        char* start      = out;
+        *out++           = 'f';
+        for ( uint k = 0; k < mesh.faceSize; ++k )
+        {
+            const uint i = face[k] + 1;
+            out += std::snprintf( out, 35, corner, i, i, i );
+        }
+        *out++ = '\n';
+        return int( out - start );
+    } );
+    return file.close();
+}
+
+bool writePly( const std::string& filename, const MeshBuffers& mesh ) {
+    using namespace Ra::Core::Utils; // log
+    if ( !isLittleEndian() )
+    {
+        LOG( logERROR ) << "Binary output is only supported on little-endian hosts.";
+        return false;
+    }
+    BufferedFile file( filename );
+    if ( !file.isOpen() )
+    {
+        LOG( logERROR ) << "Cannot open " << filename << " for writing.";
+        return false;
+    }
+
+    std::string header = "ply\nformat binary_little_endian 1.0\n";
+    header += "element vertex " + std::to_string( mesh.vertexCount ) + "\n";
+    header += "property float x\nproperty float y\nproperty float z\n";
+    if ( mesh.normals != nullptr )
+    { header += "property float nx\nproperty float ny\nproperty float nz\n"; }
+    header += "element face " + std::to_string( mesh.faceCount ) + "\n";
+    header += "property list uchar uint vertex_indices\nend_header\n";
+    file.write( header.data(), header.size() );
+
+    // vertex records interleave positions and normals
+    if ( mesh.normals == nullptr ) { file.writeVector3( mesh.positions, mesh.vertexCount ); }
+    else
+    {
+        const size_t blockSize = BufferedFile::BufferSize / ( 6 * sizeof( float ) );
+        std::vector<float> block;
+        for ( size_t b = 0; b < mesh.vertexCount; b += blockSize )
+        {
+            const size_t e = std::min( mesh.vertexCount, b + blockSize );
+            block.resize( 6 * ( e - b ) );
+            float* out = block.data();
+            for ( size_t i = b; i < e; ++i )
+            {
+                for ( int k = 0; k < 3; ++k )
+                {
+                    *out++ = float( mesh.positions[i]( k ) );
+                }
+                for ( int k = 0; k < 3; ++k )
+                {
+                    *out++ = float( mesh.normals[i]( k ) );
+                }
+            }
+            file.write( block.data(), block.size() * sizeof( float ) );
+        }
+    }
+
+    // face records: uchar count followed by the indices
+    const size_t recordSize = 1 + mesh.faceSize * sizeof( uint32_t );
+    const size_t blockSize  = BufferedFile::BufferSize / recordSize;
+    std::vector<char> block;
+    for ( size_t b = 0; b < mesh.faceCount; b += blockSize )
+    {
+        const size_t e = std::min( mesh.faceCount, b + blockSize );
+        block.resize( recordSize * ( e - b ) );
+        char* out = block.data();
+        for ( size_t f = b; f < e; ++f )
+        {
+            *out++ = char( mesh.faceSize );
+            std::memcpy( out, mesh.indices + f * mesh.faceSize, mesh.faceSize * sizeof( uint32_t ) );
+            out += mesh.faceSize * sizeof( uint32_t );
+        }
+        file.write( block.data(), block.size() );
+    }
+    return file.close();
+}
+
+bool writeBinaryMesh( const std::string& filename, const MeshBuffers& mesh, bool append ) {
+    using namespace Ra::Core::Utils; // log
+    if ( !isLittleEndian() )
+    {
+        LOG( logERROR ) << "Binary output is only supported on little-endian hosts.";
+        return false;
+    }
+    BufferedFile file( filename, append );
+    if ( !file.isOpen() )
+    {
+        LOG( logERROR ) << "Cannot open " << filename << " for writing.";
+        return false;
+    }
+
+    BinaryMeshHeader header;
+    header.faceSize    = mesh.faceSize;
+    header.flags       = mesh.normals != nullptr ? BinaryMeshHeader::HasNormals : 0;
+    header.vertexCount = mesh.vertexCount;
+    header.faceCount   = mesh.faceCount;
+    file.write( &header, sizeof( header ) );
+
+    // buffers are written as is, one call per block
+    file.writeVector3( mesh.positions, mesh.vertexCount );
+    if ( mesh.normals != nullptr ) { file.writeVector3( mesh.normals, mesh.vertexCount ); }
+    file.write( mesh.indices, mesh.faceCount * mesh.faceSize * sizeof( uint32_t ) );
+    return file.close();
+}
+
+bool MeshFileWriter::open( const std::string& filename,
+                           OutputFormat format,
+                           size_t vertexCount,
+                           size_t faceCount,
+                           uint faceSize ) {
+    using namespace Ra::Core::Utils; // log
+    if ( !isLittleEndian() )
+    {
+        LOG( logERROR ) << "Binary output is only supported on little-endian hosts.";
+        return false;
+    }
+    close();
+    m_file = std::fopen( filename.c_str(), "wb" );
+    if ( m_file == nullptr )
+    {
+        LOG( logERROR ) << "Cannot open " << filename << " for writing.";
+        return false;
+    }
+    m_format   = format;
+    m_faceSize = faceSize;
+    m_good     = true;
+
+    if ( format == OutputFormat::Ply )
+    {
+        std::string header = "ply\nformat binary_little_endian 1.0\n";
+        header += "element vertex " + std::to_string( vertexCount ) + "\n";
+        header += "property float x\nproperty float y\nproperty float z\n";
+        header += "element face " + std::to_string( faceCount ) + "\n";
+        header += "property list uchar uint vertex_indices\nend_header\n";
+        write( 0, header.data(), header.size() );
+        m_vertexStart = header.size();
+        m_faceStart   = m_vertexStart + uint64_t( vertexCount ) * 3 * sizeof( float );
+    }
+    else
+    {
+        BinaryMeshHeader header;
+        header.faceSize    = faceSize;
+        header.vertexCount = vertexCount;
+        header.faceCount   = faceCount;
+        write( 0, &header, sizeof( header ) );
+        m_vertexStart = sizeof( header );
+        m_faceStart   = m_vertexStart + uint64_t( vertexCount ) * 3 * sizeof( float );
+    }
+    return m_good;
+}
+
+void MeshFileWriter::writeVertices( size_t first, const Vector3* positions, size_t n ) {
+    std::vector<float> block( 3 * n );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        for ( int k = 0; k < 3; ++k )
+        {
+            block[3 * i + k] = float( positions[i]( k ) );
+        }
+    }
+    write( m_vertexStart + uint64_t( first ) * 3 * sizeof( float ),
+           block.data(),
+           block.size() * sizeof( float ) );
+}
+
+void MeshFileWriter::writeFaces( size_t first, const uint* indices, size_t n ) {
+    if ( m_format == OutputFormat::Binary )
+    {
+        write( m_faceStart + uint64_t( first ) * m_faceSize * sizeof( uint32_t ),
+               indices,
+               n * m_faceSize * sizeof( uint32_t ) );
+        return;
+    }
+    const size_t recordSize = 1 + m_faceSize * sizeof( uint32_t );
+    std::vector<char> block( recordSize * n );
+    char* out = block.data();
+    for ( size_t f = 0; f < n; ++f )
+    {
+        *out++ = char( m_faceSize );
+        std::memcpy( out, indices + f * m_faceSize, m_faceSize * sizeof( uint32_t ) );
+        out += m_faceSize * sizeof( uint32_t );
+    }
+    write( m_faceStart + uint64_t( first ) * recordSize, block.data(), block.size() );
+}
+
+void MeshFileWriter::write( uint64_t offset, const void* data, size_t size ) {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( !m_good || size == 0 ) { return; }
+#ifdef _WIN32
+    m_good = _fseeki64( m_file, int64_t( offset ), SEEK_SET ) == 0;
+#else
+    m_good = fseeko( m_file, off_t( offset ), SEEK_SET ) == 0;
+#endif
+    m_good = m_good && std::fwrite( data, 1, size, m_file ) == size;
+}
+
+bool MeshFileWriter::close() {
+    if ( m_file )
+    {
+        m_good = ( std::fclose( m_file ) == 0 ) && m_good;
+        m_file = nullptr;
+    }
+    return m_good;
+}
+
+} // namespace Subdivision
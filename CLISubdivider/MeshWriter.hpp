@@ -0,0 +1,108 @@
+#pragma once
+
+#include "FlatMesh.hpp"
+
+#include <Core/Geometry/TriangleMesh.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace Subdivision {
+
+enum class OutputFormat { Obj, Ply, Binary };
+
+/// Parse "obj", "ply" or "rbm". Returns false if the name is unknown.
+bool outputFormatFromName( const std::string& name, OutputFormat& format );
+
+/// File extension (with the dot) used for \p format.
+std::string outputExtension( OutputFormat format );
+
+/// Header of the raw binary mesh container (.rbm). All values are little-endian.
+///
+/// | offset | content                                                  |
+/// |--------|----------------------------------------------------------|
+/// | 0      | BinaryMeshHeader (32 bytes)                              |
+/// | 32     | vertexCount positions, 3 x float32 each                  |
+/// | ...    | vertexCount normals, 3 x float32 each (if HasNormals)    |
+/// | ...    | faceCount faces, faceSize x uint32 each                  |
+///
+/// Every block is 4 bytes aligned, so a memory-mapped file can be used in place.
+struct BinaryMeshHeader {
+    static constexpr uint32_t HasNormals = 1;
+
+    char magic[4]{'R', 'B', 'M', '\0'};
+    uint32_t version{1};
+    uint32_t faceSize{3};
+    uint32_t flags{0};
+    uint64_t vertexCount{0};
+    uint64_t faceCount{0};
+};
+static_assert( sizeof( BinaryMeshHeader ) == 32, "BinaryMeshHeader must be packed" );
+
+/// Non owning view of the buffers of a mesh with faces of constant size.
+struct MeshBuffers {
+    const Ra::Core::Vector3* positions{nullptr};
+    const Ra::Core::Vector3* normals{nullptr};   ///< may be null
+    const Ra::Core::Vector3* texcoords{nullptr}; ///< may be null, only written to OBJ
+    size_t vertexCount{0};
+    const uint* indices{nullptr};
+    size_t faceCount{0};
+    uint faceSize{3};
+
+    static MeshBuffers fromTriangleMesh( const Ra::Core::Geometry::TriangleMesh& mesh );
+    /// View of a FlatMesh whose faces all have the size of the first one.
+    /// \p normals are ignored unless there is one per vertex.
+    static MeshBuffers fromFlatMesh( const FlatMesh& mesh, const Ra::Core::Vector3Array& normals );
+};
+
+/// Write \p mesh to \p filename as OBJ text (positions, normals, texture coordinates and polygons
+/// of any size).
+/// Lines are formatted in parallel.
+bool writeObj( const std::string& filename, const MeshBuffers& mesh );
+
+/// Write \p mesh to \p filename in binary little-endian PLY.
+bool writePly( const std::string& filename, const MeshBuffers& mesh );
+
+/// Write \p mesh to \p filename in the raw binary container described by BinaryMeshHeader.
+/// With \p append, the record is added at the end of the file: a file may hold several records
+/// back to back (levels of detail), each one starting with its header.
+bool writeBinaryMesh( const std::string& filename, const MeshBuffers& mesh, bool append = false );
+
+/// Binary (ply or rbm) mesh file whose vertex and face counts are known when it is opened.
+/// Records have a fixed size, so blocks of vertices and faces can be written at their final place,
+/// in any order and from several threads. No normals are written.
+class MeshFileWriter
+{
+  public:
+    ~MeshFileWriter() { close(); }
+
+    /// Create \p filename and write its header. \p format must be Ply or Binary.
+    bool open( const std::string& filename,
+               OutputFormat format,
+               size_t vertexCount,
+               size_t faceCount,
+               uint faceSize );
+
+    /// Write positions of vertices [first, first + n).
+    void writeVertices( size_t first, const Ra::Core::Vector3* positions, size_t n );
+    /// Write faces [first, first + n), faceSize indices each.
+    void writeFaces( size_t first, const uint* indices, size_t n );
+
+    /// Returns false if any write failed.
+    bool close();
+
+  private:
+    void write( uint64_t offset, const void* data, size_t size );
+
+    std::FILE* m_file{nullptr};
+    std::mutex m_mutex;
+    OutputFormat m_format{OutputFormat::Binary};
+    uint m_faceSize{3};
+    uint64_t m_vertexStart{0};
+    uint64_t m_faceStart{0};
+    bool m_good{true};
+};
+
+} // namespace Subdivision
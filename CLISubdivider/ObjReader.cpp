@@ -0,0 +1,418 @@
+#include "ObjReader.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+
+#include <Core/Geometry/StandardAttribNames.hpp>
+#include <Core/Utils/Log.hpp>
+#include <Core/Utils/Timer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+namespace {
+
+/// Offset applied to relative (negative) OBJ indices, which are stored as
+/// ( index in the chunk - RelativeTag ) and resolved once the vertex count of the previous
+/// chunks is known.
+constexpr int64_t RelativeTag = int64_t( 1 ) << 62;
+
+/// Texture index of a face corner without texture coordinate.
+constexpr int64_t NoTexcoord = -1;
+
+/// Parsed content of one chunk of the file. Absolute face indices are stored 0-based.
+struct Chunk {
+    Vector3Array vertices;
+    Vector3Array normals;
+    Vector3Array texcoords;
+    std::vector<int64_t> indices;
+    /// parallel to indices, when texture coordinates are read
+    std::vector<int64_t> texIndices;
+};
+
+inline bool isBlank( char c ) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline void skipBlanks( const char*& p, const char* end ) {
+    while ( p < end && isBlank( *p ) )
+    {
+        ++p;
+    }
+}
+
+inline void skipLine( const char*& p, const char* end ) {
+    while ( p < end && *p != '\n' )
+    {
+        ++p;
+    }
+    if ( p < end ) { ++p; }
+}
+
+/// Parse a decimal floating point number in [p, end), advance p.
+inline Scalar parseScalar( const char*& p, const char* end ) {
+    static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    skipBlanks( p, end );
+    bool negative = false;
+    if ( p < end && ( *p == '-' || *p == '+' ) ) { negative = *p++ == '-'; }
+
+    uint64_t mantissa = 0;
+    int exponent      = 0;
+    int digits        = 0;
+    for ( ; p < end && *p >= '0' && *p <= '9'; ++p )
+    {
+        if ( digits < 18 )
+        {
+            mantissa = mantissa * 10 + uint64_t( *p - '0' );
+            ++digits;
+        }
+        else
+        { ++exponent; }
+    }
+    if ( p < end && *p == '.' )
+    {
+        for ( ++p; p < end && *p >= '0' && *p <= '9'; ++p )
+        {
+            if ( digits < 18 )
+            {
+                mantissa = mantissa * 10 + uint64_t( *p - '0' );
+                ++digits;
+                --exponent;
+            }
+        }
+    }
+    if ( p < end && ( *p == 'e' || *p == 'E' ) )
+    {
+        ++p;
+        bool negExp = false;
+        if ( p < end && ( *p == '-' || *p == '+' ) ) { negExp = *p++ == '-'; }
+        int e = 0;
+        for ( ; p < end && *p >= '0' && *p <= '9'; ++p )
+        {
+            e = e * 10 + ( *p - '0' );
+        }
+        exponent += negExp ? -e : e;
+    }
+
+    double value = double( mantissa );
+    while ( exponent > 22 )
+    {
+        value *= 1e22;
+        exponent -= 22;
+    }
+    while ( exponent < -22 )
+    {
+        value /= 1e22;
+        exponent += 22;
+    }
+    value = exponent >= 0 ? value * powers[exponent] : value / powers[-exponent];
+    return Scalar( negative ? -value : value );
+}
+
+/// Parse a signed OBJ index, advance p.
+inline int64_t parseIndex( const char*& p, const char* end ) {
+    bool negative = false;
+    if ( p < end && ( *p == '-' || *p == '+' ) ) { negative = *p++ == '-'; }
+    int64_t v = 0;
+    for ( ; p < end && *p >= '0' && *p <= '9'; ++p )
+    {
+        v = v * 10 + ( *p - '0' );
+    }
+    return negative ? -v : v;
+}
+
+/// Parse the vertex and texture parts of a face element ("v", "v/vt", "v//vn" or "v/vt/vn"),
+/// advance p to the next element. \p texIndex is 0 when absent.
+/// Returns false if there is no element left on the line.
+inline bool
+parseFaceElement( const char*& p, const char* end, int64_t& index, int64_t& texIndex ) {
+    skipBlanks( p, end );
+    if ( p >= end || *p == '\n' ) { return false; }
+    index    = parseIndex( p, end );
+    texIndex = 0;
+    if ( p < end && *p == '/' )
+    {
+        ++p;
+        texIndex = parseIndex( p, end );
+    }
+    // skip the normal index
+    while ( p < end && !isBlank( *p ) && *p != '\n' )
+    {
+        ++p;
+    }
+    return true;
+}
+
+void parseChunk( const char* p, const char* end, bool texcoords, Chunk& chunk ) {
+    std::vector<int64_t> polygon, texPolygon;
+    while ( p < end )
+    {
+        skipBlanks( p, end );
+        if ( p + 1 < end && p[0] == 'v' && isBlank( p[1] ) )
+        {
+            p += 2;
+            Vector3 v;
+            v.x() = parseScalar( p, end );
+            v.y() = parseScalar( p, end );
+            v.z() = parseScalar( p, end );
+            chunk.vertices.push_back( v );
+        }
+        else if ( p + 2 < end && p[0] == 'v' && p[1] == 'n' && isBlank( p[2] ) )
+        {
+            p += 3;
+            Vector3 n;
+            n.x() = parseScalar( p, end );
+            n.y() = parseScalar( p, end );
+            n.z() = parseScalar( p, end );
+            chunk.normals.push_back( n );
+        }
+        else if ( texcoords && p + 2 < end && p[0] == 'v' && p[1] == 't' && isBlank( p[2] ) )
+        {
+            p += 3;
+            Vector3 t;
+            t.x() = parseScalar( p, end );
+            t.y() = parseScalar( p, end );
+            skipBlanks( p, end );
+            t.z() = p < end && *p != '\n' ? parseScalar( p, end ) : 0;
+            chunk.texcoords.push_back( t );
+        }
+        else if ( p + 1 < end && p[0] == 'f' && isBlank( p[1] ) )
+        {
+            p += 2;
+            polygon.clear();
+            texPolygon.clear();
+            int64_t i, t;
+            while ( parseFaceElement( p, end, i, t ) )
+            {
+                if ( i > 0 ) { polygon.push_back( i - 1 ); }
+                else if ( i < 0 )
+                { polygon.push_back( int64_t( chunk.vertices.size() ) + i - RelativeTag ); }
+                else
+                { continue; }
+                if ( t > 0 ) { texPolygon.push_back( t - 1 ); }
+                else if ( t < 0 )
+                { texPolygon.push_back( int64_t( chunk.texcoords.size() ) + t - RelativeTag ); }
+                else
+                { texPolygon.push_back( NoTexcoord ); }
+            }
+            for ( size_t k = 1; k + 1 < polygon.size(); ++k )
+            {
+                chunk.indices.push_back( polygon[0] );
+                chunk.indices.push_back( polygon[k] );
+                chunk.indices.push_back( polygon[k + 1] );
+                if ( texcoords )
+                {
+                    chunk.texIndices.push_back( texPolygon[0] );
+                    chunk.texIndices.push_back( texPolygon[k] );
+                    chunk.texIndices.push_back( texPolygon[k + 1] );
+                }
+            }
+        }
+        skipLine( p, end );
+    }
+}
+
+Vector3Array computeNormals( const Vector3Array& vertices,
+                             const Geometry::TriangleMesh::IndexContainerType& tris ) {
+    Vector3Array normals( vertices.size(), Vector3::Zero() );
+    for ( const auto& t : tris )
+    {
+        const Vector3 n = ( vertices[t( 1 )] - vertices[t( 0 )] )
+                              .cross( vertices[t( 2 )] - vertices[t( 0 )] );
+        for ( int i = 0; i < 3; ++i )
+        {
+            normals[t( i )] += n;
+        }
+    }
+    parallelFor( 0, normals.size(), [&]( size_t v ) { normals[v].normalize(); } );
+    return normals;
+}
+
+/// Give each distinct ( vertex, texture coordinate ) pair of the corners its own vertex.
+/// On return, \p texcoords has one element per vertex, and \p positionIndices gives the
+/// original vertex of each one.
+void splitTexcoordSeams( Vector3Array& vertices,
+                         Vector3Array& normals,
+                         Vector3Array& texcoords,
+                         Geometry::TriangleMesh::IndexContainerType& tris,
+                         const std::vector<uint>& texIndices,
+                         std::vector<uint>& positionIndices ) {
+    std::vector<uint64_t> cornerKeys( texIndices.size() );
+    parallelFor( 0, tris.size(), [&]( size_t t ) {
+        for ( uint i = 0; i < 3; ++i )
+        {
+            cornerKeys[3 * t + i] = ( uint64_t( tris[t]( i ) ) << 32 ) | texIndices[3 * t + i];
+        }
+    } );
+    std::vector<uint64_t> keys = cornerKeys;
+    parallelSort( keys, std::less<uint64_t>() );
+    keys.erase( std::unique( keys.begin(), keys.end() ), keys.end() );
+
+    // new vertices in ( vertex, texture coordinate ) order
+    Vector3Array splitVertices( keys.size() ), splitNormals( keys.size() );
+    Vector3Array splitTexcoords( keys.size() );
+    positionIndices.resize( keys.size() );
+    parallelFor( 0, keys.size(), [&]( size_t v ) {
+        const uint vertex  = uint( keys[v] >> 32 );
+        positionIndices[v] = vertex;
+        splitVertices[v]   = vertices[vertex];
+        splitNormals[v]   = normals[vertex];
+        splitTexcoords[v] = texcoords[uint( keys[v] )];
+    } );
+    parallelFor( 0, tris.size(), [&]( size_t t ) {
+        for ( uint i = 0; i < 3; ++i )
+        {
+            const uint64_t key = cornerKeys[3 * t + i];
+            tris[t]( i ) = uint( std::lower_bound( keys.begin(), keys.end(), key ) - keys.begin() );
+        }
+    } );
+    vertices  = std::move( splitVertices );
+    normals   = std::move( splitNormals );
+    texcoords = std::move( splitTexcoords );
+}
+
+} // namespace
+
+bool ObjReader::load( const std::string& filename, Geometry::TriangleMesh& mesh ) {
+    using namespace Ra::Core::Utils; // log, timer
+    auto start = Clock::now();
+
+    MappedFile file;
+    if ( !file.open( filename ) )
+    {
+        LOG( logERROR ) << "Cannot open " << filename;
+        return false;
+    }
+    if ( !parse( file.data(), file.size(), mesh, filename ) ) { return false; }
+    m_stats.seconds = getIntervalSeconds( start, Clock::now() );
+    return true;
+}
+
+bool ObjReader::parse( const char* data,
+                       size_t n,
+                       Geometry::TriangleMesh& mesh,
+                       const std::string& filename ) {
+    using namespace Ra::Core::Utils; // log, timer
+    auto start = Clock::now();
+
+    // line aligned chunk boundaries
+    const size_t nChunks = std::max<size_t>( 1, std::min<size_t>( 4 * threadCount(), n >> 16 ) );
+    std::vector<size_t> bounds( nChunks + 1, n );
+    bounds[0] = 0;
+    for ( size_t c = 1; c < nChunks; ++c )
+    {
+        size_t b = std::max( bounds[c - 1], c * ( n / nChunks ) );
+        while ( b < n && data[b - 1] != '\n' )
+        {
+            ++b;
+        }
+        bounds[c] = b;
+    }
+
+    std::vector<Chunk> chunks( nChunks );
+    parallelFor(
+        0,
+        nChunks,
+        [&]( size_t c ) {
+            parseChunk( data + bounds[c], data + bounds[c + 1], m_texcoords, chunks[c] );
+        },
+        1 );
+
+    // merge
+    std::vector<size_t> vOffsets( nChunks + 1 ), nOffsets( nChunks + 1 ), iOffsets( nChunks + 1 ),
+        tOffsets( nChunks + 1 );
+    for ( size_t c = 0; c < nChunks; ++c )
+    {
+        vOffsets[c + 1] = vOffsets[c] + chunks[c].vertices.size();
+        nOffsets[c + 1] = nOffsets[c] + chunks[c].normals.size();
+        iOffsets[c + 1] = iOffsets[c] + chunks[c].indices.size();
+        tOffsets[c + 1] = tOffsets[c] + chunks[c].texcoords.size();
+    }
+
+    Vector3Array vertices( vOffsets[nChunks] );
+    Vector3Array normals( nOffsets[nChunks] );
+    Vector3Array texcoords( tOffsets[nChunks] );
+    Geometry::TriangleMesh::IndexContainerType tris( iOffsets[nChunks] / 3 );
+    // texture index of each corner, when every corner has one
+    std::vector<uint> texIndices( texcoords.empty() ? 0 : iOffsets[nChunks] );
+    std::atomic<bool> validIndices{true};
+    std::atomic<bool> validTexIndices{true};
+    parallelFor(
+        0,
+        nChunks,
+        [&]( size_t c ) {
+            Chunk& chunk = chunks[c];
+            std::copy( chunk.vertices.begin(), chunk.vertices.end(), vertices.begin() + vOffsets[c] );
+            std::copy( chunk.normals.begin(), chunk.normals.end(), normals.begin() + nOffsets[c] );
+            uint* out = tris.empty() ? nullptr : tris[0].data() + iOffsets[c];
+            bool valid = true;
+            for ( size_t i = 0; i < chunk.indices.size(); ++i )
+            {
+                int64_t v = chunk.indices[i];
+                if ( v < -( RelativeTag >> 1 ) ) { v += RelativeTag + int64_t( vOffsets[c] ); }
+                valid  = valid && v >= 0 && v < int64_t( vertices.size() );
+                out[i] = uint( v );
+            }
+            if ( !valid ) { validIndices = false; }
+            std::copy(
+                chunk.texcoords.begin(), chunk.texcoords.end(), texcoords.begin() + tOffsets[c] );
+            valid = true;
+            for ( size_t i = 0; i < chunk.texIndices.size() && !texIndices.empty(); ++i )
+            {
+                int64_t t = chunk.texIndices[i];
+                if ( t < -( RelativeTag >> 1 ) ) { t += RelativeTag + int64_t( tOffsets[c] ); }
+                valid = valid && t >= 0 && t < int64_t( texcoords.size() );
+                texIndices[iOffsets[c] + i] = uint( t );
+            }
+            if ( !valid ) { validTexIndices = false; }
+            chunk = Chunk();
+        },
+        1 );
+
+    if ( !validIndices )
+    {
+        LOG( logERROR ) << filename << ": face index out of range.";
+        return false;
+    }
+    if ( normals.size() != vertices.size() )
+    {
+        LOG( logWARNING ) << filename << ": " << normals.size() << " normals for "
+                          << vertices.size() << " vertices, normals are recomputed.";
+        normals = computeNormals( vertices, tris );
+    }
+
+    if ( !texIndices.empty() && !validTexIndices )
+    {
+        LOG( logWARNING ) << filename
+                          << ": texture coordinates missing or out of range, they are ignored.";
+        texIndices.clear();
+    }
+    m_positionIndices.clear();
+    if ( !texIndices.empty() )
+    { splitTexcoordSeams( vertices, normals, texcoords, tris, texIndices, m_positionIndices ); }
+
+    m_stats.bytes     = n;
+    m_stats.vertices  = vertices.size();
+    m_stats.triangles = tris.size();
+
+    mesh.clear();
+    mesh.setVertices( std::move( vertices ) );
+    mesh.setNormals( std::move( normals ) );
+    mesh.setIndices( std::move( tris ) );
+    if ( !texIndices.empty() )
+    {
+        mesh.addAttrib<Vector3>( Geometry::getAttribName( Geometry::MeshAttrib::VERTEX_TEXCOORD ),
+                                 std::move( texcoords ) );
+    }
+
+    m_stats.seconds = getIntervalSeconds( start, Clock::now() );
+    return true;
+}
+
+} // namespace Subdivision
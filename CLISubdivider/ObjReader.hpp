@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Core/Geometry/TriangleMesh.hpp>
+
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// Parallel OBJ reader.
+/// The file is memory-mapped and split into line-aligned chunks which are parsed concurrently.
+/// Only v, vn and f records are read (same subset as Ra::IO::OBJFileManager), polygons are
+/// fan-triangulated and normal indices of faces are ignored.
+/// When texture coordinates are enabled, vt records are read as well and vertices are split per
+/// ( v, vt ) pair of the faces, the texture coordinates being stored in the standard
+/// VERTEX_TEXCOORD attribute.
+/// Numbers are parsed in place, without per-line string allocation.
+class ObjReader
+{
+  public:
+    explicit ObjReader( bool texcoords = false ) : m_texcoords( texcoords ) {}
+
+    struct Stats {
+        size_t bytes{0};
+        size_t vertices{0};
+        size_t triangles{0};
+        double seconds{0};
+        inline double throughput() const { return seconds > 0 ? bytes / ( seconds * 1e6 ) : 0; }
+    };
+
+    /// Load \p filename into \p mesh. Returns false if the file cannot be read.
+    /// If the file does not list one normal per vertex, normals are recomputed.
+    bool load( const std::string& filename, Ra::Core::Geometry::TriangleMesh& mesh );
+
+    /// Parse the OBJ text [ \p data, \p data + \p n ) into \p mesh, \p filename identifies it in
+    /// the log. Returns false if a face index is out of range.
+    bool parse( const char* data,
+                size_t n,
+                Ra::Core::Geometry::TriangleMesh& mesh,
+                const std::string& filename = "OBJ data" );
+
+    /// Statistics of the last successful load.
+    inline const Stats& stats() const { return m_stats; }
+
+    /// Index of the OBJ position (v record) of each vertex of the last loaded mesh, when its
+    /// vertices were split per ( v, vt ) pair. Empty when each vertex is its own position.
+    inline const std::vector<uint>& positionIndices() const { return m_positionIndices; }
+
+  private:
+    bool m_texcoords;
+    Stats m_stats;
+    std::vector<uint> m_positionIndices;
+};
+
+} // namespace Subdivision
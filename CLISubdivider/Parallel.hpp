@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace Subdivision {
+
+/// Number of worker threads used by parallelFor.
+/// 0 (default) means std::thread::hardware_concurrency().
+inline std::atomic<unsigned int>& threadCountSetting() {
+    static std::atomic<unsigned int> count{0};
+    return count;
+}
+
+/// Per-thread override of threadCountSetting(), 0 when not set.
+inline unsigned int& threadCountOverride() {
+    static thread_local unsigned int count{0};
+    return count;
+}
+
+inline void setThreadCount( unsigned int n ) {
+    threadCountSetting() = n;
+}
+
+inline unsigned int threadCount() {
+    unsigned int n = threadCountOverride();
+    if ( n == 0 ) { n = threadCountSetting(); }
+    if ( n == 0 ) { n = std::max( 1u, std::thread::hardware_concurrency() ); }
+    return n;
+}
+
+/// Limit the number of threads used by parallelFor calls made from the current thread, for the
+/// lifetime of the object. Used when several jobs run concurrently.
+class ScopedThreadCount
+{
+  public:
+    explicit ScopedThreadCount( unsigned int n ) : m_previous( threadCountOverride() ) {
+        threadCountOverride() = n;
+    }
+    ~ScopedThreadCount() { threadCountOverride() = m_previous; }
+    ScopedThreadCount( const ScopedThreadCount& ) = delete;
+    ScopedThreadCount& operator=( const ScopedThreadCount& ) = delete;
+
+  private:
+    unsigned int m_previous;
+};
+
+/// Call f( begin, end ) on contiguous sub-ranges of [first, last), one per thread.
+/// Small ranges (less than \p grain elements per thread) are processed on the calling thread.
+template <typename F>
+void parallelForRange( std::size_t first, std::size_t last, F&& f, std::size_t grain = 1024 ) {
+    if ( last <= first ) { return; }
+    const std::size_t n = last - first;
+    std::size_t nThreads =
+        std::min<std::size_t>( threadCount(), std::max<std::size_t>( 1, n / grain ) );
+    if ( nThreads <= 1 )
+    {
+        f( first, last );
+        return;
+    }
+
+    const std::size_t chunk = ( n + nThreads - 1 ) / nThreads;
+    std::vector<std::thread> workers;
+    workers.reserve( nThreads - 1 );
+    for ( std::size_t t = 1; t < nThreads; ++t )
+    {
+        const std::size_t b = first + t * chunk;
+        const std::size_t e = std::min( last, b + chunk );
+        if ( b < e ) { workers.emplace_back( [&f, b, e]() { f( b, e ); } ); }
+    }
+    // the calling thread processes the first chunk
+    f( first, std::min( last, first + chunk ) );
+    for ( auto& w : workers )
+    {
+        w.join();
+    }
+}
+
+/// Call f( i ) for each i in [first, last), in parallel.
+template <typename F>
+void parallelFor( std::size_t first, std::size_t last, F&& f, std::size_t grain = 1024 ) {
+    parallelForRange(
+        first,
+        last,
+        [&f]( std::size_t b, std::size_t e ) {
+            for ( std::size_t i = b; i < e; ++i )
+            {
+                f( i );
+            }
+        },
+        grain );
+}
+
+/// Exclusive prefix sum of \p counts, in place. Returns the total.
+template <typename T, typename Allocator>
+T exclusiveScan( std::vector<T, Allocator>& counts ) {
+    T sum{0};
+    for ( auto& c : counts )
+    {
+        T v = c;
+        c   = sum;
+        sum += v;
+    }
+    return sum;
+}
+
+/// Sort \p values with \p less: blocks are sorted concurrently, then merged pairwise in parallel.
+template <typename T, typename Allocator, typename Less>
+void parallelSort( std::vector<T, Allocator>& values, Less less ) {
+    const std::size_t n       = values.size();
+    const std::size_t nBlocks =
+        std::min<std::size_t>( threadCount(), std::max<std::size_t>( 1, n / 4096 ) );
+    if ( nBlocks <= 1 )
+    {
+        std::sort( values.begin(), values.end(), less );
+        return;
+    }
+    auto bound = [n, nBlocks]( std::size_t b ) { return std::min( n, b * n / nBlocks ); };
+    parallelFor(
+        0,
+        nBlocks,
+        [&]( std::size_t b ) {
+            std::sort( values.begin() + bound( b ), values.begin() + bound( b + 1 ), less );
+        },
+        1 );
+    for ( std::size_t width = 1; width < nBlocks; width *= 2 )
+    {
+        parallelFor(
+            0,
+            ( nBlocks + 2 * width - 1 ) / ( 2 * width ),
+            [&]( std::size_t m ) {
+                const std::size_t first = 2 * width * m;
+                const std::size_t mid   = std::min( nBlocks, first + width );
+                const std::size_t last  = std::min( nBlocks, first + 2 * width );
+                std::inplace_merge( values.begin() + bound( first ),
+                                    values.begin() + bound( mid ),
+                                    values.begin() + bound( last ),
+                                    less );
+            },
+            1 );
+    }
+}
+
+} // namespace Subdivision
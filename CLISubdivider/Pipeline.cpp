@@ -0,0 +1,586 @@
+#include "Pipeline.hpp"
+#include "AdaptiveSubdivider.hpp"
+#include "AttributeSubdivider.hpp"
+#include "Decimator.hpp"
+#include "LodChain.hpp"
+#include "ObjReader.hpp"
+#include "TiledSubdivider.hpp"
+#include "VertexWelder.hpp"
+
+#include <VertexCacheOptimizer.hpp>
+
+#include <Core/Geometry/CatmullClarkSubdivider.hpp>
+#include <Core/Geometry/LoopSubdivider.hpp>
+#include <Core/Geometry/MeshPrimitives.hpp>
+#include <Core/Geometry/deprecated/TopologicalMesh.hpp>
+#include <Core/Utils/Log.hpp>
+#include <Core/Utils/Timer.hpp>
+#include <IO/deprecated/OBJFileManager.hpp>
+#include <OpenMesh/Tools/Decimater/DecimaterT.hh>
+#include <OpenMesh/Tools/Decimater/ModQuadricT.hh>
+
+#include <fstream>
+#include <memory>
+
+namespace Subdivision {
+
+using namespace Ra::Core::Utils; // log, timer
+
+bool engineFromName( const std::string& name, Engine& engine ) {
+    if ( name == "openmesh" ) { engine = Engine::OpenMesh; }
+    else if ( name == "flat" )
+    { engine = Engine::Flat; }
+    else if ( name == "direct" )
+    { engine = Engine::Direct; }
+    else
+    { return false; }
+    return true;
+}
+
+namespace {
+
+/// Reason to replace \p engine by the flat engine for \p settings, or null.
+const char* flatEngineReason( const Settings& settings, Engine engine ) {
+    if ( engine == Engine::Flat || settings.attributes ) { return nullptr; }
+    if ( settings.decimation() )
+    { return engine == Engine::Direct ? "The direct engine does not decimate" : nullptr; }
+    if ( engine == Engine::Direct && settings.scheme != Scheme::Loop )
+    { return "The direct engine only implements loop"; }
+    if ( settings.limitSurface ) { return "Limit surface projection"; }
+    if ( settings.quadOutput && settings.scheme == Scheme::CatmullClark )
+    { return "Quad output"; }
+    return nullptr;
+}
+
+/// True if \p settings lead to an OpenMesh TopologicalMesh.
+bool buildsTopologicalMesh( const Settings& settings ) {
+    if ( settings.engine != Engine::OpenMesh ) { return false; }
+    if ( settings.decimation() ) { return true; }
+    return !settings.attributes && settings.patchFaces == 0 && !settings.lodChain &&
+           flatEngineReason( settings, settings.engine ) == nullptr;
+}
+
+} // namespace
+
+JobResult
+Pipeline::run( const std::string& input, const std::string& output, const Settings& settings ) {
+    JobResult result;
+
+    auto start = Clock::now();
+    {
+        ProfileScope phase( m_profiler, "load" );
+        if ( !load( input, settings, result ) ) { return result; }
+    }
+    result.loadSeconds = getIntervalSeconds( start, Clock::now() );
+    process( output, settings, result );
+    releaseArena();
+    return result;
+}
+
+JobResult Pipeline::run( const char* data,
+                         size_t size,
+                         const std::string& output,
+                         const Settings& settings ) {
+    JobResult result;
+
+    auto start = Clock::now();
+    {
+        ProfileScope phase( m_profiler, "load" );
+        m_positionIndices.clear();
+        if ( size == 0 ) { m_mesh = Ra::Core::Geometry::makeBox(); }
+        else
+        {
+            ObjReader reader( settings.attributes );
+            if ( !reader.parse( data, size, m_mesh ) ) { return result; }
+            m_positionIndices = reader.positionIndices();
+        }
+        result.inputBytes = size;
+    }
+    result.loadSeconds = getIntervalSeconds( start, Clock::now() );
+    process( output, settings, result );
+    releaseArena();
+    return result;
+}
+
+void Pipeline::process( const std::string& output, const Settings& settings, JobResult& result ) {
+    result.inputTriangles = m_mesh.getIndices().size();
+
+    auto start = Clock::now();
+    if ( settings.weld ) { weld( settings ); }
+    const bool valid = validate( settings );
+    // the blocks of the check are released, the arena then serves the refinement until the end
+    releaseArena();
+    if ( !valid ) { return; }
+    bindArena( settings );
+    if ( settings.patchFaces > 0 && !settings.decimation() )
+    {
+        // Out-of-core: patches are refined and written directly to the output file
+        {
+            ProfileScope phase( m_profiler, "flat mesh" );
+            m_flatMesh.assign( m_mesh );
+            m_mesh.clear();
+        }
+        if ( settings.limitSurface )
+        { LOG( logWARNING ) << "Limit surface projection is ignored in tiled mode."; }
+        if ( settings.attributes )
+        { LOG( logWARNING ) << "Attributes are not subdivided in tiled mode."; }
+        if ( settings.vertexCache > 0 )
+        { LOG( logWARNING ) << "Vertex cache optimization is ignored in tiled mode."; }
+        ProfileScope phase( m_profiler, "tiled subdivision" );
+        TiledSubdivider tiled( settings, arena( settings ) );
+        if ( !tiled.run( m_flatMesh, output ) ) { return; }
+        result.subdivisionSeconds = getIntervalSeconds( start, Clock::now() );
+        result.outputVertices     = tiled.vertexCount();
+        result.outputTriangles    = tiled.faceCount();
+        if ( m_verbose )
+        {
+            LOG( logINFO ) << "Tiled subdivision done and saved in " << result.subdivisionSeconds
+                           << "s: " << result.outputVertices << " vertices, "
+                           << result.outputTriangles << " faces.";
+        }
+        result.success = true;
+        return;
+    }
+
+    if ( settings.lodChain && !settings.decimation() )
+    {
+        // Every level is saved, while the next one is refined
+        {
+            ProfileScope phase( m_profiler, "flat mesh" );
+            m_flatMesh.assign( m_mesh );
+            m_mesh.clear();
+        }
+        if ( settings.limitSurface || settings.attributes || settings.triangleBudget > 0 )
+        {
+            LOG( logWARNING ) << "Limit surface projection, attributes and adaptive subdivision "
+                                 "are ignored when saving all the levels.";
+        }
+        LodChain lods( settings );
+        lods.setProfiler( m_profiler );
+        if ( !lods.run( m_flatMesh, output ) ) { return; }
+        result.subdivisionSeconds = getIntervalSeconds( start, Clock::now() );
+        result.outputVertices     = lods.vertexCount();
+        result.outputTriangles    = lods.faceCount();
+        result.quadOutput = settings.quadOutput && settings.scheme == Scheme::CatmullClark;
+        if ( m_verbose )
+        {
+            LOG( logINFO ) << "Levels 0 to " << settings.iterations << " refined and saved in "
+                           << result.subdivisionSeconds << "s, finest level: "
+                           << result.outputVertices << " vertices, " << result.outputTriangles
+                           << " faces.";
+        }
+        result.success = true;
+        return;
+    }
+
+    Engine engine = settings.engine;
+    if ( const char* reason = flatEngineReason( settings, engine ) )
+    {
+        if ( m_verbose ) { LOG( logINFO ) << reason << ", using the flat engine."; }
+        engine = Engine::Flat;
+    }
+    const bool processed =
+        settings.decimation() ? decimate( settings, engine ) : subdivide( settings, engine );
+    if ( !processed ) { return; }
+    result.subdivisionSeconds = getIntervalSeconds( start, Clock::now() );
+    result.quadOutput         = m_quads;
+    result.outputVertices     = m_quads ? m_flatMesh.nVertices() : m_mesh.vertices().size();
+    result.outputTriangles    = m_quads ? m_flatMesh.nFaces() : m_mesh.getIndices().size();
+    if ( m_verbose )
+    {
+        const char* engineName = engine == Engine::Direct ? "direct"
+                                 : engine == Engine::Flat ? "flat"
+                                                          : "openmesh";
+        const bool decimation  = settings.decimation();
+        if ( settings.triangleBudget > 0 && !decimation ) { engineName = "adaptive"; }
+        if ( settings.attributes && !decimation ) { engineName = "attributes"; }
+        LOG( logINFO ) << ( decimation ? "Decimation (" : "Subdivision (" ) << engineName
+                       << " engine) done in " << result.subdivisionSeconds
+                       << "s: " << result.outputVertices << " vertices, "
+                       << result.outputTriangles << ( m_quads ? " quads." : " triangles." );
+    }
+
+    start = Clock::now();
+    if ( settings.vertexCache > 0 )
+    {
+        if ( m_quads )
+        { LOG( logWARNING ) << "Vertex cache optimization is ignored for quads."; }
+        else
+        {
+            ProfileScope phase( m_profiler, "vertex cache" );
+            VertexCacheOptimizer optimizer( settings.vertexCache );
+            optimizer( m_mesh );
+            if ( m_verbose )
+            {
+                LOG( logINFO ) << "Vertex cache (" << settings.vertexCache
+                               << " entries): ACMR " << optimizer.before().acmr << " -> "
+                               << optimizer.after().acmr << ", ATVR " << optimizer.before().atvr
+                               << " -> " << optimizer.after().atvr << ".";
+            }
+        }
+    }
+    {
+        ProfileScope phase( m_profiler, "save" );
+        const bool saved = m_quads ? saveMesh( output,
+                                               settings,
+                                               MeshBuffers::fromFlatMesh( m_flatMesh, m_normals ) )
+                                   : saveMesh( output, settings, m_mesh );
+        if ( !saved ) { return; }
+    }
+    result.saveSeconds = getIntervalSeconds( start, Clock::now() );
+    if ( m_verbose ) { LOG( logINFO ) << "Saved in " << result.saveSeconds << "s."; }
+
+    result.success = true;
+}
+
+bool loadMesh( const std::string& input,
+               const Settings& settings,
+               Ra::Core::Geometry::TriangleMesh& mesh,
+               bool verbose,
+               std::vector<uint>* positionIndices ) {
+    if ( positionIndices ) { positionIndices->clear(); }
+    if ( settings.parallelLoader )
+    {
+        ObjReader reader( settings.attributes );
+        if ( !reader.load( input, mesh ) ) { return false; }
+        if ( positionIndices ) { *positionIndices = reader.positionIndices(); }
+        if ( verbose )
+        {
+            const auto& stats = reader.stats();
+            LOG( logINFO ) << "Loaded " << stats.vertices << " vertices and " << stats.triangles
+                           << " triangles in " << stats.seconds << "s (" << stats.throughput()
+                           << " MB/s).";
+        }
+        return true;
+    }
+
+    Ra::IO::OBJFileManager obj;
+    mesh.clear();
+    if ( !obj.load( input, mesh ) )
+    {
+        LOG( logERROR ) << "Cannot load " << input;
+        return false;
+    }
+    return true;
+}
+
+bool saveMesh( const std::string& output, const Settings& settings, const MeshBuffers& mesh ) {
+    bool saved;
+    switch ( settings.format )
+    {
+    case OutputFormat::Ply:
+        saved = writePly( output + ".ply", mesh );
+        break;
+    case OutputFormat::Binary:
+        saved = writeBinaryMesh( output + ".rbm", mesh );
+        break;
+    default:
+        saved = writeObj( output + ".obj", mesh );
+    }
+    if ( !saved ) { LOG( logERROR ) << "Cannot save " << output; }
+    return saved;
+}
+
+bool saveMesh( const std::string& output,
+               const Settings& settings,
+               const Ra::Core::Geometry::TriangleMesh& mesh ) {
+    bool saved;
+    switch ( settings.format )
+    {
+    case OutputFormat::Ply:
+        saved = writePly( output + ".ply", MeshBuffers::fromTriangleMesh( mesh ) );
+        break;
+    case OutputFormat::Binary:
+        saved = writeBinaryMesh( output + ".rbm", MeshBuffers::fromTriangleMesh( mesh ) );
+        break;
+    default:
+    {
+        // Save triangle mesh to obj file, OBJFileManager does not write texture coordinates
+        const MeshBuffers buffers = MeshBuffers::fromTriangleMesh( mesh );
+        saved = buffers.texcoords != nullptr ? writeObj( output + ".obj", buffers )
+                                             : Ra::IO::OBJFileManager().save( output, mesh );
+    }
+    }
+    if ( !saved ) { LOG( logERROR ) << "Cannot save " << output; }
+    return saved;
+}
+
+bool Pipeline::load( const std::string& input, const Settings& settings, JobResult& result ) {
+    if ( input.empty() )
+    {
+        m_mesh = Ra::Core::Geometry::makeBox();
+        m_positionIndices.clear();
+        return true;
+    }
+
+    std::ifstream file( input, std::ios::binary | std::ios::ate );
+    if ( !file )
+    {
+        LOG( logERROR ) << "Cannot open " << input;
+        return false;
+    }
+    result.inputBytes = size_t( file.tellg() );
+    file.close();
+
+    return loadMesh( input, settings, m_mesh, m_verbose, &m_positionIndices );
+}
+
+void Pipeline::weld( const Settings& settings ) {
+    if ( settings.attributes )
+    { LOG( logWARNING ) << "Welding merges the vertices of the texture seams."; }
+    ProfileScope phase( m_profiler, "weld" );
+    const auto start = Clock::now();
+    VertexWelder welder( settings.weldEpsilon );
+    const bool welded = welder( m_mesh );
+    // the vertices are renumbered, and the seams merged already
+    if ( welded ) { m_positionIndices.clear(); }
+    if ( welded && m_verbose )
+    {
+        LOG( logINFO ) << "Welded " << welder.merged() << " vertices (epsilon "
+                       << settings.weldEpsilon << ") in "
+                       << getIntervalSeconds( start, Clock::now() ) << "s, "
+                       << m_mesh.vertices().size() << " vertices left.";
+    }
+}
+
+bool Pipeline::validate( const Settings& settings ) {
+    ManifoldCheck check = settings.manifold;
+    if ( check == ManifoldCheck::Auto )
+    { check = buildsTopologicalMesh( settings ) ? ManifoldCheck::Check : ManifoldCheck::Off; }
+    if ( check == ManifoldCheck::Off ) { return true; }
+
+    ProfileScope phase( m_profiler, "manifold check" );
+    // the buffers of the check are served by the arena, released by the caller
+    MeshValidator validator( check == ManifoldCheck::Repair, arena( settings ) );
+    const bool valid = validator( m_mesh );
+    if ( validator.defects().empty() ) { return true; }
+    if ( check == ManifoldCheck::Check )
+    {
+        LOG( logERROR ) << "Invalid input mesh: " << validator.defects().toString()
+                        << ". Use --manifold repair to fix them.";
+        return false;
+    }
+    LOG( logWARNING ) << "Input mesh repaired (" << validator.defects().toString() << "): "
+                      << validator.droppedFaces() << " faces dropped, "
+                      << validator.addedVertices() << " vertices added.";
+    if ( !valid ) { LOG( logERROR ) << "The input mesh cannot be repaired."; }
+    return valid;
+}
+
+bool Pipeline::decimate( const Settings& settings, Engine engine ) {
+    m_quads = false;
+    if ( settings.attributes || settings.limitSurface || settings.quadOutput ||
+         settings.triangleBudget > 0 || settings.patchFaces > 0 || settings.lodChain )
+    { LOG( logWARNING ) << "Subdivision options are ignored when decimating."; }
+
+    if ( engine == Engine::Flat )
+    {
+        // Parallel collapses of independent edges, by rounds
+        {
+            ProfileScope phase( m_profiler, "flat mesh" );
+            m_flatMesh.assign( m_mesh );
+        }
+        {
+            ProfileScope phase( m_profiler, "decimation" );
+            Decimator decimator( settings.decimateFaces, settings.decimateError );
+            if ( !decimator( m_flatMesh ) )
+            {
+                LOG( logERROR ) << "Decimation requires a triangle mesh.";
+                return false;
+            }
+            if ( m_verbose ) { LOG( logINFO ) << decimator.rounds() << " collapse rounds."; }
+        }
+        ProfileScope phase( m_profiler, "toTriangleMesh" );
+        m_mesh = m_flatMesh.toTriangleMesh();
+        return true;
+    }
+
+    using TopologicalMesh = Ra::Core::Geometry::deprecated::TopologicalMesh;
+    auto topologicalMesh  = [this]() {
+        ProfileScope phase( m_profiler, "topological mesh" );
+        return TopologicalMesh( m_mesh );
+    }();
+
+    // Sequential OpenMesh decimater, with the same quadric error
+    {
+        ProfileScope phase( m_profiler, "decimation" );
+        topologicalMesh.request_vertex_status();
+        topologicalMesh.request_edge_status();
+        topologicalMesh.request_halfedge_status();
+        topologicalMesh.request_face_status();
+        OpenMesh::Decimater::DecimaterT<TopologicalMesh> decimater( topologicalMesh );
+        OpenMesh::Decimater::ModQuadricT<TopologicalMesh>::Handle quadric;
+        decimater.add( quadric );
+        if ( settings.decimateError > 0 )
+        { decimater.module( quadric ).set_max_err( settings.decimateError ); }
+        else
+        { decimater.module( quadric ).unset_max_err(); }
+        decimater.initialize();
+        decimater.decimate_to_faces( 0, settings.decimateFaces );
+        topologicalMesh.garbage_collection();
+    }
+
+    ProfileScope phase( m_profiler, "toTriangleMesh" );
+    m_mesh = topologicalMesh.toTriangleMesh();
+    return true;
+}
+
+bool Pipeline::subdivide( const Settings& settings, Engine engine ) {
+    m_quads = false;
+    if ( settings.attributes )
+    {
+        if ( settings.triangleBudget > 0 || settings.quadOutput || settings.limitSurface )
+        {
+            LOG( logWARNING ) << "Adaptive subdivision, quad output and limit surface projection "
+                                 "are ignored when subdividing the attributes.";
+        }
+        ProfileScope phase( m_profiler, "subdivision" );
+        AttributeSubdivider subdivider( settings.scheme, arena( settings ) );
+        // the vertices added by a repair are past the end of m_positionIndices, so that the
+        // non-manifold vertices stay split
+        if ( !subdivider( m_mesh, settings.iterations, m_positionIndices ) )
+        {
+            LOG( logERROR ) << "Cannot subdivide the attributes of the mesh.";
+            return false;
+        }
+        if ( m_verbose )
+        {
+            for ( const auto& name : subdivider.faceVaryingAttributes() )
+            { LOG( logINFO ) << "Attribute " << name << " is face-varying."; }
+        }
+        return true;
+    }
+    if ( settings.triangleBudget > 0 )
+    {
+        if ( settings.scheme != Scheme::Loop )
+        {
+            LOG( logERROR ) << "Adaptive subdivision is only available with the loop scheme.";
+            return false;
+        }
+        if ( settings.limitSurface )
+        { LOG( logWARNING ) << "Limit surface projection is ignored by adaptive subdivision."; }
+        {
+            ProfileScope phase( m_profiler, "flat mesh" );
+            m_flatMesh.assign( m_mesh );
+        }
+        {
+            ProfileScope phase( m_profiler, "subdivision" );
+            AdaptiveSubdivider subdivider( settings.triangleBudget,
+                                           settings.curvatureAngle * Scalar( M_PI / 180. ),
+                                           settings.edgeLength );
+            if ( !subdivider( m_flatMesh, settings.iterations, m_workspace ) )
+            {
+                LOG( logERROR ) << "Loop subdivision requires a triangle mesh.";
+                return false;
+            }
+        }
+        ProfileScope phase( m_profiler, "toTriangleMesh" );
+        m_mesh = m_flatMesh.toTriangleMesh();
+        return true;
+    }
+
+    if ( engine == Engine::Direct )
+    {
+        // Refine the arrays of the TriangleMesh, no intermediate topology
+        ProfileScope phase( m_profiler, "subdivision" );
+        m_directSubdivider( m_mesh, settings.iterations );
+        return true;
+    }
+
+    if ( engine == Engine::Flat )
+    {
+        // Convert to the compact index layout, subdivide in parallel and triangulate back
+        {
+            ProfileScope phase( m_profiler, "flat mesh" );
+            m_flatMesh.assign( m_mesh );
+        }
+        {
+            ProfileScope phase( m_profiler, "subdivision" );
+            FlatSubdivider subdivider( settings.scheme );
+            if ( !subdivider( m_flatMesh, settings.iterations, m_workspace ) )
+            {
+                LOG( logERROR ) << "Loop subdivision requires a triangle mesh.";
+                return false;
+            }
+        }
+        bool limit = false;
+        if ( settings.limitSurface )
+        {
+            ProfileScope phase( m_profiler, "limit surface" );
+            m_workspace.connectivity.build( m_flatMesh );
+            limit = m_limitSurface.build( m_flatMesh, m_workspace.connectivity, settings.scheme );
+            if ( limit ) { m_limitSurface.apply( m_flatMesh.positions, m_normals ); }
+            else
+            {
+                LOG( logWARNING ) << "Limit surface projection requires a subdivided mesh "
+                                     "(quads for catmull), it is skipped.";
+            }
+        }
+        if ( settings.quadOutput && settings.scheme == Scheme::CatmullClark &&
+             m_flatMesh.isUniform( 4 ) )
+        {
+            // keep the quads, only the normals are computed
+            ProfileScope phase( m_profiler, "normals" );
+            if ( !limit ) { m_normals = m_flatMesh.vertexNormals(); }
+            m_quads = true;
+            return true;
+        }
+        ProfileScope phase( m_profiler, "toTriangleMesh" );
+        m_mesh = m_flatMesh.toTriangleMesh();
+        if ( limit ) { m_mesh.setNormals( m_normals ); }
+        return true;
+    }
+
+    std::unique_ptr<
+        OpenMesh::Subdivider::Uniform::SubdividerT<Ra::Core::Geometry::deprecated::TopologicalMesh,
+                                                   Scalar>>
+        subdivider;
+    if ( settings.scheme == Scheme::CatmullClark )
+    { subdivider = std::make_unique<Ra::Core::Geometry::CatmullClarkSubdivider>(); }
+    else
+    { subdivider = std::make_unique<Ra::Core::Geometry::LoopSubdivider>(); }
+
+    // Create topological structure
+    auto topologicalMesh = [this]() {
+        ProfileScope phase( m_profiler, "topological mesh" );
+        return Ra::Core::Geometry::deprecated::TopologicalMesh( m_mesh );
+    }();
+
+    // Create OpenMesh subdivider, and process topological structure
+    {
+        ProfileScope phase( m_profiler, "subdivision" );
+        subdivider->attach( topologicalMesh );
+        ( *subdivider )( settings.iterations );
+        subdivider->detach();
+    }
+
+    // Convert processed topological structure to triangle mesh
+    ProfileScope phase( m_profiler, "toTriangleMesh" );
+    m_mesh = topologicalMesh.toTriangleMesh();
+    return true;
+}
+
+void Pipeline::bindArena( const Settings& settings ) {
+    if ( !settings.arena ) { return; }
+    // empty buffers built with the arena are moved in, the allocators follow them
+    m_flatMesh         = FlatMesh( &m_arena );
+    m_workspace        = FlatSubdivider::Workspace( &m_arena );
+    m_directSubdivider = TriangleMeshSubdivider( &m_arena );
+}
+
+void Pipeline::releaseArena() {
+    if ( m_arena.allocations() == 0 ) { return; }
+    if ( m_verbose )
+    {
+        LOG( logINFO ) << "Arena: " << m_arena.allocations() << " allocations in "
+                       << m_arena.chunks() << " chunks (" << m_arena.bytes() / 1e6
+                       << " MB), released.";
+    }
+    // no block of the arena may be kept past its release
+    m_flatMesh         = FlatMesh();
+    m_workspace        = FlatSubdivider::Workspace();
+    m_directSubdivider = TriangleMeshSubdivider();
+    m_arena.release();
+}
+
+} // namespace Subdivision
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "FlatSubdivider.hpp"
+#include "LimitSurface.hpp"
+#include "MeshValidator.hpp"
+#include "MeshWriter.hpp"
+#include "Profiler.hpp"
+#include "TriangleMeshSubdivider.hpp"
+
+#include <Core/Geometry/TriangleMesh.hpp>
+
+#include <string>
+
+namespace Subdivision {
+
+/// Subdivision implementation.
+enum class Engine {
+    /// OpenMesh subdividers over the deprecated TopologicalMesh
+    OpenMesh,
+    /// FlatSubdivider, multithreaded and index based
+    Flat,
+    /// TriangleMeshSubdivider, in place on the TriangleMesh arrays (loop only)
+    Direct
+};
+
+/// Parse an engine name: openmesh, flat or direct. Returns false if the name is unknown.
+bool engineFromName( const std::string& name, Engine& engine );
+
+/// Processing parameters of one mesh.
+struct Settings {
+    Scheme scheme{Scheme::Loop};
+    int iterations{1};
+    Engine engine{Engine::OpenMesh};
+    /// Use the memory-mapped parallel ObjReader instead of Ra::IO::OBJFileManager
+    bool parallelLoader{false};
+    OutputFormat format{OutputFormat::Obj};
+    /// Adaptive refinement (flat engine, Loop) when > 0: maximum number of output triangles,
+    /// iterations is then the maximum depth
+    size_t triangleBudget{0};
+    /// Adaptive refinement criteria: dihedral angle (degrees) and edge length, 0 to disable
+    Scalar curvatureAngle{10};
+    Scalar edgeLength{0};
+    /// Out-of-core tiled subdivision when > 0: number of coarse faces per patch
+    size_t patchFaces{0};
+    /// Save the quads of the Catmull-Clark scheme (flat engine) instead of triangulating them
+    bool quadOutput{false};
+    /// Project the refined vertices onto the limit surface, with the limit normals (flat engine)
+    bool limitSurface{false};
+    /// Subdivide all the vertex attributes (AttributeSubdivider), texture coordinates are read by
+    /// the parallel loader
+    bool attributes{false};
+    /// Save every level from 0 to iterations (LodChain, flat engine)
+    bool lodChain{false};
+    /// With lodChain, append all the levels to a single rbm file
+    bool lodContainer{false};
+    /// Decimate instead of subdividing, down to decimateFaces faces (0 for no target) and up to
+    /// the quadric error decimateError (0 for no bound)
+    size_t decimateFaces{0};
+    Scalar decimateError{0};
+
+    inline bool decimation() const { return decimateFaces > 0 || decimateError > 0; }
+
+    /// Reorder the output triangles and vertices for a post-transform vertex cache of this size
+    /// (VertexCacheOptimizer), 0 to disable
+    uint vertexCache{0};
+    /// Serve the buffers of the manifold check and of the refinement from the Arena of the
+    /// Pipeline, released in one step at the end of the check and of the job, and kept mapped for
+    /// the next job
+    bool arena{true};
+    /// Check (and repair) the defects that the TopologicalMesh cannot represent, before it is
+    /// built
+    ManifoldCheck manifold{ManifoldCheck::Auto};
+    /// Merge the vertices closer than weldEpsilon (VertexWelder) after loading
+    bool weld{false};
+    Scalar weldEpsilon{0};
+};
+
+/// Statistics of one Pipeline::run.
+struct JobResult {
+    bool success{false};
+    size_t inputBytes{0};
+    size_t inputTriangles{0};
+    size_t outputVertices{0};
+    /// Output faces, quads with JobResult::quadOutput
+    size_t outputTriangles{0};
+    bool quadOutput{false};
+    double loadSeconds{0};
+    double subdivisionSeconds{0};
+    double saveSeconds{0};
+
+    inline double seconds() const { return loadSeconds + subdivisionSeconds + saveSeconds; }
+};
+
+/// Load \p input with the loader selected by \p settings.
+/// \p verbose logs the parse throughput of the parallel loader.
+/// \p positionIndices, if not null, receives the original position of each vertex split by the
+/// loader (ObjReader::positionIndices()).
+bool loadMesh( const std::string& input,
+               const Settings& settings,
+               Ra::Core::Geometry::TriangleMesh& mesh,
+               bool verbose                       = false,
+               std::vector<uint>* positionIndices = nullptr );
+
+/// Save \p mesh to \p output, to which the extension of the output format is added.
+bool saveMesh( const std::string& output,
+               const Settings& settings,
+               const Ra::Core::Geometry::TriangleMesh& mesh );
+
+/// Save the polygon mesh \p mesh to \p output, to which the extension of the output format is
+/// added.
+bool saveMesh( const std::string& output, const Settings& settings, const MeshBuffers& mesh );
+
+/// Load, subdivide and save one mesh.
+/// A Pipeline keeps its buffers between runs, so that consecutive jobs reuse the allocations.
+/// With Settings::arena, the temporary buffers of the manifold check, then the refinement buffers
+/// (FlatMesh faces, Connectivity, edge tables and per-level buffers of the subdividers) are
+/// served by a per-job Arena instead. OpenMesh and the TopologicalMesh take no allocator, their
+/// allocations stay on the heap.
+class Pipeline
+{
+  public:
+    explicit Pipeline( bool verbose = true ) : m_verbose( verbose ) {}
+
+    /// Process \p input (Ra::Core::Geometry::makeBox() when empty) and save the result to
+    /// \p output, to which the extension of the output format is added.
+    JobResult run( const std::string& input, const std::string& output, const Settings& settings );
+
+    /// Process the OBJ text [ \p data, \p data + \p size ), parsed by the ObjReader
+    /// (Ra::Core::Geometry::makeBox() when empty), and save the result to \p output.
+    JobResult run( const char* data,
+                   size_t size,
+                   const std::string& output,
+                   const Settings& settings );
+
+    /// Report each phase of the following runs to \p profiler (not owned), null to disable.
+    inline void setProfiler( Profiler* profiler ) { m_profiler = profiler; }
+
+  private:
+    bool load( const std::string& input, const Settings& settings, JobResult& result );
+    /// Subdivide or decimate the loaded m_mesh and save it, result.success is set on success.
+    void process( const std::string& output, const Settings& settings, JobResult& result );
+    /// Merge the duplicated vertices of m_mesh with the VertexWelder.
+    void weld( const Settings& settings );
+    /// Check m_mesh with the MeshValidator, as selected by Settings::manifold. Returns false if
+    /// the mesh is rejected.
+    bool validate( const Settings& settings );
+    /// Subdivide m_mesh with \p engine (settings.engine, or its fallback for the scheme).
+    /// With Settings::quadOutput, Catmull-Clark results are kept in m_flatMesh and m_normals,
+    /// and m_quads is set. With Settings::limitSurface, m_normals are the limit normals.
+    /// With Settings::attributes, the AttributeSubdivider is used whatever the engine.
+    bool subdivide( const Settings& settings, Engine engine );
+    /// Decimate m_mesh with \p engine: OpenMesh decimater (openmesh) or Decimator (flat).
+    bool decimate( const Settings& settings, Engine engine );
+    /// Arena serving the buffers of a job run with \p settings, null for the heap.
+    inline Arena* arena( const Settings& settings ) {
+        return settings.arena ? &m_arena : nullptr;
+    }
+    /// Serve the refinement buffers kept by the Pipeline from the arena, with Settings::arena.
+    void bindArena( const Settings& settings );
+    /// Release the arena, once the buffers kept by the Pipeline are back on the heap.
+    void releaseArena();
+
+    bool m_verbose;
+    /// Declared first, so that it outlives the buffers it serves
+    Arena m_arena;
+    Profiler* m_profiler{nullptr};
+    Ra::Core::Geometry::TriangleMesh m_mesh;
+    FlatMesh m_flatMesh;
+    FlatSubdivider::Workspace m_workspace;
+    TriangleMeshSubdivider m_directSubdivider;
+    LimitSurface m_limitSurface;
+    bool m_quads{false};
+    Ra::Core::Vector3Array m_normals;
+    /// Original position of the vertices of m_mesh split by the loader, for the
+    /// AttributeSubdivider
+    std::vector<uint> m_positionIndices;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,162 @@
+#include "Profiler.hpp"
+
+#include <Core/Utils/Log.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+#ifdef _WIN32
+#    include <windows.h>
+// windows.h must be included first
+#    include <psapi.h>
+#else
+#    include <sys/resource.h>
+#endif
+
+namespace Subdivision {
+
+using namespace Ra::Core::Utils; // log, timer
+
+size_t peakResidentMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+    { return size_t( counters.PeakWorkingSetSize ); }
+    return 0;
+#else
+#    ifdef __linux__
+    // VmHWM, unlike ru_maxrss, is reset by resetPeakResidentMemory()
+    std::ifstream status( "/proc/self/status" );
+    std::string line;
+    while ( std::getline( status, line ) )
+    {
+        if ( line.compare( 0, 6, "VmHWM:" ) == 0 )
+        { return size_t( std::stoull( line.substr( 6 ) ) ) * 1024; } // kilobytes
+    }
+#    endif
+    rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 ) { return 0; }
+#    ifdef __APPLE__
+    return size_t( usage.ru_maxrss ); // bytes
+#    else
+    return size_t( usage.ru_maxrss ) * 1024; // kilobytes
+#    endif
+#endif
+}
+
+bool resetPeakResidentMemory() {
+#ifdef __linux__
+    std::ofstream clearRefs( "/proc/self/clear_refs" );
+    return bool( clearRefs << "5" << std::flush );
+#else
+    return false;
+#endif
+}
+
+double processCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if ( !GetProcessTimes( GetCurrentProcess(), &creation, &exit, &kernel, &user ) ) { return 0; }
+    auto seconds = []( const FILETIME& t ) {
+        return ( ( uint64_t( t.dwHighDateTime ) << 32 ) | t.dwLowDateTime ) * 1e-7;
+    };
+    return seconds( kernel ) + seconds( user );
+#else
+    rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 ) { return 0; }
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) * 1e-6;
+#endif
+}
+
+Profiler::Profiler() {
+    setAllocationCounting( true );
+}
+
+Profiler::~Profiler() {
+    setAllocationCounting( false );
+}
+
+void Profiler::begin( const std::string& name ) {
+    // the peak of an outermost phase is its own, not the one of the previous phases
+    if ( m_open.empty() ) { resetPeakResidentMemory(); }
+    m_phases.emplace_back();
+    m_phases.back().name  = name;
+    m_phases.back().depth = uint( m_open.size() );
+    m_open.emplace_back();
+    OpenPhase& open    = m_open.back();
+    open.index         = m_phases.size() - 1;
+    open.countersStart = allocationCounters();
+    open.cpuStart      = processCpuSeconds();
+    open.start         = Clock::now();
+}
+
+void Profiler::end() {
+    const OpenPhase open = m_open.back();
+    m_open.pop_back();
+    Phase& phase         = m_phases[open.index];
+    phase.wallSeconds    = getIntervalSeconds( open.start, Clock::now() );
+    phase.cpuSeconds     = processCpuSeconds() - open.cpuStart;
+    const auto counters  = allocationCounters();
+    phase.allocations    = counters.allocations - open.countersStart.allocations;
+    phase.allocatedBytes = counters.bytes - open.countersStart.bytes;
+    phase.systemAllocations =
+        counters.systemAllocations - open.countersStart.systemAllocations;
+    phase.peakRss = peakResidentMemory();
+}
+
+void Profiler::print( std::ostream& out ) const {
+    Phase total;
+    total.name = "total";
+    out << std::left << std::setw( 20 ) << "phase" << std::right << std::setw( 10 ) << "wall s"
+        << std::setw( 10 ) << "cpu s" << std::setw( 14 ) << "peak RSS MB" << std::setw( 14 )
+        << "allocations" << std::setw( 14 ) << "alloc MB" << std::setw( 14 ) << "malloc calls"
+        << "\n";
+    auto line = [&out]( const Phase& p ) {
+        // nested phases are indented
+        out << std::left << std::setw( 20 ) << std::string( 2 * p.depth, ' ' ) + p.name
+            << std::right << std::fixed << std::setprecision( 3 ) << std::setw( 10 )
+            << p.wallSeconds << std::setw( 10 )
+            << p.cpuSeconds << std::setw( 14 ) << p.peakRss / 1e6 << std::setw( 14 )
+            << p.allocations << std::setw( 14 ) << p.allocatedBytes / 1e6 << std::setw( 14 )
+            << p.systemAllocations << std::defaultfloat << "\n";
+    };
+    for ( const auto& p : m_phases )
+    {
+        line( p );
+        if ( p.depth > 0 ) { continue; }
+        total.wallSeconds += p.wallSeconds;
+        total.cpuSeconds += p.cpuSeconds;
+        total.peakRss = std::max( total.peakRss, p.peakRss );
+        total.allocations += p.allocations;
+        total.allocatedBytes += p.allocatedBytes;
+        total.systemAllocations += p.systemAllocations;
+    }
+    line( total );
+    out.flush();
+}
+
+bool Profiler::write( const std::string& filename ) const {
+    std::ofstream out( filename );
+    if ( !out )
+    {
+        LOG( logERROR ) << "Cannot write " << filename;
+        return false;
+    }
+    out << "{\n  \"phases\": [";
+    for ( size_t i = 0; i < m_phases.size(); ++i )
+    {
+        const Phase& p = m_phases[i];
+        out << ( i == 0 ? "\n" : ",\n" ) << "    {\"name\": \"" << p.name
+            << "\", \"depth\": " << p.depth << ", \"wallSeconds\": " << p.wallSeconds
+            << ", \"cpuSeconds\": " << p.cpuSeconds << ", \"peakRssBytes\": " << p.peakRss
+            << ", \"allocations\": " << p.allocations
+            << ", \"allocatedBytes\": " << p.allocatedBytes
+            << ", \"systemAllocations\": " << p.systemAllocations << "}";
+    }
+    out << "\n  ]\n}\n";
+    return bool( out );
+}
+
+} // namespace Subdivision
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "AllocationCounter.hpp"
+
+#include <Core/Utils/Timer.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// High-water mark of the resident memory of the process, in bytes, since the last successful
+/// resetPeakResidentMemory().
+size_t peakResidentMemory();
+
+/// Reset the high-water mark of peakResidentMemory() to the current resident memory.
+/// Only supported on Linux (/proc/self/clear_refs), returns false elsewhere.
+bool resetPeakResidentMemory();
+
+/// User and system CPU time of the process (all threads), in seconds.
+double processCpuSeconds();
+
+/// Per-phase report of wall time, CPU time, peak resident memory and allocations.
+///
+/// Allocations are counted by the global operator new of the application (AllocationCounter.hpp),
+/// which only pays for a relaxed atomic load while no Profiler exists. Counts are process wide:
+/// allocations of other threads during a phase are included. System allocations are the calls to
+/// malloc, which the allocations served by an Arena avoid.
+class Profiler
+{
+  public:
+    struct Phase {
+        std::string name;
+        /// Number of enclosing phases, the total only sums the outermost ones
+        uint depth{0};
+        double wallSeconds{0};
+        double cpuSeconds{0};
+        /// Peak resident memory during the phase. The high-water mark is reset when an outermost
+        /// phase begins (Linux only, elsewhere it is the peak of the process so far), so that a
+        /// nested phase reports the peak since its outermost phase began.
+        size_t peakRss{0};
+        size_t allocations{0};
+        size_t allocatedBytes{0};
+        size_t systemAllocations{0};
+    };
+
+    /// Start counting allocations (a single Profiler can exist at a time).
+    Profiler();
+    ~Profiler();
+    Profiler( const Profiler& ) = delete;
+    Profiler& operator=( const Profiler& ) = delete;
+
+    /// Open a phase, nested in the open ones.
+    void begin( const std::string& name );
+    /// Close the innermost open phase.
+    void end();
+
+    inline const std::vector<Phase>& phases() const { return m_phases; }
+
+    /// Print the phases as a table, with a total line.
+    void print( std::ostream& out ) const;
+    /// Write the phases to \p filename as JSON. Returns false if the file cannot be written.
+    bool write( const std::string& filename ) const;
+
+  private:
+    /// Phase being measured, with its start counters.
+    struct OpenPhase {
+        size_t index{0};
+        Ra::Core::Utils::TimePoint start;
+        double cpuStart{0};
+        AllocationCounters countersStart;
+    };
+
+    std::vector<Phase> m_phases;
+    std::vector<OpenPhase> m_open;
+};
+
+/// Profile a scope as one phase. No-op when \p profiler is null.
+class ProfileScope
+{
+  public:
+    ProfileScope( Profiler* profiler, const char* name ) : m_profiler( profiler ) {
+        if ( m_profiler ) { m_profiler->begin( name ); }
+    }
+    ~ProfileScope() {
+        if ( m_profiler ) { m_profiler->end(); }
+    }
+    ProfileScope( const ProfileScope& ) = delete;
+    ProfileScope& operator=( const ProfileScope& ) = delete;
+
+  private:
+    Profiler* m_profiler;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,151 @@
+#include "Sequence.hpp"
+
+#include <Core/Utils/Log.hpp>
+#include <Core/Utils/Timer.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+namespace Subdivision {
+
+using namespace Ra::Core::Utils; // log, timer
+
+namespace {
+
+bool isPositionStream( const std::string& filename ) {
+    return filename.size() > 4 && filename.compare( filename.size() - 4, 4, ".pos" ) == 0;
+}
+
+} // namespace
+
+bool SequenceProcessor::run( const std::string& sequence,
+                             const std::string& restMesh,
+                             const std::string& output ) {
+    const bool stream = isPositionStream( sequence );
+    std::vector<std::string> frames;
+    std::ifstream input;
+    if ( stream )
+    {
+        if ( restMesh.empty() )
+        {
+            LOG( logERROR ) << "A .pos sequence requires a rest mesh (-i).";
+            return false;
+        }
+        input.open( sequence, std::ios::binary );
+    }
+    else
+    {
+        std::ifstream list( sequence );
+        std::string line;
+        while ( std::getline( list, line ) )
+        {
+            if ( !line.empty() && line[0] != '#' ) { frames.push_back( line ); }
+        }
+        if ( frames.empty() )
+        {
+            LOG( logERROR ) << "Cannot read any frame from " << sequence;
+            return false;
+        }
+    }
+    if ( stream && !input )
+    {
+        LOG( logERROR ) << "Cannot open " << sequence;
+        return false;
+    }
+
+    // Topology of the sequence, given by the rest mesh or the first frame
+    auto start = Clock::now();
+    Ra::Core::Geometry::TriangleMesh mesh;
+    if ( !loadMesh( stream ? restMesh : frames.front(), m_settings, mesh ) ) { return false; }
+    m_indices = mesh.getIndices();
+    if ( !m_stencils.build(
+             FlatMesh::fromTriangleMesh( mesh ), m_settings.scheme, m_settings.iterations, m_refined ) )
+    {
+        LOG( logERROR ) << "Loop subdivision requires a triangle mesh.";
+        return false;
+    }
+    if ( m_settings.limitSurface )
+    {
+        Connectivity connectivity;
+        connectivity.build( m_refined );
+        m_limit = m_limitSurface.build( m_refined, connectivity, m_settings.scheme );
+        if ( !m_limit )
+        {
+            LOG( logWARNING ) << "Limit surface projection requires a subdivided mesh "
+                                 "(quads for catmull), it is skipped.";
+        }
+    }
+    LOG( logINFO ) << "Stencil table built in " << getIntervalSeconds( start, Clock::now() )
+                   << "s: " << m_stencils.rows() << " refined vertices, " << m_stencils.nonZeros()
+                   << " weights.";
+
+    const size_t nVertices = m_stencils.cols();
+    Ra::Core::Vector3Array positions;
+    std::vector<float> buffer( 3 * nVertices );
+    double applySeconds = 0;
+    size_t frame        = 0;
+    for ( ;; ++frame )
+    {
+        if ( stream )
+        {
+            input.read( reinterpret_cast<char*>( buffer.data() ),
+                        std::streamsize( buffer.size() * sizeof( float ) ) );
+            if ( input.gcount() == 0 ) { break; }
+            if ( size_t( input.gcount() ) != buffer.size() * sizeof( float ) )
+            {
+                LOG( logERROR ) << "Truncated frame " << frame << " in " << sequence;
+                return false;
+            }
+            positions.resize( nVertices );
+            for ( size_t i = 0; i < nVertices; ++i )
+            {
+                positions[i] = Ra::Core::Vector3(
+                    Scalar( buffer[3 * i] ), Scalar( buffer[3 * i + 1] ), Scalar( buffer[3 * i + 2] ) );
+            }
+        }
+        else
+        {
+            if ( frame == frames.size() ) { break; }
+            if ( !loadFrame( frames[frame], positions ) ) { return false; }
+        }
+
+        start = Clock::now();
+        m_stencils.apply( positions, m_refined.positions );
+        if ( m_limit ) { m_limitSurface.apply( m_refined.positions, m_normals ); }
+        applySeconds += getIntervalSeconds( start, Clock::now() );
+
+        if ( !saveFrame( output, frame ) ) { return false; }
+    }
+
+    LOG( logINFO ) << frame << " frames refined, " << ( frame > 0 ? applySeconds / frame : 0. )
+                   << "s per frame (stencil evaluation).";
+    return true;
+}
+
+bool SequenceProcessor::loadFrame( const std::string& filename, Ra::Core::Vector3Array& positions ) {
+    Ra::Core::Geometry::TriangleMesh mesh;
+    if ( !loadMesh( filename, m_settings, mesh ) ) { return false; }
+    if ( mesh.vertices().size() != m_stencils.cols() || mesh.getIndices() != m_indices )
+    {
+        LOG( logERROR ) << filename << " does not have the topology of the first frame.";
+        return false;
+    }
+    positions = mesh.vertices();
+    return true;
+}
+
+bool SequenceProcessor::saveFrame( const std::string& output, size_t frame ) {
+    char suffix[16];
+    std::snprintf( suffix, sizeof( suffix ), "_%04zu", frame );
+    if ( m_settings.quadOutput && m_refined.isUniform( 4 ) )
+    {
+        if ( !m_limit ) { m_normals = m_refined.vertexNormals(); }
+        return saveMesh(
+            output + suffix, m_settings, MeshBuffers::fromFlatMesh( m_refined, m_normals ) );
+    }
+    auto mesh = m_refined.toTriangleMesh();
+    if ( m_limit ) { mesh.setNormals( m_normals ); }
+    return saveMesh( output + suffix, m_settings, mesh );
+}
+
+} // namespace Subdivision
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Pipeline.hpp"
+#include "StencilTable.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// Subdivision of an animated sequence with a fixed topology.
+///
+/// The refinement topology and the StencilTable are built once from the first frame, each
+/// following frame is then refined by a single sparse matrix-vector product.
+/// Frames are given either as a text file listing one OBJ file per line, or as a binary position
+/// stream (.pos: for each frame, the vertex positions as 3 x float32 little-endian, without
+/// header) together with the rest mesh giving the connectivity.
+/// With Settings::limitSurface, the limit stencils are also built once and applied to each frame.
+class SequenceProcessor
+{
+  public:
+    explicit SequenceProcessor( const Settings& settings ) : m_settings( settings ) {}
+
+    /// Process \p sequence. \p restMesh is the OBJ file giving the connectivity of a .pos
+    /// stream, it is ignored for a list of OBJ files (the first frame is used).
+    /// Frame i is saved to \p output + "_" + i (4 digits) + extension.
+    /// Returns false on error, for instance if a frame does not match the first one.
+    bool run( const std::string& sequence, const std::string& restMesh, const std::string& output );
+
+  private:
+    /// Load a frame and check that it matches the connectivity of the first one
+    bool loadFrame( const std::string& filename, Ra::Core::Vector3Array& positions );
+    bool saveFrame( const std::string& output, size_t frame );
+
+    Settings m_settings;
+    StencilTable m_stencils;
+    /// Coarse connectivity of the first frame
+    Ra::Core::Geometry::TriangleMesh::IndexContainerType m_indices;
+    /// Refined topology, positions are updated for each frame
+    FlatMesh m_refined;
+    /// Limit stencils of the refined topology, when Settings::limitSurface is set
+    LimitSurface m_limitSurface;
+    bool m_limit{false};
+    Ra::Core::Vector3Array m_normals;
+};
+
+} // namespace Subdivision
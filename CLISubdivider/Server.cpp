@@ -0,0 +1,339 @@
+#include "Server.hpp"
+#include "CommandLine.hpp"
+#include "Parallel.hpp"
+
+#include <Core/Utils/Log.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#    define SUBDIVISION_USE_SOCKETS
+#    include <cerrno>
+#    include <csignal>
+#    include <poll.h>
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#    include <unistd.h>
+#endif
+
+namespace Subdivision {
+
+using namespace Ra::Core::Utils; // log
+
+#ifdef SUBDIVISION_USE_SOCKETS
+
+namespace {
+
+/// Largest request accepted, so that a client cannot make a worker allocate without bound.
+constexpr size_t maxArguments  = 256;
+constexpr size_t maxInputBytes = size_t( 1 ) << 30;
+constexpr size_t maxLineBytes  = 4096;
+
+/// Buffered reads and complete writes on file descriptors.
+/// Reads wait at most until \p quit is set, so that an idle connection does not keep its worker.
+class Stream
+{
+  public:
+    Stream( int in, int out, const std::atomic<bool>& quit ) :
+        m_in( in ), m_out( out ), m_quit( quit ) {}
+
+    /// Read a line, without its end. Returns false at the end of the input, or if the line is
+    /// longer than maxLineBytes (tooLong() is then set).
+    bool readLine( std::string& line ) {
+        line.clear();
+        for ( ;; )
+        {
+            if ( m_begin == m_end && !fill() ) { return !line.empty(); }
+            const char* begin = m_buffer + m_begin;
+            const char* end   = m_buffer + m_end;
+            const char* eol   = std::find( begin, end, '\n' );
+            if ( line.size() + size_t( eol - begin ) > maxLineBytes )
+            {
+                m_tooLong = true;
+                return false;
+            }
+            line.append( begin, eol );
+            m_begin = size_t( eol - m_buffer );
+            if ( eol != end )
+            {
+                ++m_begin;
+                return true;
+            }
+        }
+    }
+
+    /// True once a line longer than maxLineBytes was read.
+    inline bool tooLong() const { return m_tooLong; }
+
+    /// Read exactly \p size bytes.
+    bool read( char* data, size_t size ) {
+        const size_t buffered = std::min( size, m_end - m_begin );
+        std::copy( m_buffer + m_begin, m_buffer + m_begin + buffered, data );
+        m_begin += buffered;
+        for ( size_t done = buffered; done < size; )
+        {
+            if ( !wait() ) { return false; }
+            const ssize_t n = ::read( m_in, data + done, size - done );
+            if ( n <= 0 ) { return false; }
+            done += size_t( n );
+        }
+        return true;
+    }
+
+    bool write( const std::string& s ) {
+        for ( size_t done = 0; done < s.size(); )
+        {
+            const ssize_t n = ::write( m_out, s.data() + done, s.size() - done );
+            if ( n <= 0 ) { return false; }
+            done += size_t( n );
+        }
+        return true;
+    }
+
+  private:
+    /// Wait for input, polling \p m_quit. Returns false once it is set.
+    bool wait() {
+        pollfd input{m_in, POLLIN, 0};
+        while ( !m_quit )
+        {
+            const int n = ::poll( &input, 1, 200 );
+            if ( n > 0 || ( n < 0 && errno != EINTR ) ) { return true; }
+        }
+        return false;
+    }
+
+    bool fill() {
+        if ( !wait() ) { return false; }
+        const ssize_t n = ::read( m_in, m_buffer, sizeof( m_buffer ) );
+        m_begin         = 0;
+        m_end           = n > 0 ? size_t( n ) : 0;
+        return n > 0;
+    }
+
+    int m_in;
+    int m_out;
+    const std::atomic<bool>& m_quit;
+    char m_buffer[4096];
+    size_t m_begin{0};
+    size_t m_end{0};
+    bool m_tooLong{false};
+};
+
+/// Checks of the options of a job, empty if it can be served.
+std::string checkJob( const Arguments& a ) {
+    if ( !a.valid || a.outputFilename.empty() ) { return "missing output or subdivision type"; }
+    if ( !a.batch.empty() || !a.sequence.empty() || !a.serve.empty() || a.profile )
+    { return "only single mesh jobs are served"; }
+    return {};
+}
+
+} // namespace
+
+bool Server::run( const std::string& socket ) {
+    // a client closing its connection early must not stop the server
+    std::signal( SIGPIPE, SIG_IGN );
+    return socket == "-" ? servePipe() : serveSocket( socket );
+}
+
+void Server::serve( int in, int out, Worker& worker ) {
+    Stream stream( in, out, m_quit );
+    std::string line;
+    while ( !m_quit && stream.readLine( line ) )
+    {
+        std::istringstream header( line );
+        std::string command;
+        size_t nArguments = 0, size = 0;
+        header >> command;
+        if ( command == "QUIT" )
+        {
+            m_quit = true;
+            stream.write( "OK 0 0 0\n" );
+            return;
+        }
+        if ( command != "JOB" || !( header >> nArguments >> size ) )
+        {
+            stream.write( "ERROR invalid request header\n" );
+            return;
+        }
+        // the connection is closed: the rest of the request cannot be skipped
+        if ( nArguments > maxArguments || size > maxInputBytes )
+        {
+            LOG( logERROR ) << "Rejected request of " << nArguments << " arguments and " << size
+                            << " bytes.";
+            stream.write( "ERROR request too large\n" );
+            return;
+        }
+        std::vector<std::string> arguments{"server"};
+        for ( size_t i = 0; i < nArguments && stream.readLine( line ); ++i )
+        {
+            arguments.push_back( line );
+        }
+        if ( stream.tooLong() ) { break; }
+        // the buffer keeps its capacity from one job to the next
+        worker.input.resize( size );
+        if ( arguments.size() != nArguments + 1 || !stream.read( worker.input.data(), size ) )
+        {
+            LOG( logERROR ) << "Truncated request.";
+            return;
+        }
+
+        // invalid numbers in the options, or a failing job, must not stop the server
+        Arguments a;
+        JobResult result;
+        try
+        {
+            a                       = parseArguments( arguments );
+            const std::string error = checkJob( a );
+            if ( !error.empty() )
+            {
+                LOG( logERROR ) << "Rejected job: " << error << ".";
+                if ( !stream.write( "ERROR " + error + "\n" ) ) { return; }
+                continue;
+            }
+            ScopedThreadCount threads( a.threads > 0 ? a.threads : threadCount() );
+            result = size == 0
+                         ? worker.pipeline.run( a.inputFilename, a.outputFilename, a.settings )
+                         : worker.pipeline.run(
+                               worker.input.data(), size, a.outputFilename, a.settings );
+        }
+        catch ( const std::exception& e )
+        {
+            LOG( logERROR ) << "Failed job: " << e.what() << ".";
+            if ( !stream.write( std::string( "ERROR " ) + e.what() + "\n" ) ) { return; }
+            continue;
+        }
+        std::ostringstream response;
+        if ( result.success )
+        {
+            LOG( logINFO ) << a.outputFilename << ": " << result.outputTriangles << " faces in "
+                           << result.seconds() << "s.";
+            response << "OK " << result.outputVertices << " " << result.outputTriangles << " "
+                     << result.seconds() << "\n";
+        }
+        else
+        {
+            LOG( logERROR ) << a.outputFilename << ": job failed.";
+            response << "ERROR cannot process " << a.outputFilename << "\n";
+        }
+        if ( !stream.write( response.str() ) ) { return; }
+    }
+    if ( stream.tooLong() )
+    {
+        LOG( logERROR ) << "Rejected request line of more than " << maxLineBytes << " bytes.";
+        stream.write( "ERROR request too large\n" );
+    }
+}
+
+bool Server::servePipe() {
+    // responses own the standard output, the log goes to the standard error
+    const int out = dup( STDOUT_FILENO );
+    if ( out < 0 || dup2( STDERR_FILENO, STDOUT_FILENO ) < 0 )
+    {
+        LOG( logERROR ) << "Cannot redirect the standard output.";
+        return false;
+    }
+    Worker worker;
+    serve( STDIN_FILENO, out, worker );
+    ::close( out );
+    return true;
+}
+
+bool Server::serveSocket( const std::string& path ) {
+    sockaddr_un address{};
+    if ( path.size() >= sizeof( address.sun_path ) )
+    {
+        LOG( logERROR ) << "Socket path too long: " << path;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::copy( path.begin(), path.end(), address.sun_path );
+    const int listener = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    ::unlink( path.c_str() );
+    if ( listener < 0 ||
+         ::bind( listener, reinterpret_cast<const sockaddr*>( &address ), sizeof( address ) ) !=
+             0 ||
+         ::listen( listener, 64 ) != 0 )
+    {
+        LOG( logERROR ) << "Cannot listen on " << path;
+        if ( listener >= 0 ) { ::close( listener ); }
+        return false;
+    }
+
+    // connections are queued for the workers, which share the cores like in batch mode
+    const unsigned int workers       = m_workers > 0 ? m_workers : threadCount();
+    const unsigned int threadsPerJob = std::max( 1u, threadCount() / workers );
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<int> connections;
+    auto worker = [&]() {
+        ScopedThreadCount threads( threadsPerJob );
+        Worker state;
+        for ( ;; )
+        {
+            int connection;
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                available.wait( lock, [&]() { return m_quit || !connections.empty(); } );
+                if ( connections.empty() ) { return; }
+                connection = connections.front();
+                connections.pop_front();
+            }
+            serve( connection, connection, state );
+            ::close( connection );
+        }
+    };
+    std::vector<std::thread> pool;
+    for ( unsigned int w = 0; w < workers; ++w )
+    {
+        pool.emplace_back( worker );
+    }
+    LOG( logINFO ) << "Serving on " << path << " with " << workers << " workers.";
+
+    // the listener is polled so that a QUIT request is noticed
+    pollfd listening{listener, POLLIN, 0};
+    while ( !m_quit )
+    {
+        if ( ::poll( &listening, 1, 200 ) <= 0 ) { continue; }
+        const int connection = ::accept( listener, nullptr, nullptr );
+        if ( connection < 0 ) { continue; }
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            connections.push_back( connection );
+        }
+        available.notify_one();
+    }
+    {
+        // m_quit is set without the lock: a worker may be between its check and its wait
+        std::lock_guard<std::mutex> lock( mutex );
+    }
+    available.notify_all();
+    for ( auto& t : pool )
+    {
+        t.join();
+    }
+    for ( int connection : connections )
+    {
+        ::close( connection );
+    }
+    ::close( listener );
+    ::unlink( path.c_str() );
+    LOG( logINFO ) << "Server stopped.";
+    return true;
+}
+
+#else
+
+bool Server::run( const std::string& ) {
+    LOG( logERROR ) << "The server mode is only available on Unix-like systems.";
+    return false;
+}
+
+#endif
+
+} // namespace Subdivision
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Pipeline.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// Long-running subdivision server, so that small jobs do not pay the process start, library
+/// loading and allocator warm-up of a command line run each.
+///
+/// Requests are read from the connections of a Unix domain socket, or from the standard input
+/// (responses on the standard output, the log on the standard error). Each request is a text
+/// header followed by the input mesh:
+///
+///     JOB <argument count> <input bytes>\n
+///     <argument>\n                        one per line, same options as the command line
+///     <input bytes of OBJ text>           parsed in memory by the ObjReader
+///
+/// and gets a one line response:
+///
+///     OK <output vertices> <output faces> <seconds>\n
+///     ERROR <message>\n
+///
+/// With no input bytes, the job reads the -i file of its options (the box if none).
+/// "QUIT\n" stops the server once the running jobs are done, closing the idle connections.
+/// Invalid options or a failing job get an ERROR response; a request of more than 256 arguments,
+/// 1 GiB of input or a line of more than 4 KiB closes its connection.
+/// Only single mesh jobs are accepted (no batch, sequence or profiling).
+///
+/// Connections are processed concurrently by a fixed pool of workers, each owning a Pipeline and
+/// an input buffer that keep their allocations from one job to the next.
+class Server
+{
+  public:
+    /// \param workers number of connections processed concurrently (0: one per core)
+    explicit Server( unsigned int workers ) : m_workers( workers ) {}
+
+    /// Serve \p socket ("-" for the standard input and output) until a QUIT request, or the end
+    /// of the standard input. Returns false if the socket cannot be opened.
+    bool run( const std::string& socket );
+
+  private:
+    /// State kept by a worker between jobs.
+    struct Worker {
+        Pipeline pipeline{false};
+        std::vector<char> input;
+    };
+
+    /// Process the requests read from \p in, and write the responses to \p out, until the end
+    /// of the input or a QUIT request.
+    void serve( int in, int out, Worker& worker );
+
+    bool serveSocket( const std::string& path );
+    bool servePipe();
+
+    unsigned int m_workers;
+    std::atomic<bool> m_quit{false};
+};
+
+} // namespace Subdivision
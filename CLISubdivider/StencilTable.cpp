@@ -0,0 +1,318 @@
+#include "StencilTable.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+namespace {
+
+/// Emit ( coarse vertex, weight ) pairs of refined vertex \p r, following the FlatSubdivider
+/// ordering (vertex points, edge points, face points) and rules.
+template <typename Sink>
+void emitRow( const FlatMesh& mesh, const Connectivity& c, Scheme scheme, size_t r, Sink& sink ) {
+    const size_t nv = mesh.nVertices();
+    const size_t ne = c.nEdges();
+
+    auto emitFace = [&]( uint f, Scalar w ) {
+        const uint k = mesh.faceSize( f );
+        for ( uint i = mesh.faceOffsets[f]; i < mesh.faceOffsets[f + 1]; ++i )
+        {
+            sink( mesh.faceIndices[i], w / k );
+        }
+    };
+
+    if ( r >= nv + ne )
+    {
+        // face point (Catmull-Clark)
+        emitFace( uint( r - nv - ne ), 1 );
+        return;
+    }
+
+    if ( r >= nv )
+    {
+        const uint e     = uint( r - nv );
+        const auto& edge = c.edges[e];
+        if ( edge.nFaces != 2 )
+        {
+            sink( edge.v0, Scalar( 0.5 ) );
+            sink( edge.v1, Scalar( 0.5 ) );
+        }
+        else if ( scheme == Scheme::Loop )
+        {
+            sink( edge.v0, Scalar( 3. / 8. ) );
+            sink( edge.v1, Scalar( 3. / 8. ) );
+            for ( uint f : {edge.f0, edge.f1} )
+            {
+                const uint o = mesh.faceOffsets[f];
+                for ( uint i = 0; i < 3; ++i )
+                {
+                    if ( c.cornerEdges[o + i] == e )
+                    { sink( mesh.faceIndices[o + ( i + 2 ) % 3], Scalar( 1. / 8. ) ); }
+                }
+            }
+        }
+        else
+        {
+            sink( edge.v0, Scalar( 0.25 ) );
+            sink( edge.v1, Scalar( 0.25 ) );
+            emitFace( edge.f0, Scalar( 0.25 ) );
+            emitFace( edge.f1, Scalar( 0.25 ) );
+        }
+        return;
+    }
+
+    // vertex point: classify the vertex as in FlatSubdivider
+    const uint v      = uint( r );
+    uint nFaces       = 0;
+    uint nBoundary    = 0;
+    uint boundary[2]  = {0, 0};
+    bool nonManifold  = false;
+    for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+    {
+        const uint f = c.vertexFaces[j];
+        const uint o = mesh.faceOffsets[f];
+        const uint k = mesh.faceSize( f );
+        for ( uint i = 0; i < k; ++i )
+        {
+            if ( mesh.faceIndices[o + i] != v ) { continue; }
+            ++nFaces;
+            const uint cPrev = o + ( i + k - 1 ) % k;
+            const auto& eOut = c.edges[c.cornerEdges[o + i]];
+            const auto& eIn  = c.edges[c.cornerEdges[cPrev]];
+            if ( eOut.isBoundary() && nBoundary++ < 2 )
+            { boundary[nBoundary - 1] = mesh.faceIndices[o + ( i + 1 ) % k]; }
+            if ( eIn.isBoundary() && nBoundary++ < 2 )
+            { boundary[nBoundary - 1] = mesh.faceIndices[cPrev]; }
+            nonManifold = nonManifold || !eOut.isManifold() || !eIn.isManifold();
+        }
+    }
+
+    if ( nFaces == 0 || nonManifold || ( nBoundary != 0 && nBoundary != 2 ) )
+    {
+        sink( v, 1 );
+        return;
+    }
+    if ( nBoundary == 2 )
+    {
+        sink( v, Scalar( 0.75 ) );
+        sink( boundary[0], Scalar( 0.125 ) );
+        sink( boundary[1], Scalar( 0.125 ) );
+        return;
+    }
+
+    const Scalar n = Scalar( nFaces );
+    // weight of each next / previous corner of the incident faces (neighbours appear twice)
+    const Scalar wNeighbour =
+        scheme == Scheme::Loop ? Scalar( 0.5 ) * loopBeta( nFaces ) : 1 / ( 2 * n * n );
+    sink( v, scheme == Scheme::Loop ? 1 - n * loopBeta( nFaces ) : ( n - 2 ) / n );
+    for ( uint j = c.vertexFaceOffsets[v]; j < c.vertexFaceOffsets[v + 1]; ++j )
+    {
+        const uint f = c.vertexFaces[j];
+        const uint o = mesh.faceOffsets[f];
+        const uint k = mesh.faceSize( f );
+        for ( uint i = 0; i < k; ++i )
+        {
+            if ( mesh.faceIndices[o + i] != v ) { continue; }
+            sink( mesh.faceIndices[o + ( i + 1 ) % k], wNeighbour );
+            sink( mesh.faceIndices[o + ( i + k - 1 ) % k], wNeighbour );
+            // Catmull-Clark: average of the incident face points
+            if ( scheme == Scheme::CatmullClark ) { emitFace( f, 1 / ( n * n ) ); }
+        }
+    }
+}
+
+void buildLevel( const FlatMesh& mesh,
+                 const Connectivity& c,
+                 Scheme scheme,
+                 StencilTable::Level& level ) {
+    const size_t rows = mesh.nVertices() + c.nEdges() +
+                        ( scheme == Scheme::CatmullClark ? mesh.nFaces() : 0 );
+    level.offsets.assign( rows + 1, 0 );
+    parallelFor( 0, rows, [&]( size_t r ) {
+        uint count = 0;
+        auto counter = [&count]( uint, Scalar ) { ++count; };
+        emitRow( mesh, c, scheme, r, counter );
+        level.offsets[r] = count;
+    } );
+    exclusiveScan( level.offsets );
+
+    level.indices.resize( level.offsets.back() );
+    level.weights.resize( level.offsets.back() );
+    parallelFor( 0, rows, [&]( size_t r ) {
+        uint out    = level.offsets[r];
+        auto writer = [&]( uint i, Scalar w ) {
+            level.indices[out] = i;
+            level.weights[out] = w;
+            ++out;
+        };
+        emitRow( mesh, c, scheme, r, writer );
+    } );
+}
+
+} // namespace
+
+bool StencilTable::build( const FlatMesh& coarse,
+                          Scheme scheme,
+                          int iterations,
+                          FlatMesh& refined,
+                          Arena* arena ) {
+    if ( scheme == Scheme::Loop && !coarse.isUniform( 3 ) ) { return false; }
+
+    // start from the identity
+    m_cols = coarse.nVertices();
+    m_offsets.resize( m_cols + 1 );
+    m_indices.resize( m_cols );
+    m_weights.assign( m_cols, 1 );
+    for ( size_t i = 0; i <= m_cols; ++i )
+    {
+        m_offsets[i] = uint( i );
+        if ( i < m_cols ) { m_indices[i] = uint( i ); }
+    }
+
+    FlatSubdivider subdivider( scheme );
+    FlatSubdivider::Workspace workspace( arena );
+    refined = coarse;
+    Level level( arena );
+    for ( int i = 0; i < iterations; ++i )
+    {
+        workspace.connectivity.build( refined );
+        buildLevel( refined, workspace.connectivity, scheme, level );
+        compose( level );
+        subdivider.refine( refined, workspace.connectivity, workspace.refined );
+        std::swap( refined, workspace.refined );
+    }
+    return true;
+}
+
+void StencilTable::compose( const Level& level ) {
+    // Row by row sparse product (Gustavson), rows split in blocks processed in parallel.
+    const size_t rows    = level.offsets.size() - 1;
+    const size_t nBlocks = std::max<size_t>( 1, std::min<size_t>( 4 * threadCount(), rows / 256 ) );
+    struct Block {
+        std::vector<uint> counts;
+        std::vector<uint> indices;
+        std::vector<Scalar> weights;
+    };
+    std::vector<Block> blocks( nBlocks );
+
+    parallelFor(
+        0,
+        nBlocks,
+        [&]( size_t b ) {
+            Block& block     = blocks[b];
+            const size_t r0  = b * rows / nBlocks;
+            const size_t r1  = ( b + 1 ) * rows / nBlocks;
+            std::vector<Scalar> accumulator( m_cols, 0 );
+            std::vector<uint> touched;
+            block.counts.reserve( r1 - r0 );
+            for ( size_t r = r0; r < r1; ++r )
+            {
+                touched.clear();
+                for ( uint j = level.offsets[r]; j < level.offsets[r + 1]; ++j )
+                {
+                    const uint src = level.indices[j];
+                    const Scalar w = level.weights[j];
+                    for ( uint k = m_offsets[src]; k < m_offsets[src + 1]; ++k )
+                    {
+                        const uint col = m_indices[k];
+                        if ( accumulator[col] == 0 ) { touched.push_back( col ); }
+                        accumulator[col] += w * m_weights[k];
+                    }
+                }
+                // sorted columns give a more cache friendly gather in apply()
+                std::sort( touched.begin(), touched.end() );
+                touched.erase( std::unique( touched.begin(), touched.end() ), touched.end() );
+                block.counts.push_back( uint( touched.size() ) );
+                for ( uint col : touched )
+                {
+                    block.indices.push_back( col );
+                    block.weights.push_back( accumulator[col] );
+                    accumulator[col] = 0;
+                }
+            }
+        },
+        1 );
+
+    std::vector<size_t> blockOffsets( nBlocks + 1, 0 );
+    for ( size_t b = 0; b < nBlocks; ++b )
+    {
+        blockOffsets[b + 1] = blockOffsets[b] + blocks[b].indices.size();
+    }
+    std::vector<uint> offsets( rows + 1 );
+    std::vector<uint> indices( blockOffsets[nBlocks] );
+    std::vector<Scalar> weights( blockOffsets[nBlocks] );
+    parallelFor(
+        0,
+        nBlocks,
+        [&]( size_t b ) {
+            size_t r   = b * rows / nBlocks;
+            uint start = uint( blockOffsets[b] );
+            for ( uint count : blocks[b].counts )
+            {
+                offsets[r++] = start;
+                start += count;
+            }
+            std::copy( blocks[b].indices.begin(),
+                       blocks[b].indices.end(),
+                       indices.begin() + blockOffsets[b] );
+            std::copy( blocks[b].weights.begin(),
+                       blocks[b].weights.end(),
+                       weights.begin() + blockOffsets[b] );
+            blocks[b] = Block();
+        },
+        1 );
+    offsets[rows] = uint( blockOffsets[nBlocks] );
+
+    m_offsets.swap( offsets );
+    m_indices.swap( indices );
+    m_weights.swap( weights );
+}
+
+void StencilTable::apply( const Vector3Array& in, Vector3Array& out ) const {
+    // Positions are padded to 4 components, so that each stencil term is a single SIMD
+    // multiply-add on an aligned packet.
+    m_input.resize( in.size() );
+    parallelFor( 0, in.size(), [&]( size_t i ) {
+        m_input[i] << in[i], 0;
+    } );
+
+    out.resize( rows() );
+    parallelFor( 0, rows(), [&]( size_t r ) {
+        Vector4 sum = Vector4::Zero();
+        for ( uint k = m_offsets[r]; k < m_offsets[r + 1]; ++k )
+        {
+            sum += m_weights[k] * m_input[m_indices[k]];
+        }
+        out[r] = sum.head<3>();
+    } );
+}
+
+void StencilTable::apply( const std::vector<const Scalar*>& in,
+                          const std::vector<Scalar*>& out ) const {
+    const size_t nComponents = in.size();
+    parallelForRange( 0, rows(), [&]( size_t b, size_t e ) {
+        std::vector<Scalar> sum( nComponents );
+        for ( size_t r = b; r < e; ++r )
+        {
+            std::fill( sum.begin(), sum.end(), Scalar( 0 ) );
+            for ( uint k = m_offsets[r]; k < m_offsets[r + 1]; ++k )
+            {
+                const Scalar w = m_weights[k];
+                const uint j   = m_indices[k];
+                for ( size_t c = 0; c < nComponents; ++c )
+                {
+                    sum[c] += w * in[c][j];
+                }
+            }
+            for ( size_t c = 0; c < nComponents; ++c )
+            {
+                out[c][r] = sum[c];
+            }
+        }
+    } );
+}
+
+} // namespace Subdivision
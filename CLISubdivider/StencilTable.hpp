@@ -0,0 +1,64 @@
+#pragma once
+
+#include "FlatSubdivider.hpp"
+
+#include <Core/Types.hpp>
+
+#include <vector>
+
+namespace Subdivision {
+
+/// Sparse matrix (CSR) giving each refined vertex as a weighted sum of the coarse vertices.
+///
+/// The table is built once from the topology of a mesh, by composing the Loop or Catmull-Clark
+/// stencils of each refinement level (same rules as FlatSubdivider). Refining a new set of
+/// positions with the same connectivity is then a single sparse matrix-vector product.
+class StencilTable
+{
+  public:
+    /// Build the table for \p iterations refinements of \p coarse.
+    /// \p refined receives the refined mesh (faces and positions of \p coarse refined).
+    /// The stencils and the topology of each level are served by \p arena when one is given,
+    /// the table itself is not.
+    /// Returns false if the mesh cannot be processed (Loop requires triangles).
+    bool build( const FlatMesh& coarse,
+                Scheme scheme,
+                int iterations,
+                FlatMesh& refined,
+                Arena* arena = nullptr );
+
+    /// out[i] = sum_j w_ij in[j], computed in parallel. \p in must have cols() elements.
+    void apply( const Ra::Core::Vector3Array& in, Ra::Core::Vector3Array& out ) const;
+
+    /// Fused product over structure of arrays channels: out[c][i] = sum_j w_ij in[c][j] for all
+    /// the components c at once, so that the table is traversed a single time.
+    /// Each \p in array has cols() elements, each \p out array rows() elements.
+    void apply( const std::vector<const Scalar*>& in, const std::vector<Scalar*>& out ) const;
+
+    inline size_t rows() const { return m_offsets.size() - 1; }
+    inline size_t cols() const { return m_cols; }
+    inline size_t nonZeros() const { return m_indices.size(); }
+
+    /// Stencils of one refinement level, in CSR form.
+    struct Level {
+        explicit Level( Arena* arena = nullptr ) :
+            offsets( 1, 0, arena ), indices( arena ), weights( arena ) {}
+
+        ArenaVector<uint> offsets;
+        ArenaVector<uint> indices;
+        ArenaVector<Scalar> weights;
+    };
+
+  private:
+    /// this = level * this
+    void compose( const Level& level );
+
+    std::vector<uint> m_offsets{0};
+    std::vector<uint> m_indices;
+    std::vector<Scalar> m_weights;
+    size_t m_cols{0};
+    /// SIMD friendly (padded and aligned) copy of the input positions
+    mutable Ra::Core::Vector4Array m_input;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,476 @@
+#include "TiledSubdivider.hpp"
+#include "Parallel.hpp"
+
+#include <Core/Utils/Log.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+using namespace Ra::Core::Utils; // log
+
+namespace {
+
+/// Place of a refined vertex on the coarse mesh (global indices).
+struct Location {
+    enum Type : uint8_t { Vertex, Edge, Face };
+    Type type;
+    uint id;
+    /// Edge only: position along the coarse edge, from v0 (0) to v1 (2^iterations)
+    uint k;
+};
+
+/// Number of faces refined from a coarse face of \p k vertices.
+uint64_t refinedFaces( Scheme scheme, uint k, int iterations ) {
+    return scheme == Scheme::Loop ? uint64_t( 1 ) << ( 2 * iterations )
+                                  : uint64_t( k ) << ( 2 * ( iterations - 1 ) );
+}
+
+/// Number of refined vertices strictly inside a coarse face of \p k vertices.
+uint64_t interiorVertices( Scheme scheme, uint k, int iterations ) {
+    const uint64_t n = uint64_t( 1 ) << iterations;
+    if ( scheme == Scheme::Loop ) { return ( n - 1 ) * ( n - 2 ) / 2; }
+    // k grids of ( n / 2 ) x ( n / 2 ) quads around the face point
+    const uint64_t m = n / 2;
+    return 1 + k * ( m - 1 ) * m;
+}
+
+/// Interleave the 10 lower bits of \p x with two zero bits.
+uint spreadBits( uint x ) {
+    x &= 0x3ff;
+    x = ( x | ( x << 16 ) ) & 0x030000ff;
+    x = ( x | ( x << 8 ) ) & 0x0300f00f;
+    x = ( x | ( x << 4 ) ) & 0x030c30c3;
+    x = ( x | ( x << 2 ) ) & 0x09249249;
+    return x;
+}
+
+/// Shared, read-only data of a tiled run.
+struct TiledContext {
+    const FlatMesh& coarse;
+    const Connectivity& connectivity;
+    Scheme scheme;
+    int iterations;
+    const ArenaVector<uint>& faces;
+    const ArenaVector<size_t>& patchOffsets;
+    const ArenaVector<uint64_t>& firstFace;
+    const ArenaVector<uint64_t>& firstVertex;
+    /// Patch of each coarse face
+    const ArenaVector<uint>& facePatch;
+    /// Global index of the first vertex inside a coarse edge, then inside a coarse face
+    uint64_t edgeVertexStart;
+    uint64_t faceVertexStart;
+    MeshFileWriter& writer;
+};
+
+/// Refines the patches of one thread, reusing its buffers from one patch to the next.
+class PatchProcessor
+{
+  public:
+    explicit PatchProcessor( const TiledContext& context ) :
+        m_context( context ),
+        m_subdivider( context.scheme ),
+        m_toLocal( context.coarse.nVertices(), Connectivity::Invalid ),
+        m_faceMark( context.coarse.nFaces(), 0 ) {}
+
+    bool process( size_t patch );
+
+  private:
+    void buildLocalMesh( size_t patch );
+    void refine();
+    bool alongCoarseEdge( const Location& a, const Location& b, Location& mid ) const;
+    bool write( size_t patch );
+
+    const TiledContext& m_context;
+    FlatSubdivider m_subdivider;
+    /// coarse vertex to local vertex, Invalid when not in the patch
+    std::vector<uint> m_toLocal;
+    std::vector<uint8_t> m_faceMark;
+
+    /// coarse faces of the patch: owned faces, then their one-ring
+    std::vector<uint> m_localFaces;
+    FlatMesh m_mesh;
+    FlatMesh m_refined;
+    Connectivity m_connectivity;
+    std::vector<Location> m_location, m_nextLocation;
+    /// index in m_localFaces of the coarse face containing each face
+    std::vector<uint> m_ancestor, m_nextAncestor;
+
+    std::vector<uint> m_global;
+    std::vector<uint> m_indices;
+    std::vector<std::pair<uint, uint>> m_written;
+    Vector3Array m_run;
+};
+
+bool PatchProcessor::process( size_t patch ) {
+    buildLocalMesh( patch );
+    for ( int i = 0; i < m_context.iterations; ++i )
+    {
+        refine();
+    }
+    return write( patch );
+}
+
+void PatchProcessor::buildLocalMesh( size_t patch ) {
+    const FlatMesh& coarse = m_context.coarse;
+    const Connectivity& c  = m_context.connectivity;
+
+    m_localFaces.assign( m_context.faces.begin() + m_context.patchOffsets[patch],
+                         m_context.faces.begin() + m_context.patchOffsets[patch + 1] );
+    const size_t nOwned = m_localFaces.size();
+    for ( uint f : m_localFaces )
+    {
+        m_faceMark[f] = 1;
+    }
+    for ( size_t i = 0; i < nOwned; ++i )
+    {
+        const uint f = m_localFaces[i];
+        for ( uint j = coarse.faceOffsets[f]; j < coarse.faceOffsets[f + 1]; ++j )
+        {
+            const uint v = coarse.faceIndices[j];
+            for ( uint r = c.vertexFaceOffsets[v]; r < c.vertexFaceOffsets[v + 1]; ++r )
+            {
+                const uint g = c.vertexFaces[r];
+                if ( !m_faceMark[g] )
+                {
+                    m_faceMark[g] = 1;
+                    m_localFaces.push_back( g );
+                }
+            }
+        }
+    }
+
+    m_mesh.positions.clear();
+    m_mesh.faceOffsets.assign( 1, 0 );
+    m_mesh.faceIndices.clear();
+    m_location.clear();
+    for ( uint f : m_localFaces )
+    {
+        m_faceMark[f] = 0;
+        for ( uint j = coarse.faceOffsets[f]; j < coarse.faceOffsets[f + 1]; ++j )
+        {
+            const uint v = coarse.faceIndices[j];
+            if ( m_toLocal[v] == Connectivity::Invalid )
+            {
+                m_toLocal[v] = uint( m_mesh.positions.size() );
+                m_mesh.positions.push_back( coarse.positions[v] );
+                m_location.push_back( {Location::Vertex, v, 0} );
+            }
+            m_mesh.faceIndices.push_back( m_toLocal[v] );
+        }
+        m_mesh.faceOffsets.push_back( uint( m_mesh.faceIndices.size() ) );
+    }
+    for ( const auto& l : m_location )
+    {
+        m_toLocal[l.id] = Connectivity::Invalid;
+    }
+
+    m_ancestor.resize( m_localFaces.size() );
+    for ( size_t f = 0; f < m_ancestor.size(); ++f )
+    {
+        m_ancestor[f] = uint( f );
+    }
+}
+
+void PatchProcessor::refine() {
+    m_connectivity.build( m_mesh );
+    m_subdivider.refine( m_mesh, m_connectivity, m_refined );
+
+    const size_t nv = m_mesh.nVertices();
+    const size_t ne = m_connectivity.nEdges();
+    const size_t nf = m_mesh.nFaces();
+
+    // locations follow the FlatSubdivider ordering: vertex, edge and face points
+    m_nextLocation.resize( m_refined.nVertices() );
+    std::copy( m_location.begin(), m_location.end(), m_nextLocation.begin() );
+    for ( size_t e = 0; e < ne; ++e )
+    {
+        const auto& edge = m_connectivity.edges[e];
+        Location& mid    = m_nextLocation[nv + e];
+        if ( !alongCoarseEdge( m_location[edge.v0], m_location[edge.v1], mid ) )
+        { mid = {Location::Face, m_localFaces[m_ancestor[edge.f0]], 0}; }
+    }
+    if ( m_context.scheme == Scheme::CatmullClark )
+    {
+        for ( size_t f = 0; f < nf; ++f )
+        {
+            m_nextLocation[nv + ne + f] = {Location::Face, m_localFaces[m_ancestor[f]], 0};
+        }
+    }
+
+    // children of a face are stored contiguously: 4 triangles (Loop), one quad per corner (Catmull)
+    m_nextAncestor.resize( m_refined.nFaces() );
+    for ( size_t f = 0; f < nf; ++f )
+    {
+        const uint first = m_context.scheme == Scheme::Loop ? uint( 4 * f ) : m_mesh.faceOffsets[f];
+        const uint last =
+            m_context.scheme == Scheme::Loop ? uint( 4 * f + 4 ) : m_mesh.faceOffsets[f + 1];
+        std::fill( m_nextAncestor.begin() + first, m_nextAncestor.begin() + last, m_ancestor[f] );
+    }
+
+    std::swap( m_mesh, m_refined );
+    std::swap( m_location, m_nextLocation );
+    std::swap( m_ancestor, m_nextAncestor );
+}
+
+bool PatchProcessor::alongCoarseEdge( const Location& a, const Location& b, Location& mid ) const {
+    const Connectivity& c = m_context.connectivity;
+    const uint n          = 1u << m_context.iterations;
+
+    uint e;
+    if ( a.type == Location::Vertex && b.type == Location::Vertex ) { e = c.findEdge( a.id, b.id ); }
+    else if ( a.type == Location::Edge )
+    { e = a.id; }
+    else if ( b.type == Location::Edge )
+    { e = b.id; }
+    else
+    { return false; }
+    if ( e == Connectivity::Invalid ) { return false; }
+
+    auto position = [&c, e, n]( const Location& l, uint& k ) {
+        if ( l.type == Location::Edge )
+        {
+            k = l.k;
+            return l.id == e;
+        }
+        if ( l.type == Location::Vertex )
+        {
+            k = l.id == c.edges[e].v0 ? 0 : n;
+            return l.id == c.edges[e].v0 || l.id == c.edges[e].v1;
+        }
+        return false;
+    };
+    uint ka, kb;
+    if ( !position( a, ka ) || !position( b, kb ) ) { return false; }
+    mid = {Location::Edge, e, ( ka + kb ) / 2};
+    return true;
+}
+
+bool PatchProcessor::write( size_t patch ) {
+    // owned faces come first, and their children stay in front at each level
+    const uint faceSize  = m_context.scheme == Scheme::Loop ? 3 : 4;
+    const size_t nFaces  = size_t( m_context.firstFace[patch + 1] - m_context.firstFace[patch] );
+    const uint edgeSteps = ( 1u << m_context.iterations ) - 1;
+
+    m_global.assign( m_mesh.nVertices(), Connectivity::Invalid );
+    m_indices.resize( nFaces * faceSize );
+    uint64_t next = m_context.faceVertexStart + m_context.firstVertex[patch];
+    for ( size_t i = 0; i < m_indices.size(); ++i )
+    {
+        const uint v = m_mesh.faceIndices[i];
+        if ( m_global[v] == Connectivity::Invalid )
+        {
+            const Location& l = m_location[v];
+            switch ( l.type )
+            {
+            case Location::Vertex:
+                m_global[v] = l.id;
+                break;
+            case Location::Edge:
+                m_global[v] = uint( m_context.edgeVertexStart + uint64_t( l.id ) * edgeSteps + l.k - 1 );
+                break;
+            default:
+                m_global[v] = uint( next++ );
+            }
+        }
+        m_indices[i] = m_global[v];
+    }
+    if ( next != m_context.faceVertexStart + m_context.firstVertex[patch + 1] ) { return false; }
+    m_context.writer.writeFaces( size_t( m_context.firstFace[patch] ), m_indices.data(), nFaces );
+
+    // Vertices, by runs of consecutive global indices. A vertex shared with other patches is
+    // written by the patch of its first coarse face only, so that the output does not depend on
+    // the order in which patches are processed.
+    const Connectivity& c = m_context.connectivity;
+    auto isWriter         = [&]( const Location& l ) {
+        switch ( l.type )
+        {
+        case Location::Vertex:
+            return m_context.facePatch[c.vertexFaces[c.vertexFaceOffsets[l.id]]] == patch;
+        case Location::Edge:
+            return m_context.facePatch[c.edges[l.id].f0] == patch;
+        default:
+            return true;
+        }
+    };
+    m_written.clear();
+    for ( size_t v = 0; v < m_global.size(); ++v )
+    {
+        if ( m_global[v] != Connectivity::Invalid && isWriter( m_location[v] ) )
+        { m_written.emplace_back( m_global[v], uint( v ) ); }
+    }
+    std::sort( m_written.begin(), m_written.end() );
+    for ( size_t b = 0; b < m_written.size(); )
+    {
+        size_t e = b + 1;
+        while ( e < m_written.size() && m_written[e].first == m_written[e - 1].first + 1 )
+        {
+            ++e;
+        }
+        m_run.resize( e - b );
+        for ( size_t i = b; i < e; ++i )
+        {
+            m_run[i - b] = m_mesh.positions[m_written[i].second];
+        }
+        m_context.writer.writeVertices( m_written[b].first, m_run.data(), m_run.size() );
+        b = e;
+    }
+    return true;
+}
+
+} // namespace
+
+void TiledSubdivider::partition( const FlatMesh& coarse,
+                                 ArenaVector<uint>& faces,
+                                 ArenaVector<size_t>& patchOffsets ) const {
+    const size_t nf = coarse.nFaces();
+    Aabb box;
+    for ( const auto& p : coarse.positions )
+    {
+        box.extend( p );
+    }
+    const Vector3 scale = ( box.sizes().array() > 0 )
+                              .select( Scalar( 1023 ) / box.sizes().array(), Scalar( 0 ) );
+
+    // faces sorted along a Morton curve of their centroid, so that patches are compact
+    ArenaVector<std::pair<uint, uint>> keys( nf, m_arena );
+    parallelFor( 0, nf, [&]( size_t f ) {
+        Vector3 centroid = Vector3::Zero();
+        for ( uint i = coarse.faceOffsets[f]; i < coarse.faceOffsets[f + 1]; ++i )
+        {
+            centroid += coarse.positions[coarse.faceIndices[i]];
+        }
+        centroid /= Scalar( coarse.faceSize( f ) );
+        const Vector3 cell = ( centroid - box.min() ).cwiseProduct( scale );
+        keys[f]            = {spreadBits( uint( cell.x() ) ) | ( spreadBits( uint( cell.y() ) ) << 1 ) |
+                       ( spreadBits( uint( cell.z() ) ) << 2 ),
+                   uint( f )};
+    } );
+    std::sort( keys.begin(), keys.end() );
+
+    faces.resize( nf );
+    for ( size_t f = 0; f < nf; ++f )
+    {
+        faces[f] = keys[f].second;
+    }
+    const size_t patchFaces = std::max<size_t>( 1, m_settings.patchFaces );
+    patchOffsets.clear();
+    for ( size_t f = 0; f < nf; f += patchFaces )
+    {
+        patchOffsets.push_back( f );
+    }
+    patchOffsets.push_back( nf );
+}
+
+bool TiledSubdivider::run( const FlatMesh& coarse, const std::string& output ) {
+    const Scheme scheme  = m_settings.scheme;
+    const int iterations = m_settings.iterations;
+    if ( m_settings.format == OutputFormat::Obj )
+    {
+        LOG( logERROR ) << "Tiled subdivision writes ply or rbm files.";
+        return false;
+    }
+    if ( iterations < 1 || iterations > 15 )
+    {
+        LOG( logERROR ) << "Tiled subdivision requires 1 to 15 iterations.";
+        return false;
+    }
+    if ( scheme == Scheme::Loop && !coarse.isUniform( 3 ) )
+    {
+        LOG( logERROR ) << "Loop subdivision requires a triangle mesh.";
+        return false;
+    }
+
+    Connectivity c( m_arena );
+    c.build( coarse );
+    ArenaVector<uint> faces( m_arena );
+    ArenaVector<size_t> patchOffsets( m_arena );
+    partition( coarse, faces, patchOffsets );
+    const size_t nPatches = patchOffsets.size() - 1;
+
+    // output blocks of each patch: its faces, and the vertices inside its faces
+    ArenaVector<uint64_t> firstFace( nPatches + 1, 0, m_arena );
+    ArenaVector<uint64_t> firstVertex( nPatches + 1, 0, m_arena );
+    for ( size_t p = 0; p < nPatches; ++p )
+    {
+        for ( size_t i = patchOffsets[p]; i < patchOffsets[p + 1]; ++i )
+        {
+            const uint k = coarse.faceSize( faces[i] );
+            firstFace[p] += refinedFaces( scheme, k, iterations );
+            firstVertex[p] += interiorVertices( scheme, k, iterations );
+        }
+    }
+    exclusiveScan( firstFace );
+    exclusiveScan( firstVertex );
+    ArenaVector<uint> facePatch( coarse.nFaces(), m_arena );
+    for ( size_t p = 0; p < nPatches; ++p )
+    {
+        for ( size_t i = patchOffsets[p]; i < patchOffsets[p + 1]; ++i )
+        {
+            facePatch[faces[i]] = uint( p );
+        }
+    }
+    const uint64_t edgeVertexStart = coarse.nVertices();
+    const uint64_t faceVertexStart =
+        edgeVertexStart + uint64_t( c.nEdges() ) * ( ( uint64_t( 1 ) << iterations ) - 1 );
+    const uint64_t nVertices = faceVertexStart + firstVertex.back();
+    if ( nVertices >= Connectivity::Invalid )
+    {
+        LOG( logERROR ) << "The refined mesh exceeds 32 bits vertex indices.";
+        return false;
+    }
+    m_vertexCount = size_t( nVertices );
+    m_faceCount   = size_t( firstFace.back() );
+
+    MeshFileWriter writer;
+    if ( !writer.open( output + outputExtension( m_settings.format ),
+                       m_settings.format,
+                       m_vertexCount,
+                       m_faceCount,
+                       scheme == Scheme::Loop ? 3 : 4 ) )
+    { return false; }
+    // isolated vertices keep their position, the others are overwritten by the patches
+    writer.writeVertices( 0, coarse.positions.data(), coarse.nVertices() );
+
+    const TiledContext context{coarse,
+                               c,
+                               scheme,
+                               iterations,
+                               faces,
+                               patchOffsets,
+                               firstFace,
+                               firstVertex,
+                               facePatch,
+                               edgeVertexStart,
+                               faceVertexStart,
+                               writer};
+    std::atomic<bool> valid{true};
+    // one patch per thread at a time, each one refined sequentially
+    parallelForRange(
+        0,
+        nPatches,
+        [&]( size_t b, size_t e ) {
+            ScopedThreadCount sequential( 1 );
+            PatchProcessor processor( context );
+            for ( size_t p = b; p < e && valid; ++p )
+            {
+                if ( !processor.process( p ) ) { valid = false; }
+            }
+        },
+        1 );
+    if ( !valid )
+    {
+        LOG( logERROR ) << "The mesh topology is not supported by the tiled subdivision.";
+        return false;
+    }
+    if ( !writer.close() )
+    {
+        LOG( logERROR ) << "Cannot write " << output;
+        return false;
+    }
+    return true;
+}
+
+} // namespace Subdivision
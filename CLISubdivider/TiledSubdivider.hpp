@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Pipeline.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Subdivision {
+
+/// Out-of-core uniform subdivision: the refined mesh is never held in memory.
+///
+/// The coarse faces are sorted along a Morton curve and cut into patches of about
+/// Settings::patchFaces faces. Each patch is extended by the one-ring of its faces, which is
+/// enough for the subdivision stencils of its own faces at every level, and refined
+/// independently with the FlatSubdivider. Patches are processed in parallel (one per thread) and
+/// write their faces and vertices directly at their final place in a ply or rbm file.
+///
+/// Vertex indices are global and do not depend on the patch: coarse vertices keep their index,
+/// the vertices inside a coarse edge are numbered along the edge, and the vertices inside a
+/// coarse face are numbered by the patch owning the face. Peak memory is then the coarse mesh
+/// plus one refined patch per thread.
+class TiledSubdivider
+{
+  public:
+    /// The coarse tables (connectivity, partition and output blocks) are served by \p arena
+    /// when one is given. The patches are refined by the worker threads, in buffers of their own.
+    explicit TiledSubdivider( const Settings& settings, Arena* arena = nullptr ) :
+        m_settings( settings ), m_arena( arena ) {}
+
+    /// Subdivide \p coarse and write the result to \p output (the extension of the output format
+    /// is added). Returns false on error.
+    bool run( const FlatMesh& coarse, const std::string& output );
+
+    /// Size of the refined mesh written by the last run.
+    inline size_t vertexCount() const { return m_vertexCount; }
+    inline size_t faceCount() const { return m_faceCount; }
+
+  private:
+    /// Faces of the coarse mesh, sorted by patch, and first face of each patch.
+    void partition( const FlatMesh& coarse,
+                    ArenaVector<uint>& faces,
+                    ArenaVector<size_t>& patchOffsets ) const;
+
+    Settings m_settings;
+    Arena* m_arena;
+    size_t m_vertexCount{0};
+    size_t m_faceCount{0};
+};
+
+} // namespace Subdivision
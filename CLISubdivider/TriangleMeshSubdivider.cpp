@@ -0,0 +1,287 @@
+#include "TriangleMeshSubdivider.hpp"
+#include "FlatSubdivider.hpp"
+#include "Parallel.hpp"
+
+#include <Core/Geometry/StandardAttribNames.hpp>
+#include <Core/Utils/Attribs.hpp>
+#include <Core/Utils/Log.hpp>
+
+#include <atomic>
+#include <type_traits>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+
+namespace {
+constexpr uint Invalid = uint( -1 );
+
+inline Scalar zero( const Scalar& ) {
+    return 0;
+}
+template <typename V>
+inline V zero( const V& ) {
+    return V::Zero();
+}
+
+/// Vertex attribute other than the positions and normals, refined along them.
+template <typename T>
+struct Channel {
+    std::string name;
+    typename Utils::Attrib<T>::Container data;
+    typename Utils::Attrib<T>::Container next;
+};
+} // namespace
+
+struct TriangleMeshSubdivider::Channels {
+    std::vector<Channel<Scalar>> scalars;
+    std::vector<Channel<Vector2>> vectors2;
+    std::vector<Channel<Vector3>> vectors3;
+    std::vector<Channel<Vector4>> vectors4;
+
+    template <typename F>
+    void forEach( const F& f ) {
+        for ( auto& c : scalars )
+        {
+            f( c );
+        }
+        for ( auto& c : vectors2 )
+        {
+            f( c );
+        }
+        for ( auto& c : vectors3 )
+        {
+            f( c );
+        }
+        for ( auto& c : vectors4 )
+        {
+            f( c );
+        }
+    }
+};
+
+void TriangleMeshSubdivider::operator()( Geometry::TriangleMesh& mesh, int iterations ) {
+    // only the coarse arrays are copied, each level is then written into the spare buffers
+    Vector3Array positions   = mesh.vertices();
+    const bool hasNormals    = mesh.normals().size() == positions.size();
+    Vector3Array normals     = hasNormals ? mesh.normals() : Vector3Array();
+    Triangles triangles      = mesh.getIndices();
+    Vector3Array nextPositions, nextNormals;
+    Triangles nextTriangles;
+
+    // every other vertex attribute (texture coordinates, colors...) is refined with the same
+    // stencils, so that the attributes keep the vertex count of the mesh
+    const std::string positionName =
+        Geometry::getAttribName( Geometry::MeshAttrib::VERTEX_POSITION );
+    const std::string normalName = Geometry::getAttribName( Geometry::MeshAttrib::VERTEX_NORMAL );
+    const size_t nv              = positions.size();
+    Channels channels;
+    mesh.vertexAttribs().for_each_attrib( [&]( Utils::AttribBase* attrib ) {
+        const std::string& name = attrib->getName();
+        if ( name == positionName || name == normalName ) { return; }
+        if ( attrib->getSize() != nv )
+        {
+            LOG( logWARNING ) << "Attribute " << name << " is not per vertex, it is dropped.";
+        }
+        else if ( attrib->isFloat() )
+        {
+            channels.scalars.push_back(
+                {name, attrib->cast<Utils::Attrib<Scalar>>().data(), {}} );
+        }
+        else if ( attrib->isVector2() )
+        {
+            channels.vectors2.push_back(
+                {name, attrib->cast<Utils::Attrib<Vector2>>().data(), {}} );
+        }
+        else if ( attrib->isVector3() )
+        {
+            channels.vectors3.push_back(
+                {name, attrib->cast<Utils::Attrib<Vector3>>().data(), {}} );
+        }
+        else if ( attrib->isVector4() )
+        {
+            channels.vectors4.push_back(
+                {name, attrib->cast<Utils::Attrib<Vector4>>().data(), {}} );
+        }
+        else
+        {
+            LOG( logWARNING ) << "Attribute " << name
+                              << " has an unsupported type, it is dropped.";
+        }
+    } );
+
+    for ( int i = 0; i < iterations; ++i )
+    {
+        buildEdges( triangles, positions.size() );
+        refineAttribute( positions, nextPositions );
+        if ( hasNormals ) { refineAttribute( normals, nextNormals ); }
+        channels.forEach( [this]( auto& channel ) {
+            refineAttribute( channel.data, channel.next );
+            std::swap( channel.data, channel.next );
+        } );
+        refineTriangles( triangles, nextTriangles );
+        std::swap( positions, nextPositions );
+        std::swap( normals, nextNormals );
+        std::swap( triangles, nextTriangles );
+    }
+    if ( hasNormals )
+    {
+        parallelFor( 0, normals.size(), [&normals]( size_t v ) { normals[v].normalize(); } );
+    }
+
+    Geometry::TriangleMesh out;
+    out.setVertices( std::move( positions ) );
+    if ( hasNormals ) { out.setNormals( std::move( normals ) ); }
+    out.setIndices( std::move( triangles ) );
+    channels.forEach( [&out]( auto& channel ) {
+        using T = typename std::decay_t<decltype( channel.data )>::value_type;
+        out.addAttrib<T>( channel.name, std::move( channel.data ) );
+    } );
+    mesh = std::move( out );
+}
+
+void TriangleMeshSubdivider::buildEdges( const Triangles& triangles, size_t nVertices ) {
+    const size_t nt = triangles.size();
+    const size_t nc = 3 * nt;
+
+    // one key per corner, for the edge going to the next corner
+    m_keys.resize( nc );
+    parallelFor( 0, nt, [&]( size_t t ) {
+        for ( uint i = 0; i < 3; ++i )
+        {
+            const uint a = triangles[t]( i );
+            const uint b = triangles[t]( ( i + 1 ) % 3 );
+            m_keys[3 * t + i] = {( uint64_t( std::min( a, b ) ) << 32 ) | std::max( a, b ),
+                                 uint( 3 * t + i )};
+        }
+    } );
+    parallelSort( m_keys, []( const CornerKey& a, const CornerKey& b ) {
+        return a.key < b.key || ( a.key == b.key && a.corner < b.corner );
+    } );
+
+    // edges are the runs of equal keys
+    ArenaVector<uint> starts( nc + 1, 0, m_keys.get_allocator() );
+    parallelFor( 0, nc, [&]( size_t j ) {
+        starts[j] = ( j == 0 || m_keys[j].key != m_keys[j - 1].key ) ? 1 : 0;
+    } );
+    const size_t ne = exclusiveScan( starts );
+    m_edges.resize( ne );
+    m_cornerEdges.resize( nc );
+    auto opposite = [&triangles]( uint corner ) {
+        return triangles[corner / 3]( ( corner % 3 + 2 ) % 3 );
+    };
+    parallelFor( 0, nc, [&]( size_t j ) {
+        const uint e                      = starts[j + 1] - 1;
+        m_cornerEdges[m_keys[j].corner] = e;
+        if ( starts[j] == starts[j + 1] ) { return; }
+        size_t last = j + 1;
+        while ( last < nc && m_keys[last].key == m_keys[j].key )
+        {
+            ++last;
+        }
+        Edge& edge     = m_edges[e];
+        edge.v0        = uint( m_keys[j].key >> 32 );
+        edge.v1        = uint( m_keys[j].key & 0xffffffff );
+        edge.nFaces    = uint( last - j );
+        edge.opposite0 = opposite( m_keys[j].corner );
+        edge.opposite1 = edge.nFaces > 1 ? opposite( m_keys[j + 1].corner ) : Invalid;
+    } );
+
+    // vertex to edge table
+    std::vector<std::atomic<uint>> counts( nVertices );
+    parallelFor( 0, nVertices, [&]( size_t v ) { counts[v].store( 0, std::memory_order_relaxed ); } );
+    parallelFor( 0, ne, [&]( size_t e ) {
+        counts[m_edges[e].v0].fetch_add( 1, std::memory_order_relaxed );
+        counts[m_edges[e].v1].fetch_add( 1, std::memory_order_relaxed );
+    } );
+    m_vertexEdgeOffsets.resize( nVertices + 1 );
+    uint sum = 0;
+    for ( size_t v = 0; v < nVertices; ++v )
+    {
+        m_vertexEdgeOffsets[v] = sum;
+        sum += counts[v].load( std::memory_order_relaxed );
+        counts[v].store( m_vertexEdgeOffsets[v], std::memory_order_relaxed );
+    }
+    m_vertexEdgeOffsets[nVertices] = sum;
+    m_vertexEdges.resize( sum );
+    parallelFor( 0, ne, [&]( size_t e ) {
+        for ( uint v : {m_edges[e].v0, m_edges[e].v1} )
+        {
+            m_vertexEdges[counts[v].fetch_add( 1, std::memory_order_relaxed )] = uint( e );
+        }
+    } );
+    // make the table independent of the thread scheduling
+    parallelFor( 0, nVertices, [&]( size_t v ) {
+        std::sort( m_vertexEdges.begin() + m_vertexEdgeOffsets[v],
+                   m_vertexEdges.begin() + m_vertexEdgeOffsets[v + 1] );
+    } );
+}
+
+template <typename Container>
+void TriangleMeshSubdivider::refineAttribute( const Container& attribute, Container& out ) const {
+    using T         = typename Container::value_type;
+    const size_t nv = attribute.size();
+    const size_t ne = m_edges.size();
+    out.resize( nv + ne );
+
+    // vertex points
+    parallelFor( 0, nv, [&]( size_t v ) {
+        const T& p = attribute[v];
+        uint n = 0, nBoundary = 0;
+        bool nonManifold = false;
+        T neighbourSum   = zero( p );
+        T boundarySum    = zero( p );
+        for ( uint j = m_vertexEdgeOffsets[v]; j < m_vertexEdgeOffsets[v + 1]; ++j )
+        {
+            const Edge& edge = m_edges[m_vertexEdges[j]];
+            const T& other   = attribute[edge.v0 == v ? edge.v1 : edge.v0];
+            ++n;
+            neighbourSum += other;
+            if ( edge.nFaces == 1 )
+            {
+                ++nBoundary;
+                boundarySum += other;
+            }
+            nonManifold = nonManifold || edge.nFaces > 2;
+        }
+        // fixed vertices: isolated, non-manifold or corner
+        if ( n == 0 || nonManifold || ( nBoundary != 0 && nBoundary != 2 ) ) { out[v] = p; }
+        else if ( nBoundary == 2 )
+        { out[v] = Scalar( 0.75 ) * p + Scalar( 0.125 ) * boundarySum; }
+        else
+        {
+            const Scalar beta = loopBeta( n );
+            out[v]            = ( 1 - n * beta ) * p + beta * neighbourSum;
+        }
+    } );
+
+    // edge points
+    parallelFor( 0, ne, [&]( size_t e ) {
+        const Edge& edge  = m_edges[e];
+        const T& p0      = attribute[edge.v0];
+        const T& p1      = attribute[edge.v1];
+        if ( edge.nFaces != 2 ) { out[nv + e] = Scalar( 0.5 ) * ( p0 + p1 ); }
+        else
+        {
+            out[nv + e] = Scalar( 3. / 8. ) * ( p0 + p1 ) +
+                          Scalar( 1. / 8. ) * ( attribute[edge.opposite0] + attribute[edge.opposite1] );
+        }
+    } );
+}
+
+void TriangleMeshSubdivider::refineTriangles( const Triangles& triangles, Triangles& out ) const {
+    const uint nv = uint( m_vertexEdgeOffsets.size() - 1 );
+    out.resize( 4 * triangles.size() );
+    parallelFor( 0, triangles.size(), [&]( size_t t ) {
+        const Vector3ui& tri = triangles[t];
+        const uint eab       = nv + m_cornerEdges[3 * t];
+        const uint ebd       = nv + m_cornerEdges[3 * t + 1];
+        const uint eda       = nv + m_cornerEdges[3 * t + 2];
+        out[4 * t]           = Vector3ui( tri( 0 ), eab, eda );
+        out[4 * t + 1]       = Vector3ui( eab, tri( 1 ), ebd );
+        out[4 * t + 2]       = Vector3ui( eda, ebd, tri( 2 ) );
+        out[4 * t + 3]       = Vector3ui( eab, ebd, eda );
+    } );
+}
+
+} // namespace Subdivision
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Arena.hpp"
+
+#include <Core/Geometry/TriangleMesh.hpp>
+#include <Core/Types.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Subdivision {
+
+/// Loop subdivision working directly on the vertex, normal and index arrays of a
+/// Ra::Core::Geometry::TriangleMesh, without half-edge structure nor FlatMesh conversion.
+///
+/// Edges are found by sorting, in parallel, a 64 bits key ( min vertex, max vertex ) per
+/// triangle corner. The refined positions and normals (normals are subdivided with the position
+/// stencils, then normalized) are written straight into the output arrays, which are moved into
+/// the mesh at the end. Same rules and vertex ordering as the Loop FlatSubdivider.
+/// The other vertex attributes (Scalar, Vector2, Vector3 or Vector4) are refined with the same
+/// stencils; attributes of other types are dropped with a warning.
+/// The edge tables are served by \p arena when one is given.
+class TriangleMeshSubdivider
+{
+  public:
+    explicit TriangleMeshSubdivider( Arena* arena = nullptr ) :
+        m_keys( arena ),
+        m_edges( arena ),
+        m_cornerEdges( arena ),
+        m_vertexEdgeOffsets( arena ),
+        m_vertexEdges( arena ) {}
+
+    /// Refine \p mesh \p iterations times.
+    void operator()( Ra::Core::Geometry::TriangleMesh& mesh, int iterations );
+
+  private:
+    using Triangles = Ra::Core::Geometry::TriangleMesh::IndexContainerType;
+
+    struct Edge {
+        uint v0;
+        uint v1;
+        /// vertices opposite to the edge in its first two triangles
+        uint opposite0;
+        uint opposite1;
+        uint nFaces;
+    };
+
+    /// Build m_edges, m_cornerEdges and the vertex to edge table of \p triangles.
+    void buildEdges( const Triangles& triangles, size_t nVertices );
+
+    /// Vertex attributes other than the positions and normals, by type.
+    struct Channels;
+
+    /// One refinement step of the vertex attribute \p attribute into \p out.
+    template <typename Container>
+    void refineAttribute( const Container& attribute, Container& out ) const;
+
+    /// One refinement step of the triangles.
+    void refineTriangles( const Triangles& triangles, Triangles& out ) const;
+
+    struct CornerKey {
+        uint64_t key;
+        uint corner;
+    };
+    ArenaVector<CornerKey> m_keys;
+    ArenaVector<Edge> m_edges;
+    /// edge from each corner to the next one, indexed by 3 * triangle + corner
+    ArenaVector<uint> m_cornerEdges;
+    /// edges of each vertex, CSR
+    ArenaVector<uint> m_vertexEdgeOffsets;
+    ArenaVector<uint> m_vertexEdges;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,157 @@
+#include "VertexWelder.hpp"
+#include "Parallel.hpp"
+
+#include <Core/Utils/Attribs.hpp>
+#include <Core/Utils/Log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+using namespace Ra::Core::Utils; // log
+
+namespace {
+
+using Cell = std::array<int64_t, 3>;
+
+/// Spatial hash of a grid cell (Teschner et al., "Optimized spatial hashing for collision
+/// detection of deformable objects", 2003). Colliding cells only cost distance tests.
+inline uint64_t cellKey( const Cell& c ) {
+    return ( uint64_t( c[0] ) * 73856093u ) ^ ( uint64_t( c[1] ) * 19349663u ) ^
+           ( uint64_t( c[2] ) * 83492791u );
+}
+
+template <typename T>
+void gather( AttribBase* attrib, const std::vector<uint>& kept ) {
+    auto& typed = attrib->cast<Attrib<T>>();
+    auto& data  = typed.getDataWithLock();
+    typename Attrib<T>::Container gathered( kept.size() );
+    for ( size_t v = 0; v < kept.size(); ++v )
+    {
+        gathered[v] = data[kept[v]];
+    }
+    data = std::move( gathered );
+    typed.unlock();
+}
+
+} // namespace
+
+bool VertexWelder::operator()( Geometry::TriangleMesh& mesh ) {
+    m_merged        = 0;
+    const size_t nv = mesh.vertices().size();
+    bool gatherable = true;
+    mesh.vertexAttribs().for_each_attrib( [&gatherable, nv]( AttribBase* attrib ) {
+        gatherable = gatherable && ( attrib->getSize() != nv || attrib->isFloat() ||
+                                     attrib->isVector2() || attrib->isVector3() ||
+                                     attrib->isVector4() );
+    } );
+    if ( !gatherable )
+    {
+        LOG( logWARNING ) << "An attribute has an unsupported type, vertices are not welded.";
+        return false;
+    }
+
+    // welded vertices are in the same cell, or in adjacent ones
+    const auto& vertices  = mesh.vertices();
+    const Scalar cellSize = m_epsilon > 0 ? m_epsilon : 1;
+    auto cellOf           = [cellSize]( const Vector3& p ) {
+        return Cell{int64_t( std::floor( p.x() / cellSize ) ),
+                    int64_t( std::floor( p.y() / cellSize ) ),
+                    int64_t( std::floor( p.z() / cellSize ) )};
+    };
+    std::vector<std::pair<uint64_t, uint>> cells( nv );
+    parallelFor( 0, nv, [&]( size_t v ) {
+        cells[v] = {cellKey( cellOf( vertices[v] ) ), uint( v )};
+    } );
+    parallelSort( cells, std::less<std::pair<uint64_t, uint>>() );
+
+    // smallest vertex within epsilon, the vertices of a cell being sorted
+    std::vector<uint> representative( nv );
+    const Scalar epsilon2 = m_epsilon * m_epsilon;
+    const int64_t reach   = m_epsilon > 0 ? 1 : 0;
+    parallelFor( 0, nv, [&]( size_t v ) {
+        const Vector3& p = vertices[v];
+        const Cell c     = cellOf( p );
+        uint closest     = uint( v );
+        for ( int64_t dx = -reach; dx <= reach; ++dx )
+        {
+            for ( int64_t dy = -reach; dy <= reach; ++dy )
+            {
+                for ( int64_t dz = -reach; dz <= reach; ++dz )
+                {
+                    const uint64_t key = cellKey( {c[0] + dx, c[1] + dy, c[2] + dz} );
+                    for ( auto it = std::lower_bound(
+                              cells.begin(), cells.end(), std::make_pair( key, uint( 0 ) ) );
+                          it != cells.end() && it->first == key && it->second < closest;
+                          ++it )
+                    {
+                        if ( ( vertices[it->second] - p ).squaredNorm() <= epsilon2 )
+                        {
+                            closest = it->second;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        representative[v] = closest;
+    } );
+    // representatives precede their vertices: a single pass resolves the chains
+    std::vector<uint> kept;
+    for ( size_t v = 0; v < nv; ++v )
+    {
+        representative[v] = representative[representative[v]];
+        if ( representative[v] == v ) { kept.push_back( uint( v ) ); }
+    }
+    m_merged = nv - kept.size();
+    if ( m_merged == 0 ) { return true; }
+
+    std::vector<uint> index( nv );
+    for ( size_t i = 0; i < kept.size(); ++i )
+    {
+        index[kept[i]] = uint( i );
+    }
+    for ( size_t v = 0; v < nv; ++v )
+    {
+        index[v] = index[representative[v]];
+    }
+    Vector3Array normals;
+    if ( mesh.normals().size() == nv )
+    {
+        normals.assign( kept.size(), Vector3::Zero() );
+        for ( size_t v = 0; v < nv; ++v )
+        {
+            normals[index[v]] += mesh.normals()[v];
+        }
+        parallelFor( 0, normals.size(), [&normals]( size_t v ) { normals[v].normalize(); } );
+    }
+    mesh.vertexAttribs().for_each_attrib( [&kept, nv]( AttribBase* attrib ) {
+        if ( attrib->getSize() != nv ) { return; }
+        if ( attrib->isFloat() ) { gather<Scalar>( attrib, kept ); }
+        else if ( attrib->isVector2() )
+        { gather<Vector2>( attrib, kept ); }
+        else if ( attrib->isVector3() )
+        { gather<Vector3>( attrib, kept ); }
+        else
+        { gather<Vector4>( attrib, kept ); }
+    } );
+    if ( !normals.empty() ) { mesh.setNormals( std::move( normals ) ); }
+
+    auto& triangles = mesh.getIndicesWithLock();
+    parallelFor( 0, triangles.size(), [&]( size_t t ) {
+        for ( uint i = 0; i < 3; ++i )
+        {
+            // out of range indices are left to the manifold check
+            uint& v = triangles[t]( i );
+            if ( v < nv ) { v = index[v]; }
+        }
+    } );
+    mesh.indicesUnlock();
+    return true;
+}
+
+} // namespace Subdivision
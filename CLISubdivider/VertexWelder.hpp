@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Core/Geometry/TriangleMesh.hpp>
+
+namespace Subdivision {
+
+/// Merge the vertices of a TriangleMesh closer than an epsilon, so that meshes whose faces have
+/// their own copies of the shared vertices (common in OBJ exports) get connected, and are not
+/// torn apart by the subdivision.
+///
+/// Parallel spatial hash: the vertices are sorted by the hash of their grid cell (cells of size
+/// epsilon) with parallelSort, then each vertex looks, in parallel, for the smallest vertex
+/// within epsilon in its cell and the 26 adjacent ones. Each vertex is merged into the
+/// representative of that vertex, the smallest of its cluster.
+///
+/// The representatives are kept in their order, with their attributes, except the normals which
+/// are averaged over the merged vertices. Triangle indices are remapped in place.
+class VertexWelder
+{
+  public:
+    /// Merge the vertices closer than \p epsilon, 0 for identical positions only.
+    explicit VertexWelder( Scalar epsilon = 0 ) : m_epsilon( epsilon ) {}
+
+    /// Weld the vertices of \p mesh. Returns false, and leaves \p mesh unchanged, if an attribute
+    /// has a type other than Scalar and Vector2/3/4.
+    bool operator()( Ra::Core::Geometry::TriangleMesh& mesh );
+
+    /// Number of vertices merged into another one by the last run.
+    inline size_t merged() const { return m_merged; }
+
+  private:
+    Scalar m_epsilon;
+    size_t m_merged{0};
+};
+
+} // namespace Subdivision
@@ -0,0 +1,208 @@
+#include "VertexCacheOptimizer.hpp"
+
+#include <Core/Utils/Attribs.hpp>
+#include <Core/Utils/Log.hpp>
+
+#include <limits>
+
+namespace Subdivision {
+
+using namespace Ra::Core;
+using namespace Ra::Core::Utils; // log
+
+namespace {
+
+constexpr uint Unassigned = std::numeric_limits<uint>::max();
+
+template <typename T>
+void permute( AttribBase* attrib, const std::vector<uint>& order ) {
+    auto& typed = attrib->cast<Attrib<T>>();
+    auto& data  = typed.getDataWithLock();
+    typename Attrib<T>::Container permuted( data.size() );
+    for ( size_t v = 0; v < order.size(); ++v )
+    {
+        permuted[v] = data[order[v]];
+    }
+    data = std::move( permuted );
+    typed.unlock();
+}
+
+} // namespace
+
+std::vector<uint> VertexCacheOptimizer::triangleOrder(
+    const Geometry::TriangleMesh::IndexContainerType& triangles,
+    size_t nVertices ) const {
+    const size_t nt = triangles.size();
+    // vertex to triangle adjacency
+    std::vector<uint> offsets( nVertices + 1, 0 );
+    for ( const auto& t : triangles )
+    {
+        for ( uint i = 0; i < 3; ++i )
+        {
+            ++offsets[t( i ) + 1];
+        }
+    }
+    // number of triangles of each vertex not emitted yet
+    std::vector<uint> live( nVertices );
+    for ( size_t v = 0; v < nVertices; ++v )
+    {
+        live[v] = offsets[v + 1];
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<uint> adjacency( offsets[nVertices] );
+    {
+        std::vector<uint> fill( offsets.begin(), offsets.end() - 1 );
+        for ( size_t t = 0; t < nt; ++t )
+        {
+            for ( uint i = 0; i < 3; ++i )
+            {
+                adjacency[fill[triangles[t]( i )]++] = uint( t );
+            }
+        }
+    }
+
+    // cache time stamps: a vertex is in the cache if less than m_cacheSize vertices entered it
+    // since its own entry
+    const size_t k = m_cacheSize;
+    std::vector<size_t> stamps( nVertices, 0 );
+    size_t time = k + 1;
+    std::vector<char> emitted( nt, 0 );
+    std::vector<uint> deadEnds, candidates, order;
+    deadEnds.reserve( 3 * nt );
+    order.reserve( nt );
+    size_t cursor = 0; // dead ends without recent vertex resume in index order
+    uint fanning  = nVertices > 0 ? 0 : Unassigned;
+    while ( fanning != Unassigned )
+    {
+        candidates.clear();
+        for ( uint j = offsets[fanning]; j < offsets[fanning + 1]; ++j )
+        {
+            const uint t = adjacency[j];
+            if ( emitted[t] ) { continue; }
+            emitted[t] = 1;
+            order.push_back( t );
+            for ( uint i = 0; i < 3; ++i )
+            {
+                const uint v = triangles[t]( i );
+                deadEnds.push_back( v );
+                candidates.push_back( v );
+                --live[v];
+                if ( time - stamps[v] > k ) { stamps[v] = time++; }
+            }
+        }
+
+        // next fanning vertex: the oldest candidate that stays in the cache while its remaining
+        // triangles are emitted, or any candidate with triangles left
+        fanning           = Unassigned;
+        long bestPriority = -1;
+        for ( uint v : candidates )
+        {
+            if ( live[v] == 0 ) { continue; }
+            long priority = 0;
+            if ( time - stamps[v] + 2 * live[v] <= k ) { priority = long( time - stamps[v] ); }
+            if ( priority > bestPriority )
+            {
+                bestPriority = priority;
+                fanning      = v;
+            }
+        }
+        while ( fanning == Unassigned && !deadEnds.empty() )
+        {
+            const uint v = deadEnds.back();
+            deadEnds.pop_back();
+            if ( live[v] > 0 ) { fanning = v; }
+        }
+        for ( ; fanning == Unassigned && cursor < nVertices; ++cursor )
+        {
+            if ( live[cursor] > 0 ) { fanning = uint( cursor ); }
+        }
+    }
+    return order;
+}
+
+VertexCacheStats VertexCacheOptimizer::measure( const Geometry::TriangleMesh& mesh ) const {
+    VertexCacheStats stats;
+    const auto& triangles = mesh.getIndices();
+    const size_t k        = m_cacheSize;
+    std::vector<size_t> stamps( mesh.vertices().size(), 0 );
+    size_t time = k + 1, misses = 0, referenced = 0;
+    for ( const auto& t : triangles )
+    {
+        for ( uint i = 0; i < 3; ++i )
+        {
+            size_t& stamp = stamps[t( i )];
+            referenced += stamp == 0 ? 1 : 0;
+            if ( time - stamp > k )
+            {
+                stamp = time++;
+                ++misses;
+            }
+        }
+    }
+    if ( !triangles.empty() )
+    {
+        stats.acmr = double( misses ) / triangles.size();
+        stats.atvr = double( misses ) / referenced;
+    }
+    return stats;
+}
+
+void VertexCacheOptimizer::operator()( Geometry::TriangleMesh& mesh ) {
+    m_before           = measure( mesh );
+    const size_t nv    = mesh.vertices().size();
+    const auto& input  = mesh.getIndices();
+    const auto order   = triangleOrder( input, nv );
+    Geometry::TriangleMesh::IndexContainerType triangles( order.size() );
+    for ( size_t t = 0; t < order.size(); ++t )
+    {
+        triangles[t] = input[order[t]];
+    }
+
+    // vertices in the order of their first use, the unreferenced ones last
+    bool permutable = true;
+    mesh.vertexAttribs().for_each_attrib( [&permutable, nv]( AttribBase* attrib ) {
+        permutable = permutable && ( attrib->getSize() != nv || attrib->isFloat() ||
+                                     attrib->isVector2() || attrib->isVector3() ||
+                                     attrib->isVector4() );
+    } );
+    if ( !permutable )
+    {
+        LOG( logWARNING ) << "An attribute has an unsupported type, vertices are not reordered.";
+        mesh.setIndices( std::move( triangles ) );
+        m_after = measure( mesh );
+        return;
+    }
+    std::vector<uint> remap( nv, Unassigned ), vertexOrder;
+    vertexOrder.reserve( nv );
+    for ( auto& t : triangles )
+    {
+        for ( uint i = 0; i < 3; ++i )
+        {
+            uint& v = remap[t( i )];
+            if ( v == Unassigned )
+            {
+                v = uint( vertexOrder.size() );
+                vertexOrder.push_back( t( i ) );
+            }
+            t( i ) = v;
+        }
+    }
+    for ( uint v = 0; v < nv; ++v )
+    {
+        if ( remap[v] == Unassigned ) { vertexOrder.push_back( v ); }
+    }
+    mesh.vertexAttribs().for_each_attrib( [&vertexOrder, nv]( AttribBase* attrib ) {
+        if ( attrib->getSize() != nv ) { return; }
+        if ( attrib->isFloat() ) { permute<Scalar>( attrib, vertexOrder ); }
+        else if ( attrib->isVector2() )
+        { permute<Vector2>( attrib, vertexOrder ); }
+        else if ( attrib->isVector3() )
+        { permute<Vector3>( attrib, vertexOrder ); }
+        else
+        { permute<Vector4>( attrib, vertexOrder ); }
+    } );
+    mesh.setIndices( std::move( triangles ) );
+    m_after = measure( mesh );
+}
+
+} // namespace Subdivision
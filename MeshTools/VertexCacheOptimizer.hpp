@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Core/Geometry/TriangleMesh.hpp>
+
+#include <vector>
+
+namespace Subdivision {
+
+/// Efficiency of a FIFO post-transform vertex cache on the triangles of a mesh.
+struct VertexCacheStats {
+    /// Average cache miss ratio: transformed vertices per triangle, from 3 down to about 0.5 on
+    /// large regular meshes
+    double acmr{0};
+    /// Average transform to vertex ratio: transformed vertices per referenced vertex, 1 at best
+    double atvr{0};
+};
+
+/// Linear time reordering of a TriangleMesh for the GPU vertex caches, run before saving.
+///
+/// Triangles are reordered for the post-transform cache with Tipsify (Sander, Nehab and Barczak,
+/// "Fast triangle reordering for vertex locality and reduced overdraw", 2007): the triangles
+/// around a fanning vertex are emitted together, and the next fanning vertex is taken among the
+/// vertices of the fan that will still be in the cache once their remaining triangles are
+/// emitted. Dead ends resume from the most recently used vertices, then in index order.
+/// Vertices are then renumbered in the order of their first use, so that vertex fetches are
+/// sequential; every vertex attribute is permuted accordingly.
+class VertexCacheOptimizer
+{
+  public:
+    /// Optimize for a FIFO cache of \p cacheSize vertices.
+    explicit VertexCacheOptimizer( uint cacheSize = 16 ) : m_cacheSize( cacheSize ) {}
+
+    /// Reorder the triangles and the vertices of \p mesh. Vertices are kept in place if an
+    /// attribute has a type other than Scalar and Vector2/3/4.
+    void operator()( Ra::Core::Geometry::TriangleMesh& mesh );
+
+    /// Cache statistics of \p mesh.
+    VertexCacheStats measure( const Ra::Core::Geometry::TriangleMesh& mesh ) const;
+
+    /// Statistics of the mesh before and after the last run.
+    inline const VertexCacheStats& before() const { return m_before; }
+    inline const VertexCacheStats& after() const { return m_after; }
+
+  private:
+    /// Triangle order of Tipsify.
+    std::vector<uint>
+    triangleOrder( const Ra::Core::Geometry::TriangleMesh::IndexContainerType& triangles,
+                   size_t nVertices ) const;
+
+    uint m_cacheSize;
+    VertexCacheStats m_before;
+    VertexCacheStats m_after;
+};
+
+} // namespace Subdivision
@@ -0,0 +1,190 @@
+#include <Benchmark.hpp>
+#include <Gui/MainWindow.hpp>
+#include <MainApplication.hpp>
+
+#include <Core/Math/Math.hpp>
+#include <Core/Utils/Log.hpp>
+#include <Engine/RadiumEngine.hpp>
+#include <Engine/Scene/Camera.hpp>
+#include <Gui/Viewer/CameraManipulator.hpp>
+#include <Gui/Viewer/Viewer.hpp>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace Ra {
+
+using namespace Core::Utils; // log
+
+namespace {
+const char* motionName( Benchmark::Motion motion ) {
+    switch ( motion )
+    {
+    case Benchmark::Motion::Orbit:
+        return "orbit";
+    case Benchmark::Motion::Animation:
+        return "animation";
+    default:
+        return "none";
+    }
+}
+
+/// Timings of a frame, in microseconds. The inter-frame time of the first frame is 0.
+struct FrameTimes {
+    long render;
+    long tasks;
+    long frame;
+    long interFrame;
+};
+
+FrameTimes frameTimes( const std::vector<Gui::FrameTimerData>& stats, size_t i ) {
+    return {getIntervalMicro( stats[i].renderData.renderStart, stats[i].renderData.renderEnd ),
+            getIntervalMicro( stats[i].tasksStart, stats[i].tasksEnd ),
+            getIntervalMicro( stats[i].frameStart, stats[i].frameEnd ),
+            i > 0 ? getIntervalMicro( stats[i - 1].frameEnd, stats[i].frameEnd ) : 0};
+}
+} // namespace
+
+bool Benchmark::extractOptions( int& argc, char** argv, Options& options ) {
+    int kept = 1;
+    for ( int i = 1; i < argc; ++i )
+    {
+        const bool hasValue = i + 1 < argc;
+        if ( std::strcmp( argv[i], "--benchmark" ) == 0 && hasValue )
+        { options.output = QString::fromLocal8Bit( argv[++i] ); }
+        else if ( std::strcmp( argv[i], "--benchmark-frames" ) == 0 && hasValue )
+        { options.frames = uint( std::max( 1, std::atoi( argv[++i] ) ) ); }
+        else if ( std::strcmp( argv[i], "--benchmark-warmup" ) == 0 && hasValue )
+        { options.warmup = uint( std::max( 0, std::atoi( argv[++i] ) ) ); }
+        else if ( std::strcmp( argv[i], "--benchmark-motion" ) == 0 && hasValue )
+        {
+            const std::string name = argv[++i];
+            if ( name == "orbit" ) { options.motion = Motion::Orbit; }
+            else if ( name == "animation" )
+            { options.motion = Motion::Animation; }
+            else if ( name == "none" )
+            { options.motion = Motion::None; }
+            else
+            {
+                std::cerr << "Unknown benchmark motion " << name
+                          << ", expected orbit, animation or none." << std::endl;
+                return false;
+            }
+        }
+        else if ( std::strncmp( argv[i], "--benchmark", 11 ) == 0 )
+        {
+            std::cerr << "Invalid benchmark option " << argv[i] << "." << std::endl;
+            return false;
+        }
+        else
+        { argv[kept++] = argv[i]; }
+    }
+    argc       = kept;
+    argv[argc] = nullptr;
+    return true;
+}
+
+Benchmark::Benchmark( const Options& options, Gui::MainWindow* window ) :
+    m_options( options ),
+    m_window( window ) {}
+
+void Benchmark::start() {
+    auto engine = Engine::RadiumEngine::getInstance();
+    LOG( logINFO ) << "Benchmark: " << m_options.warmup << " + " << m_options.frames
+                   << " frames, " << motionName( m_options.motion ) << ".";
+
+    if ( m_options.motion == Motion::Orbit )
+    {
+        // a full turn around the vertical axis of the scene over the recorded frames
+        m_window->fitCamera();
+        const auto aabb = engine->computeSceneAabb();
+        const Core::Vector3 center =
+            aabb.isEmpty() ? Core::Vector3::Zero() : Core::Vector3( aabb.center() );
+        m_step.translate( center );
+        m_step.rotate( Core::AngleAxis( Scalar( 2 * Core::Math::Pi / m_options.frames ),
+                                        Core::Vector3::UnitY() ) );
+        m_step.translate( -center );
+        connect( m_window, &Gui::MainWindow::frameCompleted, this, &Benchmark::onFrameComplete );
+    }
+    else if ( m_options.motion == Motion::Animation )
+    { engine->play( true ); }
+
+    connect( mainApp, &Gui::BaseApplication::updateFrameStats, this, &Benchmark::onFrameStats );
+    mainApp->framesCountForStatsChanged( m_options.warmup + m_options.frames );
+    mainApp->setRealFrameRate( false );
+    mainApp->setContinuousUpdate( true );
+}
+
+void Benchmark::onFrameComplete() {
+    m_window->getViewer()->getCameraManipulator()->getCamera()->applyTransform( m_step );
+}
+
+void Benchmark::onFrameStats( const std::vector<Gui::FrameTimerData>& stats ) {
+    // a single batch, of the warm-up and recorded frames
+    disconnect( mainApp, &Gui::BaseApplication::updateFrameStats, this, &Benchmark::onFrameStats );
+    const std::vector<Gui::FrameTimerData> recorded(
+        stats.begin() + std::min<size_t>( m_options.warmup, stats.size() ), stats.end() );
+    m_succeeded = !recorded.empty() && write( recorded );
+    mainApp->appNeedsToQuit();
+}
+
+bool Benchmark::write( const std::vector<Gui::FrameTimerData>& stats ) const {
+    QFile file( m_options.output );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        LOG( logERROR ) << "Cannot write " << m_options.output.toStdString();
+        return false;
+    }
+
+    FrameTimes sum{0, 0, 0, 0};
+    const bool csv = m_options.output.endsWith( ".csv", Qt::CaseInsensitive );
+    QTextStream csvOut( &file );
+    QJsonArray frames;
+    if ( csv ) { csvOut << "frame,render_us,tasks_us,frame_us,interframe_us\n"; }
+    for ( size_t i = 0; i < stats.size(); ++i )
+    {
+        const auto t = frameTimes( stats, i );
+        sum.render += t.render;
+        sum.tasks += t.tasks;
+        sum.frame += t.frame;
+        sum.interFrame += t.interFrame;
+        if ( csv )
+        {
+            csvOut << stats[i].numFrame << "," << qint64( t.render ) << "," << qint64( t.tasks )
+                   << "," << qint64( t.frame ) << "," << qint64( t.interFrame ) << "\n";
+        }
+        else
+        {
+            frames.append( QJsonObject{{"frame", qint64( stats[i].numFrame )},
+                                       {"render_us", qint64( t.render )},
+                                       {"tasks_us", qint64( t.tasks )},
+                                       {"frame_us", qint64( t.frame )},
+                                       {"interframe_us", qint64( t.interFrame )}} );
+        }
+    }
+    if ( !csv )
+    {
+        const QJsonObject root{{"motion", motionName( m_options.motion )},
+                               {"warmup", int( m_options.warmup )},
+                               {"frames", frames}};
+        file.write( QJsonDocument( root ).toJson() );
+    }
+    csvOut.flush();
+
+    const auto n = long( stats.size() );
+    LOG( logINFO ) << "Benchmark: " << n << " frames, mean render " << sum.render / n
+                   << " us, tasks " << sum.tasks / n << " us, frame " << sum.frame / n
+                   << " us, inter-frame " << ( n > 1 ? sum.interFrame / ( n - 1 ) : 0 )
+                   << " us. Timings written to " << m_options.output.toStdString() << ".";
+    return file.error() == QFileDevice::NoError;
+}
+
+} // namespace Ra
@@ -0,0 +1,71 @@
+#ifndef RADIUMENGINE_BENCHMARK_HPP
+#define RADIUMENGINE_BENCHMARK_HPP
+
+#include <Core/Types.hpp>
+#include <Gui/TimerData/FrameTimerData.hpp>
+
+#include <QObject>
+#include <QString>
+
+#include <vector>
+
+namespace Ra {
+namespace Gui {
+class MainWindow;
+}
+
+/// Headless benchmark mode: renders the scene opened with -f for a fixed number of frames, while
+/// the camera orbits around it or its animation plays, writes the timings of each frame to a
+/// JSON or CSV file, and quits.
+///
+/// The frames are timed by the BaseApplication (FrameTimerData), and collected in a single
+/// updateFrameStats batch at the end so that the labels of the stats tab are not updated during
+/// the run. The time step is fixed, so that the animated frames are the same from run to run.
+class Benchmark : public QObject
+{
+    Q_OBJECT
+
+  public:
+    enum class Motion { None, Orbit, Animation };
+
+    struct Options {
+        /// JSON, or CSV if its extension is .csv. Empty when not benchmarking
+        QString output;
+        /// Frames recorded, after the warm-up ones (shader compilation, first uploads)
+        uint frames{300};
+        uint warmup{10};
+        Motion motion{Motion::Orbit};
+    };
+
+    /// Remove the benchmark options from \p argv, before the application parses it. Returns
+    /// false, with a message on stderr, if an option is invalid.
+    static bool extractOptions( int& argc, char** argv, Options& options );
+
+    Benchmark( const Options& options, Gui::MainWindow* window );
+
+    /// Start rendering continuously, once the scene is loaded.
+    void start();
+
+    /// True if the timings have been written.
+    inline bool succeeded() const { return m_succeeded; }
+
+  private slots:
+    /// Move the camera for the next frame.
+    void onFrameComplete();
+
+    /// Write the timings and quit.
+    void onFrameStats( const std::vector<Gui::FrameTimerData>& stats );
+
+  private:
+    bool write( const std::vector<Gui::FrameTimerData>& stats ) const;
+
+    Options m_options;
+    Gui::MainWindow* m_window;
+    /// Rotation of the camera about the scene center between two frames
+    Core::Transform m_step{Core::Transform::Identity()};
+    bool m_succeeded{false};
+};
+
+} // namespace Ra
+
+#endif // RADIUMENGINE_BENCHMARK_HPP
@@ -0,0 +1,65 @@
+#ifndef RADIUMENGINE_FRAMESTATS_HPP
+#define RADIUMENGINE_FRAMESTATS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Ra {
+namespace Gui {
+
+/// Timings of a frame, in microseconds, from its FrameTimerData.
+struct FrameSample {
+    uint numFrame;
+    long render;
+    long tasks;
+    long frame;
+    /// From the end of the previous frame, 0 for the first one
+    long interFrame;
+};
+
+/// Ring buffer of the last Capacity samples. Not thread safe: the samples are pushed and read
+/// by the GUI thread, from the frame stats signal.
+template <typename T, size_t Capacity>
+class SampleRing
+{
+    static_assert( ( Capacity & ( Capacity - 1 ) ) == 0, "Capacity must be a power of two" );
+
+  public:
+    SampleRing() : m_samples( new T[Capacity] ) {}
+
+    void push( const T& sample ) { m_samples[m_written++ & ( Capacity - 1 )] = sample; }
+
+    /// The last \p n samples at most, oldest first.
+    std::vector<T> snapshot( size_t n = Capacity ) const {
+        const uint64_t begin = m_written - std::min<uint64_t>( {n, m_written, Capacity} );
+        std::vector<T> samples;
+        samples.reserve( size_t( m_written - begin ) );
+        for ( uint64_t i = begin; i < m_written; ++i )
+        {
+            samples.push_back( m_samples[i & ( Capacity - 1 )] );
+        }
+        return samples;
+    }
+
+    /// Samples pushed since the creation.
+    inline uint64_t written() const { return m_written; }
+
+  private:
+    std::unique_ptr<T[]> m_samples;
+    uint64_t m_written{0};
+};
+
+/// Nearest-rank percentile \p p (in [0, 1]) of \p sorted, 0 if empty.
+inline long percentile( const std::vector<long>& sorted, double p ) {
+    if ( sorted.empty() ) { return 0; }
+    const auto rank = size_t( std::ceil( p * double( sorted.size() ) ) );
+    return sorted[std::min( sorted.size(), std::max<size_t>( rank, 1 ) ) - 1];
+}
+
+} // namespace Gui
+} // namespace Ra
+
+#endif // RADIUMENGINE_FRAMESTATS_HPP
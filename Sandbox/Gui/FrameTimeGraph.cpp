@@ -0,0 +1,51 @@
+#include <Gui/FrameTimeGraph.hpp>
+
+#include <QPainter>
+
+namespace Ra {
+namespace Gui {
+
+FrameTimeGraph::FrameTimeGraph( QWidget* parent ) : QWidget( parent ) {
+    setMinimumHeight( 80 );
+    setSizePolicy( QSizePolicy::Expanding, QSizePolicy::Fixed );
+}
+
+void FrameTimeGraph::setSamples( std::vector<FrameSample> samples ) {
+    m_samples = std::move( samples );
+    update();
+}
+
+void FrameTimeGraph::setBudget( long budget ) {
+    m_budget = std::max( budget, 1L );
+    update();
+}
+
+void FrameTimeGraph::paintEvent( QPaintEvent* /*event*/ ) {
+    QPainter painter( this );
+    painter.fillRect( rect(), palette().base() );
+
+    const size_t n     = std::min( m_samples.size(), size_t( frameCount() ) );
+    const size_t first = m_samples.size() - n;
+    long scale         = 2 * m_budget;
+    for ( size_t i = first; i < m_samples.size(); ++i )
+    {
+        scale = std::max( scale, m_samples[i].frame );
+    }
+    const int h = height();
+    auto y      = [h, scale]( long time ) { return h - int( double( time ) * h / scale ); };
+
+    // most recent frame on the right
+    const int x0 = width() - int( n );
+    for ( size_t i = first; i < m_samples.size(); ++i )
+    {
+        const auto time = m_samples[i].frame;
+        painter.setPen( time > m_budget ? Qt::red : palette().color( QPalette::Highlight ) );
+        const int x = x0 + int( i - first );
+        painter.drawLine( x, h, x, y( time ) );
+    }
+    painter.setPen( QPen( palette().color( QPalette::Text ), 1, Qt::DashLine ) );
+    painter.drawLine( 0, y( m_budget ), width(), y( m_budget ) );
+}
+
+} // namespace Gui
+} // namespace Ra
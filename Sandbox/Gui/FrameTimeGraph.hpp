@@ -0,0 +1,42 @@
+#ifndef RADIUMENGINE_FRAMETIMEGRAPH_HPP
+#define RADIUMENGINE_FRAMETIMEGRAPH_HPP
+
+#include <Gui/FrameStats.hpp>
+
+#include <QWidget>
+
+#include <vector>
+
+namespace Ra {
+namespace Gui {
+
+/// Rolling graph of the last frame times: one bar per frame, the frames over the budget in red,
+/// and the budget as a horizontal line. The scale fits twice the budget, or the slowest frame.
+class FrameTimeGraph : public QWidget
+{
+    Q_OBJECT
+
+  public:
+    explicit FrameTimeGraph( QWidget* parent = nullptr );
+
+    /// Frames shown, one pixel wide each.
+    inline int frameCount() const { return std::max( width(), 1 ); }
+
+  public slots:
+    /// Show \p samples, the last ones if there are more than frameCount().
+    void setSamples( std::vector<FrameSample> samples );
+
+    /// Frame budget, in microseconds.
+    void setBudget( long budget );
+
+  private:
+    void paintEvent( QPaintEvent* event ) override;
+
+    std::vector<FrameSample> m_samples;
+    long m_budget{16667};
+};
+
+} // namespace Gui
+} // namespace Ra
+
+#endif // RADIUMENGINE_FRAMETIMEGRAPH_HPP
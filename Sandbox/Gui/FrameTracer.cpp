@@ -0,0 +1,138 @@
+#include <Gui/FrameTracer.hpp>
+
+#include <Core/Utils/Log.hpp>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+namespace Ra {
+namespace Gui {
+
+using namespace Core::Utils; // log
+
+const char* FrameTracer::categoryName( Category category ) {
+    switch ( category )
+    {
+    case Category::Event:
+        return "qt";
+    case Category::Frame:
+        return "frame";
+    case Category::Phase:
+        return "phase";
+    case Category::Pass:
+        return "render";
+    default:
+        return "task";
+    }
+}
+
+void FrameTracer::setEnabled( bool enabled ) {
+    if ( enabled && !m_enabled )
+    {
+        m_events.clear();
+        m_workers          = 0;
+        m_previousFrameEnd = TimePoint();
+        m_lastFrameEnd     = TimePoint();
+    }
+    m_enabled = enabled;
+}
+
+void FrameTracer::add( Event event ) {
+    m_events.push_back( std::move( event ) );
+    if ( m_events.size() > MaxEvents ) { m_events.pop_front(); }
+}
+
+void FrameTracer::addFrames( const std::vector<FrameTimerData>& stats ) {
+    if ( !m_enabled ) { return; }
+    for ( const auto& s : stats )
+    {
+        const auto& r           = s.renderData;
+        const std::string frame = "frame #" + std::to_string( s.numFrame );
+        add( {frame, Category::Frame, 0, s.frameStart, s.frameEnd} );
+        add( {"tasks", Category::Phase, 0, s.tasksStart, s.tasksEnd} );
+        add( {"render", Category::Phase, 0, r.renderStart, r.renderEnd} );
+        add( {"update", Category::Pass, 0, r.renderStart, r.updateEnd} );
+        add( {"feed render queues", Category::Pass, 0, r.updateEnd, r.feedRenderQueuesEnd} );
+        add( {"main render", Category::Pass, 0, r.feedRenderQueuesEnd, r.mainRenderEnd} );
+        add( {"post process", Category::Pass, 0, r.mainRenderEnd, r.postProcessEnd} );
+        add( {"debug and ui", Category::Pass, 0, r.postProcessEnd, r.renderEnd} );
+        for ( const auto& task : s.taskData )
+        {
+            add( {task.taskName, Category::Task, task.threadId + 1, task.start, task.end} );
+            m_workers = std::max( m_workers, uint( task.threadId + 1 ) );
+        }
+        m_previousFrameEnd = m_lastFrameEnd;
+        m_lastFrameEnd     = s.frameEnd;
+    }
+}
+
+void FrameTracer::addEvent( std::string name, TimePoint start, TimePoint end ) {
+    if ( m_enabled ) { add( {std::move( name ), Category::Event, 0, start, end} ); }
+}
+
+std::vector<FrameTracer::Event> FrameTracer::lastFrame( TimePoint& begin, TimePoint& end ) const {
+    end   = m_lastFrameEnd;
+    begin = m_previousFrameEnd;
+    std::vector<Event> events;
+    if ( end == TimePoint() ) { return events; }
+    if ( begin == TimePoint() )
+    {
+        // first frame: from its start
+        for ( const auto& e : m_events )
+        {
+            if ( e.category == Category::Frame && e.end == end ) { begin = e.start; }
+        }
+    }
+    for ( const auto& e : m_events )
+    {
+        if ( e.end > begin && e.start < end ) { events.push_back( e ); }
+    }
+    return events;
+}
+
+bool FrameTracer::exportChromeTrace( const QString& path ) const {
+    QFile file( path );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        LOG( logERROR ) << "Cannot write " << path.toStdString();
+        return false;
+    }
+
+    // complete events ("X"), in microseconds from the first event
+    QJsonArray events;
+    auto origin = TimePoint::max();
+    for ( const auto& e : m_events )
+    {
+        origin = std::min( origin, e.start );
+    }
+    for ( uint thread = 0; thread <= m_workers; ++thread )
+    {
+        const QString name = thread == 0 ? "GUI thread" : QString( "worker %1" ).arg( thread - 1 );
+        events.append( QJsonObject{{"name", "thread_name"},
+                                   {"ph", "M"},
+                                   {"pid", 1},
+                                   {"tid", int( thread )},
+                                   {"args", QJsonObject{{"name", name}}}} );
+    }
+    for ( const auto& e : m_events )
+    {
+        events.append( QJsonObject{{"name", QString::fromStdString( e.name )},
+                                   {"cat", categoryName( e.category )},
+                                   {"ph", "X"},
+                                   {"ts", double( getIntervalMicro( origin, e.start ) )},
+                                   {"dur", double( getIntervalMicro( e.start, e.end ) )},
+                                   {"pid", 1},
+                                   {"tid", int( e.thread )}} );
+    }
+    const QJsonObject root{{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    file.write( QJsonDocument( root ).toJson( QJsonDocument::Compact ) );
+    LOG( logINFO ) << "Exported " << m_events.size() << " trace events to " << path.toStdString();
+    return file.error() == QFileDevice::NoError;
+}
+
+} // namespace Gui
+} // namespace Ra
@@ -0,0 +1,81 @@
+#ifndef RADIUMENGINE_FRAMETRACER_HPP
+#define RADIUMENGINE_FRAMETRACER_HPP
+
+#include <Core/Utils/Timer.hpp>
+#include <Gui/TimerData/FrameTimerData.hpp>
+
+#include <QString>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace Ra {
+namespace Gui {
+
+/// Timeline of the frames, recorded when enabled: the frame and its tasks and render phases, the
+/// render passes, each task on its worker thread (from the TaskQueue timings of
+/// FrameTimerData), and the Qt events handled by the GUI thread (MainApplication::notify).
+///
+/// Used from the GUI thread only. The last MaxEvents events are kept.
+class FrameTracer
+{
+  public:
+    /// Nesting level of the events, and lane in the TraceTimeline.
+    enum class Category {
+        Event, ///< Qt event, on the GUI thread
+        Frame, ///< whole frame
+        Phase, ///< tasks and render phases of the frame
+        Pass,  ///< render passes
+        Task   ///< engine task, on a worker thread
+    };
+
+    struct Event {
+        std::string name;
+        Category category;
+        /// 0 for the GUI thread, worker index + 1 for the tasks
+        uint thread;
+        Core::Utils::TimePoint start;
+        Core::Utils::TimePoint end;
+    };
+
+    static constexpr size_t MaxEvents = 1 << 18;
+
+    static const char* categoryName( Category category );
+
+    inline bool isEnabled() const { return m_enabled; }
+    /// Enabling clears the previous trace.
+    void setEnabled( bool enabled );
+
+    /// Add the frames of \p stats, with their tasks and render passes.
+    void addFrames( const std::vector<FrameTimerData>& stats );
+
+    /// Add a Qt event handled by the GUI thread.
+    void addEvent( std::string name, Core::Utils::TimePoint start, Core::Utils::TimePoint end );
+
+    /// Events from the end of the frame before the last one to the end of the last one, with
+    /// the bounds of that span.
+    std::vector<Event> lastFrame( Core::Utils::TimePoint& begin,
+                                  Core::Utils::TimePoint& end ) const;
+
+    /// Number of worker threads that ran tasks.
+    inline uint workerCount() const { return m_workers; }
+
+    /// Write the trace at \p path in the Chrome Trace Event format (about:tracing, Perfetto).
+    bool exportChromeTrace( const QString& path ) const;
+
+  private:
+    void add( Event event );
+
+    bool m_enabled{false};
+    std::deque<Event> m_events;
+    uint m_workers{0};
+    /// Ends of the last two frames
+    Core::Utils::TimePoint m_previousFrameEnd;
+    Core::Utils::TimePoint m_lastFrameEnd;
+};
+
+} // namespace Gui
+} // namespace Ra
+
+#endif // RADIUMENGINE_FRAMETRACER_HPP
@@ -21,6 +21,7 @@
 #include <Gui/Viewer/Viewer.hpp>
 #include <IO/deprecated/OBJFileManager.hpp>
 #include <PluginBase/RadiumPluginInterface.hpp>
+#include <VertexCacheOptimizer.hpp>
 
 #include <Core/Utils/StringUtils.hpp>
 #include <Engine/Scene/SystemDisplay.hpp>
@@ -28,11 +29,16 @@
 
 #include <QColorDialog>
 #include <QComboBox>
+#include <QFile>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QPushButton>
 #include <QSettings>
+#include <QTextStream>
 #include <QToolButton>
 
+#include <array>
+
 using Ra::Engine::Scene::ItemEntry;
 
 namespace Ra {
@@ -78,9 +84,37 @@ MainWindow::MainWindow( QWidget* parent ) : MainWindowInterface( parent ) {
     m_selectionManager = new Gui::SelectionManager( m_itemModel, this );
     m_entitiesTreeView->setSelectionModel( m_selectionManager );
 
+    // Background loading, with its progress in the status bar
+    m_assetLoader     = new IO::AsyncAssetLoader( this );
+    m_loadingProgress = new QProgressBar( this );
+    m_loadingProgress->setMaximumWidth( 200 );
+    m_loadingProgress->setFormat( tr( "Loading %v/%m" ) );
+    m_loadingProgress->hide();
+    m_cancelLoadingButton = new QToolButton( this );
+    m_cancelLoadingButton->setText( tr( "Cancel" ) );
+    m_cancelLoadingButton->hide();
+    m_assetCacheLabel = new QLabel( this );
+    _statusBar->addPermanentWidget( m_loadingProgress );
+    _statusBar->addPermanentWidget( m_cancelLoadingButton );
+    _statusBar->addPermanentWidget( m_assetCacheLabel );
+    QSettings settings;
+    m_assetLoader->cache().setMaxBytes(
+        qint64( settings.value( "assetCache/maxSize", 1024 ).toInt() ) << 20 );
+    updateAssetCacheInfo();
+
+    // Frame trace, shown when recording
+    m_traceTimeline = new TraceTimeline( this );
+    m_traceDock     = new QDockWidget( tr( "Trace" ), this );
+    m_traceDock->setObjectName( QStringLiteral( "m_traceDock" ) );
+    m_traceDock->setWidget( m_traceTimeline );
+    addDockWidget( Qt::BottomDockWidgetArea, m_traceDock );
+    m_traceDock->hide();
+
     createConnections();
 
     mainApp->framesCountForStatsChanged( uint( m_avgFramesCount->value() ) );
+    m_frameBudget->setValue( settings.value( "stats/frameBudget", 16.67 ).toDouble() );
+    m_frameTimeGraph->setBudget( long( m_frameBudget->value() * 1000 ) );
 
     // load default color from QSettings
     updateBackgroundColor();
@@ -118,6 +152,11 @@ void MainWindow::createConnections() {
         actionTrackball, &QAction::triggered, this, &MainWindow::activateTrackballManipulator );
     connect( actionAdd_plugin_path, &QAction::triggered, this, &MainWindow::addPluginPath );
     connect( actionClear_plugin_paths, &QAction::triggered, this, &MainWindow::clearPluginPaths );
+    connect(
+        actionSet_asset_cache_limit, &QAction::triggered, this, &MainWindow::setAssetCacheLimit );
+    connect( actionClear_asset_cache, &QAction::triggered, this, &MainWindow::clearAssetCache );
+    connect( actionRecord_trace, &QAction::toggled, this, &MainWindow::recordTrace );
+    connect( actionExport_trace, &QAction::triggered, this, &MainWindow::exportTrace );
 
     // Toolbox setup
     // to update display when mode is changed
@@ -159,6 +198,28 @@ void MainWindow::createConnections() {
 
     // Loading setup.
     connect( this, &MainWindow::fileLoading, mainApp, &Ra::Gui::BaseApplication::loadFile );
+    connect( m_assetLoader, &IO::AsyncAssetLoader::progress, [=]( int done, int total ) {
+        m_loadingProgress->setMaximum( total );
+        m_loadingProgress->setValue( done );
+        m_loadingProgress->show();
+        m_cancelLoadingButton->show();
+    } );
+    connect( m_assetLoader, &IO::AsyncAssetLoader::fileLoaded, [=]( const QString& path ) {
+        if ( path == m_cameraFile )
+        {
+            activateCamera( path.toStdString() );
+            m_cameraFile.clear();
+        }
+    } );
+    connect( m_assetLoader, &IO::AsyncAssetLoader::finished, [=]() {
+        m_loadingProgress->hide();
+        m_cancelLoadingButton->hide();
+        updateAssetCacheInfo();
+    } );
+    connect( m_cancelLoadingButton,
+             &QToolButton::clicked,
+             m_assetLoader,
+             &IO::AsyncAssetLoader::cancel );
 
     // Connect picking results (TODO Val : use events to dispatch picking directly)
     connect( m_viewer, &Viewer::toggleBrushPicking, this, &MainWindow::toggleCirclePicking );
@@ -173,6 +234,12 @@ void MainWindow::createConnections() {
              &Ra::Gui::BaseApplication::updateFrameStats,
              this,
              &MainWindow::onUpdateFramestats );
+    connect( m_frameBudget,
+             static_cast<void ( QDoubleSpinBox::* )( double )>( &QDoubleSpinBox::valueChanged ),
+             this,
+             &MainWindow::setFrameBudget );
+    connect(
+        m_exportSamplesButton, &QPushButton::clicked, this, &MainWindow::exportFrameSamples );
 
     // Inform property editors of new selections
     connect( m_selectionManager,
@@ -259,6 +326,8 @@ void MainWindow::loadFile() {
     QString allexts;
     for ( const auto& loader : mainApp->m_engine->getFileLoaders() )
     {
+        // internal loader of the background loading
+        if ( dynamic_cast<const IO::ParsedFileLoader*>( loader.get() ) != nullptr ) { continue; }
         QString exts;
         for ( const auto& e : loader->getFileExtensions() )
         {
@@ -281,11 +350,9 @@ void MainWindow::loadFile() {
     {
         settings.setValue( "files/load", pathList.front() );
 
-        for ( const auto& file : pathList )
-        {
-            emit fileLoading( file );
-        }
-        activateCamera( pathList.first().toStdString() );
+        // parsed in the background, the camera of the first file is activated once it is loaded
+        m_cameraFile = pathList.first();
+        m_assetLoader->load( pathList );
     }
 }
 
@@ -332,6 +399,103 @@ void MainWindow::onUpdateFramestats( const std::vector<FrameTimerData>& stats )
     m_frameTime->setNum( int( sumFrame / N ) );
     m_frameUpdates->setNum( int( T / Scalar( sumFrame ) ) );
     m_avgFramerate->setNum( int( ( N - 1 ) * Scalar( 1000000.0 / sumInterFrame ) ) );
+
+    // averages hide the stutter: percentiles and hitches over the budget, the samples being
+    // kept for the graph and the export
+    const long budget = long( m_frameBudget->value() * 1000 );
+    std::array<std::vector<long>, 3> times; // render, tasks, frame
+    size_t hitches = 0;
+    for ( const auto& s : stats )
+    {
+        const FrameSample sample{
+            uint( s.numFrame ),
+            Core::Utils::getIntervalMicro( s.renderData.renderStart, s.renderData.renderEnd ),
+            Core::Utils::getIntervalMicro( s.tasksStart, s.tasksEnd ),
+            Core::Utils::getIntervalMicro( s.frameStart, s.frameEnd ),
+            m_frameSamples.written() > 0
+                ? Core::Utils::getIntervalMicro( m_lastFrameEnd, s.frameEnd )
+                : 0};
+        m_lastFrameEnd = s.frameEnd;
+        m_frameSamples.push( sample );
+        times[0].push_back( sample.render );
+        times[1].push_back( sample.tasks );
+        times[2].push_back( sample.frame );
+        hitches += sample.frame > budget ? 1 : 0;
+    }
+    const std::array<std::array<QLabel*, 4>, 3> percentileLabels{
+        {{m_renderP50, m_renderP95, m_renderP99, m_renderMax},
+         {m_tasksP50, m_tasksP95, m_tasksP99, m_tasksMax},
+         {m_frameP50, m_frameP95, m_frameP99, m_frameMax}}};
+    for ( size_t k = 0; k < times.size(); ++k )
+    {
+        std::sort( times[k].begin(), times[k].end() );
+        percentileLabels[k][0]->setNum( int( percentile( times[k], 0.5 ) ) );
+        percentileLabels[k][1]->setNum( int( percentile( times[k], 0.95 ) ) );
+        percentileLabels[k][2]->setNum( int( percentile( times[k], 0.99 ) ) );
+        percentileLabels[k][3]->setNum( int( times[k].back() ) );
+    }
+    m_hitches += hitches;
+    m_hitchesLabel->setText(
+        QString( "%1 (%2 in these frames)" ).arg( m_hitches ).arg( hitches ) );
+    m_frameTimeGraph->setSamples(
+        m_frameSamples.snapshot( size_t( m_frameTimeGraph->frameCount() ) ) );
+
+    if ( mainApp->tracer().isEnabled() )
+    {
+        mainApp->tracer().addFrames( stats );
+        m_traceTimeline->setTrace( mainApp->tracer() );
+    }
+}
+
+void MainWindow::setFrameBudget( double milliseconds ) {
+    QSettings settings;
+    settings.setValue( "stats/frameBudget", milliseconds );
+    m_frameTimeGraph->setBudget( long( milliseconds * 1000 ) );
+    // counted against the new budget from now on
+    m_hitches = 0;
+    m_hitchesLabel->setNum( 0 );
+}
+
+void MainWindow::exportFrameSamples() {
+    QSettings settings;
+    QString path = settings.value( "files/frameSamples", QDir::homePath() ).toString();
+    path = QFileDialog::getSaveFileName( this, "Export frame samples", path, "CSV (*.csv)" );
+    if ( path.isEmpty() ) { return; }
+    settings.setValue( "files/frameSamples", path );
+
+    QFile file( path );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        LOG( logERROR ) << "Cannot write " << path.toStdString();
+        return;
+    }
+    const auto samples = m_frameSamples.snapshot();
+    QTextStream out( &file );
+    out << "frame,render_us,tasks_us,frame_us,interframe_us\n";
+    for ( const auto& s : samples )
+    {
+        out << s.numFrame << "," << qint64( s.render ) << "," << qint64( s.tasks ) << ","
+            << qint64( s.frame ) << "," << qint64( s.interFrame ) << "\n";
+    }
+    LOG( logINFO ) << "Exported " << samples.size() << " frame samples to " << path.toStdString();
+}
+
+void MainWindow::recordTrace( bool record ) {
+    mainApp->tracer().setEnabled( record );
+    if ( record )
+    {
+        m_traceTimeline->setTrace( mainApp->tracer() );
+        m_traceDock->show();
+    }
+}
+
+void MainWindow::exportTrace() {
+    QSettings settings;
+    QString path = settings.value( "files/trace", QDir::homePath() ).toString();
+    path = QFileDialog::getSaveFileName( this, "Export trace", path, "Chrome trace (*.json)" );
+    if ( path.isEmpty() ) { return; }
+    settings.setValue( "files/trace", path );
+    mainApp->tracer().exportChromeTrace( path );
 }
 
 Viewer* MainWindow::getViewer() {
@@ -616,6 +780,7 @@ void MainWindow::onFrameComplete() {
         m_timeline->onChangeCursor( engine->getTime() );
         m_lockTimeSystem = false;
     }
+    emit frameCompleted();
 }
 
 void MainWindow::addRenderer( const std::string& name, std::shared_ptr<Engine::Rendering::Renderer> e ) {
@@ -706,7 +871,21 @@ void MainWindow::exportCurrentMesh() {
         const std::shared_ptr<Engine::Data::Displayable>& displ = ro->getMesh();
         const Engine::Data::Mesh* mesh = dynamic_cast<Engine::Data::Mesh*>( displ.get() );
 
-        if ( mesh != nullptr && obj.save( filename, mesh->getCoreGeometry() ) )
+        // The render order is kept, the optimization only applies to the exported copy
+        Core::Geometry::TriangleMesh exported;
+        if ( mesh != nullptr )
+        {
+            exported = mesh->getCoreGeometry();
+            if ( m_optimizeExportBox->isChecked() )
+            {
+                Subdivision::VertexCacheOptimizer optimizer;
+                optimizer( exported );
+                LOG( logINFO ) << "Vertex cache: ACMR " << optimizer.before().acmr << " -> "
+                               << optimizer.after().acmr << ", ATVR " << optimizer.before().atvr
+                               << " -> " << optimizer.after().atvr;
+            }
+        }
+        if ( mesh != nullptr && obj.save( filename, exported ) )
         {
             LOG( logINFO ) << "Mesh from " << ro->getName() << " successfully exported to "
                            << filename;
@@ -834,6 +1013,38 @@ void MainWindow::clearPluginPaths() {
     mainApp->clearPluginDirectories();
 }
 
+void MainWindow::setAssetCacheLimit() {
+    QSettings settings;
+    bool ok = false;
+    int size =
+        QInputDialog::getInt( this,
+                              tr( "Asset cache" ),
+                              tr( "Size limit (MB, 0 disables the cache):" ),
+                              settings.value( "assetCache/maxSize", 1024 ).toInt(),
+                              0,
+                              1 << 20,
+                              256,
+                              &ok );
+    if ( !ok ) { return; }
+    settings.setValue( "assetCache/maxSize", size );
+    m_assetLoader->cache().setMaxBytes( qint64( size ) << 20 );
+    updateAssetCacheInfo();
+}
+
+void MainWindow::clearAssetCache() {
+    m_assetLoader->cache().clear();
+    updateAssetCacheInfo();
+}
+
+void MainWindow::updateAssetCacheInfo() {
+    const auto& cache = m_assetLoader->cache();
+    m_assetCacheLabel->setText( tr( "Asset cache: %1 hits, %2 misses, %3/%4 MB" )
+                                    .arg( cache.hits() )
+                                    .arg( cache.misses() )
+                                    .arg( cache.bytes() >> 20 )
+                                    .arg( cache.maxBytes() >> 20 ) );
+}
+
 } // namespace Gui
 } // namespace Ra
 
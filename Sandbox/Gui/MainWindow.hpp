@@ -6,12 +6,19 @@
 #include <Gui/SelectionManager/SelectionManager.hpp>
 #include <Gui/TimerData/FrameTimerData.hpp>
 #include <Gui/TreeModel/EntityTreeModel.hpp>
+#include <Gui/FrameStats.hpp>
 #include <Gui/MaterialEditor.hpp>
+#include <Gui/TraceTimeline.hpp>
+#include <IO/AsyncAssetLoader.hpp>
 
 #include "ui_MainWindow.h"
 #include <QMainWindow>
 
+#include <QDockWidget>
 #include <QEvent>
+#include <QLabel>
+#include <QProgressBar>
+#include <QToolButton>
 #include <qdebug.h>
 
 namespace Ra {
@@ -77,6 +84,18 @@ class MainWindow : public Ra::Gui::MainWindowInterface, private Ui::MainWindow
     // Frame timers ui slots
     void onUpdateFramestats( const std::vector<FrameTimerData>& stats );
 
+    /// Set the budget of the hitch counter and the graph, saved in the settings.
+    void setFrameBudget( double milliseconds );
+
+    /// Export the last frame samples to a CSV file.
+    void exportFrameSamples();
+
+    /// Start or stop recording the frame trace, shown in the Trace dock.
+    void recordTrace( bool record );
+
+    /// Export the recorded trace to a Chrome trace file.
+    void exportTrace();
+
     // Selection tools
     void onSelectionChanged( const QItemSelection& selected, const QItemSelection& deselected );
 
@@ -117,6 +136,9 @@ class MainWindow : public Ra::Gui::MainWindowInterface, private Ui::MainWindow
     /// Emitted when a new item is selected. An invalid entry is sent when no item is selected.
     void selectedItem( const Engine::Scene::ItemEntry& entry );
 
+    /// Emitted at the end of each frame, by onFrameComplete().
+    void frameCompleted();
+
   private:
     /// Connect qt signals and slots. Called once by the constructor.
     void createConnections();
@@ -133,6 +155,9 @@ class MainWindow : public Ra::Gui::MainWindowInterface, private Ui::MainWindow
     /// QSettings.
     void updateBackgroundColor( QColor c = QColor() );
 
+    /// Show the hits, misses and size of the asset cache in the status bar.
+    void updateAssetCacheInfo();
+
     /// After loading a file, set the first camera loaded (if any) as the active camera.
     /// if multiple files are loaded, use the first camera of the first loaded file
     void activateCamera( const std::string& sceneName );
@@ -186,6 +211,11 @@ class MainWindow : public Ra::Gui::MainWindowInterface, private Ui::MainWindow
     /// Remove all registered plugin directories
     void clearPluginPaths();
 
+    /// Ask for the size limit of the asset cache, saved in the settings.
+    void setAssetCacheLimit();
+    /// Remove all the entries of the asset cache.
+    void clearAssetCache();
+
   private slots:
     /// Slot for the user requesting to play/pause time through the time actions.
     void on_actionPlay_triggered( bool checked );
@@ -227,6 +257,30 @@ class MainWindow : public Ra::Gui::MainWindowInterface, private Ui::MainWindow
     /// Timeline gui
     Ra::Gui::Timeline* m_timeline{nullptr};
 
+    /// Loads the files opened from the menu in the background.
+    IO::AsyncAssetLoader* m_assetLoader{nullptr};
+
+    /// Progress of the background loading and its cancel button, in the status bar.
+    QProgressBar* m_loadingProgress{nullptr};
+    QToolButton* m_cancelLoadingButton{nullptr};
+
+    /// Asset cache statistics, in the status bar.
+    QLabel* m_assetCacheLabel{nullptr};
+
+    /// File whose camera is activated once it is loaded.
+    QString m_cameraFile;
+
+    /// Last frame samples, for the graph and the export.
+    SampleRing<FrameSample, 8192> m_frameSamples;
+    /// End of the last sampled frame, for the inter-frame time of the next one.
+    Core::Utils::TimePoint m_lastFrameEnd;
+    /// Frames over the budget since it was set.
+    size_t m_hitches{0};
+
+    /// Timeline of the last traced frame, in a dock shown while recording.
+    QDockWidget* m_traceDock{nullptr};
+    TraceTimeline* m_traceTimeline{nullptr};
+
     /// Guard TimeSystem against issue with Timeline signals.
     bool m_lockTimeSystem{false};
 };
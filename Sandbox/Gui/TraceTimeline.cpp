@@ -0,0 +1,108 @@
+#include <Gui/TraceTimeline.hpp>
+
+#include <QHelpEvent>
+#include <QPainter>
+#include <QToolTip>
+
+#include <algorithm>
+
+namespace Ra {
+namespace Gui {
+
+using namespace Core::Utils; // getIntervalMicro
+
+namespace {
+constexpr int LabelWidth = 90;
+constexpr int LaneHeight = 18;
+/// Lanes of the GUI thread, before the worker ones
+constexpr int GuiLanes = 4;
+} // namespace
+
+TraceTimeline::TraceTimeline( QWidget* parent ) : QWidget( parent ) {
+    setMinimumHeight( GuiLanes * LaneHeight );
+    setSizePolicy( QSizePolicy::Expanding, QSizePolicy::Minimum );
+}
+
+void TraceTimeline::setTrace( const FrameTracer& tracer ) {
+    m_events  = tracer.lastFrame( m_begin, m_end );
+    m_workers = tracer.workerCount();
+    setMinimumHeight( int( GuiLanes + m_workers ) * LaneHeight );
+    update();
+}
+
+int TraceTimeline::lane( const FrameTracer::Event& e ) {
+    return e.category == FrameTracer::Category::Task ? GuiLanes - 1 + int( e.thread )
+                                                     : int( e.category );
+}
+
+QRect TraceTimeline::eventRect( const FrameTracer::Event& e ) const {
+    const double span  = std::max( double( getIntervalMicro( m_begin, m_end ) ), 1. );
+    const double scale = double( width() - LabelWidth ) / span;
+    const int x0       = LabelWidth + int( double( getIntervalMicro( m_begin, e.start ) ) * scale );
+    const int x1       = LabelWidth + int( double( getIntervalMicro( m_begin, e.end ) ) * scale );
+    return {std::max( x0, LabelWidth ), lane( e ) * LaneHeight, std::max( x1 - x0, 1 ), LaneHeight};
+}
+
+bool TraceTimeline::event( QEvent* event ) {
+    if ( event->type() == QEvent::ToolTip )
+    {
+        const auto help = static_cast<QHelpEvent*>( event );
+        // the innermost event under the cursor is the last drawn
+        for ( auto e = m_events.rbegin(); e != m_events.rend(); ++e )
+        {
+            if ( eventRect( *e ).contains( help->pos() ) )
+            {
+                QToolTip::showText( help->globalPos(),
+                                    QString( "%1 (%2): %3 us" )
+                                        .arg( QString::fromStdString( e->name ) )
+                                        .arg( FrameTracer::categoryName( e->category ) )
+                                        .arg( getIntervalMicro( e->start, e->end ) ) );
+                return true;
+            }
+        }
+        QToolTip::hideText();
+        event->ignore();
+        return true;
+    }
+    return QWidget::event( event );
+}
+
+void TraceTimeline::paintEvent( QPaintEvent* /*event*/ ) {
+    QPainter painter( this );
+    painter.fillRect( rect(), palette().base() );
+
+    // lane labels, then the events clipped to the timeline
+    painter.setPen( palette().color( QPalette::Text ) );
+    const QStringList guiLanes{"Qt events", "frame", "phases", "render passes"};
+    for ( int i = 0; i < int( GuiLanes + m_workers ); ++i )
+    {
+        const QString label =
+            i < GuiLanes ? guiLanes[i] : QString( "worker %1" ).arg( i - GuiLanes );
+        painter.drawText( QRect( 4, i * LaneHeight, LabelWidth - 4, LaneHeight ),
+                          Qt::AlignVCenter | Qt::AlignLeft,
+                          label );
+    }
+    painter.setClipRect( LabelWidth, 0, width() - LabelWidth, height() );
+
+    static const QColor colors[] = {QColor( 170, 170, 170 ),  // Event
+                                    QColor( 90, 140, 200 ),   // Frame
+                                    QColor( 110, 180, 110 ),  // Phase
+                                    QColor( 220, 160, 80 ),   // Pass
+                                    QColor( 190, 110, 190 )}; // Task
+    for ( const auto& e : m_events )
+    {
+        const QRect r = eventRect( e ).adjusted( 0, 1, 0, -1 );
+        painter.fillRect( r, colors[int( e.category )] );
+        painter.setPen( palette().color( QPalette::Base ) );
+        painter.drawRect( r );
+        const QString name = QString::fromStdString( e.name );
+        if ( painter.fontMetrics().boundingRect( name ).width() + 4 < r.width() )
+        {
+            painter.setPen( Qt::black );
+            painter.drawText( r, Qt::AlignCenter, name );
+        }
+    }
+}
+
+} // namespace Gui
+} // namespace Ra
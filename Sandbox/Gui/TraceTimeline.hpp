@@ -0,0 +1,45 @@
+#ifndef RADIUMENGINE_TRACETIMELINE_HPP
+#define RADIUMENGINE_TRACETIMELINE_HPP
+
+#include <Gui/FrameTracer.hpp>
+
+#include <QWidget>
+
+#include <vector>
+
+namespace Ra {
+namespace Gui {
+
+/// Timeline of the last traced frame: one lane per FrameTracer category on the GUI thread (Qt
+/// events, frame, phases, render passes), then one lane per worker thread for the tasks. The
+/// name of an event is shown in it when it fits, and as a tooltip.
+class TraceTimeline : public QWidget
+{
+    Q_OBJECT
+
+  public:
+    explicit TraceTimeline( QWidget* parent = nullptr );
+
+  public slots:
+    /// Show the last frame of \p tracer.
+    void setTrace( const FrameTracer& tracer );
+
+  private:
+    bool event( QEvent* event ) override;
+    void paintEvent( QPaintEvent* event ) override;
+
+    /// Lane of \p e, from the top.
+    static int lane( const FrameTracer::Event& e );
+    /// Rectangle of \p e in the widget.
+    QRect eventRect( const FrameTracer::Event& e ) const;
+
+    std::vector<FrameTracer::Event> m_events;
+    Core::Utils::TimePoint m_begin;
+    Core::Utils::TimePoint m_end;
+    uint m_workers{0};
+};
+
+} // namespace Gui
+} // namespace Ra
+
+#endif // RADIUMENGINE_TRACETIMELINE_HPP
@@ -0,0 +1,462 @@
+#include <IO/AssetCache.hpp>
+
+#include <Core/Asset/BlinnPhongMaterialData.hpp>
+#include <Core/Asset/GeometryData.hpp>
+#include <Core/Utils/Log.hpp>
+#include <Core/Utils/Timer.hpp>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Ra {
+namespace IO {
+
+using namespace Core::Utils; // log
+using Core::Asset::BlinnPhongMaterialData;
+using Core::Asset::GeometryData;
+
+namespace {
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t scalarSize;
+    uint32_t geometryCount;
+};
+static_assert( sizeof( CacheHeader ) == 16, "CacheHeader must be packed" );
+
+constexpr int Alignment = 16;
+
+/// Files referenced by the OBJ text [ \p data, \p data + \p size ): the libraries of its mtllib
+/// lines, relative to \p dir.
+QStringList materialLibraries( const char* data, qint64 size, const QDir& dir ) {
+    QStringList libraries;
+    const char* end = data + size;
+    for ( const char* line = data; line < end; )
+    {
+        const char* eol = std::find( line, end, '\n' );
+        if ( eol - line > 6 && std::strncmp( line, "mtllib", 6 ) == 0 )
+        {
+            const auto fields =
+                QString::fromUtf8( line, int( eol - line ) ).simplified().split( ' ' );
+            for ( int i = 1; fields.front() == "mtllib" && i < fields.size(); ++i )
+            {
+                libraries << dir.filePath( fields[i] );
+            }
+        }
+        line = eol + 1;
+    }
+    return libraries;
+}
+
+/// Textures of the material library \p content: the last argument of its map_*, bump, disp,
+/// decal and norm lines (the previous ones are options), relative to \p dir.
+QStringList textures( const QByteArray& content, const QDir& dir ) {
+    QStringList files;
+    for ( const auto& line : content.split( '\n' ) )
+    {
+        const auto fields     = QString::fromUtf8( line ).simplified().split( ' ' );
+        const auto& statement = fields.front();
+        if ( fields.size() > 1 &&
+             ( statement.startsWith( "map_" ) || statement == "bump" || statement == "disp" ||
+               statement == "decal" || statement == "norm" ) )
+        { files << dir.filePath( fields.back() ); }
+    }
+    return files;
+}
+
+/// Add the name, size and modification time of \p file to \p hash, which change if it is
+/// modified, created or deleted.
+void addFileTime( QCryptographicHash& hash, const QFileInfo& file ) {
+    const qint64 stamp[2] = {file.exists() ? file.size() : -1,
+                             file.exists() ? file.lastModified().toMSecsSinceEpoch() : 0};
+    hash.addData( file.absoluteFilePath().toUtf8() );
+    hash.addData( reinterpret_cast<const char*>( stamp ), int( sizeof( stamp ) ) );
+}
+
+/// Appends the entry, arrays being aligned for the mapping.
+class Writer
+{
+  public:
+    template <typename T>
+    void pod( const T& value ) {
+        m_data.append( reinterpret_cast<const char*>( &value ), int( sizeof( T ) ) );
+    }
+
+    void string( const std::string& s ) {
+        pod( uint32_t( s.size() ) );
+        m_data.append( s.data(), int( s.size() ) );
+    }
+
+    template <typename Container>
+    void array( const Container& c ) {
+        pod( uint64_t( c.size() ) );
+        m_data.append( ( Alignment - m_data.size() % Alignment ) % Alignment, '\0' );
+        m_data.append( reinterpret_cast<const char*>( c.data() ),
+                       int( c.size() * sizeof( typename Container::value_type ) ) );
+    }
+
+    inline const QByteArray& data() const { return m_data; }
+
+  private:
+    QByteArray m_data;
+};
+
+/// Reads a mapped entry, checking its bounds.
+class Reader
+{
+  public:
+    Reader( const uchar* data, size_t size ) : m_begin( data ), m_p( data ), m_end( data + size ) {}
+
+    template <typename T>
+    T pod() {
+        T value{};
+        if ( check( sizeof( T ) ) )
+        {
+            std::memcpy( &value, m_p, sizeof( T ) );
+            m_p += sizeof( T );
+        }
+        return value;
+    }
+
+    std::string string() {
+        const auto n = pod<uint32_t>();
+        if ( !check( n ) ) { return {}; }
+        std::string s( reinterpret_cast<const char*>( m_p ), n );
+        m_p += n;
+        return s;
+    }
+
+    template <typename Container>
+    void array( Container& c ) {
+        const auto n = pod<uint64_t>();
+        skip( ( Alignment - size_t( m_p - m_begin ) % Alignment ) % Alignment );
+        // checking n first avoids the overflow of the size in bytes
+        const size_t bytes = size_t( n ) * sizeof( typename Container::value_type );
+        if ( !check( n ) || !check( bytes ) ) { return; }
+        c.resize( n );
+        std::memcpy( c.data(), m_p, bytes );
+        m_p += bytes;
+    }
+
+    inline void fail() { m_ok = false; }
+    inline bool ok() const { return m_ok; }
+
+  private:
+    void skip( size_t bytes ) {
+        if ( check( bytes ) ) { m_p += bytes; }
+    }
+
+    bool check( size_t bytes ) {
+        m_ok = m_ok && m_p <= m_end && bytes <= size_t( m_end - m_p );
+        return m_ok;
+    }
+
+    const uchar* m_begin;
+    const uchar* m_p;
+    const uchar* m_end;
+    bool m_ok{true};
+};
+
+bool cacheable( const Core::Asset::FileData& data ) {
+    if ( data.m_geometryData.empty() || !data.m_handleData.empty() ||
+         !data.m_animationData.empty() || !data.m_lightData.empty() ||
+         !data.m_cameraData.empty() || !data.m_volumeData.empty() )
+    { return false; }
+    for ( const auto& geometry : data.m_geometryData )
+    {
+        if ( geometry->getType() == GeometryData::LINE_MESH ||
+             ( geometry->hasMaterial() && geometry->getMaterial().getType() != "BlinnPhong" ) )
+        { return false; }
+    }
+    return true;
+}
+
+using Scalars4  = std::array<Scalar, 4>;
+using Scalars16 = std::array<Scalar, 16>;
+
+void writeMaterial( Writer& out, const BlinnPhongMaterialData& m ) {
+    out.string( m.getName() );
+    for ( const auto& c : {m.m_diffuse, m.m_specular} )
+    { out.pod( Scalars4{{c( 0 ), c( 1 ), c( 2 ), c( 3 )}} ); }
+    out.pod( m.m_shininess );
+    out.pod( m.m_opacity );
+    for ( const auto& texture :
+          {m.m_texDiffuse, m.m_texSpecular, m.m_texShininess, m.m_texNormal, m.m_texOpacity} )
+    { out.string( texture ); }
+    for ( bool flag : {m.m_hasDiffuse,
+                       m.m_hasSpecular,
+                       m.m_hasShininess,
+                       m.m_hasOpacity,
+                       m.m_hasTexDiffuse,
+                       m.m_hasTexSpecular,
+                       m.m_hasTexShininess,
+                       m.m_hasTexNormal,
+                       m.m_hasTexOpacity} )
+    { out.pod( uint8_t( flag ) ); }
+}
+
+BlinnPhongMaterialData* readMaterial( Reader& in ) {
+    auto m = new BlinnPhongMaterialData( in.string() );
+    for ( auto color : {&m->m_diffuse, &m->m_specular} )
+    {
+        const auto c = in.pod<Scalars4>();
+        *color       = Core::Utils::Color( c[0], c[1], c[2], c[3] );
+    }
+    m->m_shininess = in.pod<Scalar>();
+    m->m_opacity   = in.pod<Scalar>();
+    for ( auto texture : {&m->m_texDiffuse,
+                          &m->m_texSpecular,
+                          &m->m_texShininess,
+                          &m->m_texNormal,
+                          &m->m_texOpacity} )
+    { *texture = in.string(); }
+    for ( auto flag : {&m->m_hasDiffuse,
+                       &m->m_hasSpecular,
+                       &m->m_hasShininess,
+                       &m->m_hasOpacity,
+                       &m->m_hasTexDiffuse,
+                       &m->m_hasTexSpecular,
+                       &m->m_hasTexShininess,
+                       &m->m_hasTexNormal,
+                       &m->m_hasTexOpacity} )
+    { *flag = in.pod<uint8_t>() != 0; }
+    return m;
+}
+} // namespace
+
+AssetCache::AssetCache( const QString& directory ) :
+    m_directory( directory.isEmpty()
+                     ? QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) +
+                           "/assets"
+                     : directory ) {
+    QDir dir( m_directory );
+    dir.mkpath( "." );
+    qint64 bytes = 0;
+    for ( const auto& entry : dir.entryInfoList( {"*.rac"}, QDir::Files ) )
+    {
+        bytes += entry.size();
+    }
+    m_bytes = bytes;
+}
+
+std::string AssetCache::key( const QString& path, const std::string& loaderName ) const {
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) ) { return {}; }
+    QByteArray read;
+    const uchar* mapped = file.map( 0, file.size() );
+    if ( mapped == nullptr ) { read = file.readAll(); }
+    const char* data  = mapped != nullptr ? reinterpret_cast<const char*>( mapped ) : read.data();
+    const qint64 size = mapped != nullptr ? file.size() : read.size();
+
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    for ( qint64 done = 0; done < size; done += qint64( 1 ) << 30 )
+    { hash.addData( data + done, int( std::min( size - done, qint64( 1 ) << 30 ) ) ); }
+    // the same file in another directory may not have the same side files
+    const QFileInfo info( path );
+    const QDir dir = info.absoluteDir();
+    hash.addData( info.canonicalPath().toUtf8() );
+    if ( info.suffix().compare( "obj", Qt::CaseInsensitive ) == 0 )
+    {
+        for ( const auto& library : materialLibraries( data, size, dir ) )
+        {
+            QFile mtl( library );
+            const QByteArray content =
+                mtl.open( QIODevice::ReadOnly ) ? mtl.readAll() : QByteArray();
+            const QFileInfo mtlInfo( library );
+            addFileTime( hash, mtlInfo );
+            hash.addData( content );
+            for ( const auto& texture : textures( content, mtlInfo.absoluteDir() ) )
+            { addFileTime( hash, QFileInfo( texture ) ); }
+        }
+    }
+    else
+    {
+        // the references of the other formats are not parsed: any file of the directory may be
+        // one
+        for ( const auto& other : dir.entryInfoList( QDir::Files, QDir::Name ) )
+        {
+            if ( other.fileName() != info.fileName() ) { addFileTime( hash, other ); }
+        }
+    }
+    if ( mapped != nullptr ) { file.unmap( const_cast<uchar*>( mapped ) ); }
+
+    const uint32_t version = Version;
+    hash.addData( loaderName.data(), int( loaderName.size() ) );
+    hash.addData( reinterpret_cast<const char*>( &version ), int( sizeof( version ) ) );
+    return hash.result().toHex().toStdString();
+}
+
+QString AssetCache::entryPath( const std::string& key ) const {
+    return m_directory + "/" + QString::fromStdString( key ) + ".rac";
+}
+
+Core::Asset::FileData* AssetCache::load( const std::string& key, const std::string& filename ) {
+    auto start = Clock::now();
+
+    // an eviction meanwhile only unlinks the entry (or fails to remove it on Windows), the mapping
+    // stays valid
+    QFile file( entryPath( key ) );
+    const uchar* data = nullptr;
+    if ( file.open( QIODevice::ReadWrite ) ) { data = file.map( 0, file.size() ); }
+    if ( data == nullptr )
+    {
+        ++m_misses;
+        return nullptr;
+    }
+
+    Reader in( data, size_t( file.size() ) );
+    const auto header = in.pod<CacheHeader>();
+    if ( std::strncmp( header.magic, "RAC", 4 ) != 0 || header.version != Version ||
+         header.scalarSize != sizeof( Scalar ) )
+    { in.fail(); }
+
+    auto fileData = std::make_unique<Core::Asset::FileData>( filename );
+    for ( uint32_t g = 0; in.ok() && g < header.geometryCount; ++g )
+    {
+        const std::string name = in.string();
+        const auto type        = GeometryData::GeometryType( in.pod<uint32_t>() );
+        auto geometry          = std::make_unique<GeometryData>( name, type );
+        const auto frame       = in.pod<Scalars16>();
+        geometry->setFrame( Core::Transform( Eigen::Map<const Core::Matrix4>( frame.data() ) ) );
+        in.array( geometry->getVertices() );
+        in.array( geometry->getNormals() );
+        in.array( geometry->getTangents() );
+        in.array( geometry->getBiTangents() );
+        in.array( geometry->getTexCoords() );
+        in.array( geometry->getColors() );
+        std::vector<uint32_t> faceSizes, indices;
+        in.array( faceSizes );
+        in.array( indices );
+        auto& faces   = geometry->getFaces();
+        size_t offset = 0;
+        faces.resize( faceSizes.size() );
+        for ( size_t f = 0; in.ok() && f < faceSizes.size(); ++f )
+        {
+            if ( faceSizes[f] > indices.size() - offset )
+            {
+                in.fail();
+                break;
+            }
+            faces[f] = Eigen::Map<const Core::VectorNui>( indices.data() + offset, faceSizes[f] );
+            offset += faceSizes[f];
+        }
+        if ( in.pod<uint8_t>() != 0 ) { geometry->setMaterial( readMaterial( in ) ); }
+        fileData->m_geometryData.push_back( std::move( geometry ) );
+    }
+    file.unmap( const_cast<uchar*>( data ) );
+
+    if ( !in.ok() )
+    {
+        LOG( logWARNING ) << "Dropping the invalid asset cache entry " << key << ".";
+        const qint64 size = file.size();
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( file.remove() ) { m_bytes -= size; }
+        ++m_misses;
+        return nullptr;
+    }
+    {
+        // the modification time orders the entries for the eviction
+        std::lock_guard<std::mutex> lock( m_mutex );
+        file.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+    }
+    ++m_hits;
+    fileData->m_loadingTime = getIntervalSeconds( start, Clock::now() );
+    LOG( logINFO ) << "Loaded " << filename << " from the asset cache in "
+                   << fileData->m_loadingTime << "s.";
+    return fileData.release();
+}
+
+bool AssetCache::store( const std::string& key, const Core::Asset::FileData& data ) {
+    if ( m_maxBytes == 0 || !cacheable( data ) ) { return false; }
+
+    Writer out;
+    CacheHeader header{{'R', 'A', 'C', '\0'},
+                       Version,
+                       uint32_t( sizeof( Scalar ) ),
+                       uint32_t( data.m_geometryData.size() )};
+    out.pod( header );
+    for ( const auto& geometry : data.m_geometryData )
+    {
+        out.string( geometry->getName() );
+        out.pod( uint32_t( geometry->getType() ) );
+        Scalars16 frame;
+        Eigen::Map<Core::Matrix4>( frame.data() ) = geometry->getFrame().matrix();
+        out.pod( frame );
+        out.array( geometry->getVertices() );
+        out.array( geometry->getNormals() );
+        out.array( geometry->getTangents() );
+        out.array( geometry->getBiTangents() );
+        out.array( geometry->getTexCoords() );
+        out.array( geometry->getColors() );
+        std::vector<uint32_t> faceSizes, indices;
+        for ( const auto& face : geometry->getFaces() )
+        {
+            faceSizes.push_back( uint32_t( face.size() ) );
+            indices.insert( indices.end(), face.data(), face.data() + face.size() );
+        }
+        out.array( faceSizes );
+        out.array( indices );
+        out.pod( uint8_t( geometry->hasMaterial() ) );
+        if ( geometry->hasMaterial() )
+        {
+            writeMaterial(
+                out, static_cast<const BlinnPhongMaterialData&>( geometry->getMaterial() ) );
+        }
+    }
+    if ( out.data().size() > m_maxBytes ) { return false; }
+
+    // the entry is written to a temporary file, only its replacement of the entry is locked
+    QSaveFile file( entryPath( key ) );
+    const bool written =
+        file.open( QIODevice::WriteOnly ) && file.write( out.data() ) == out.data().size();
+    std::lock_guard<std::mutex> lock( m_mutex );
+    const qint64 previous = QFileInfo( file.fileName() ).size();
+    if ( !written || !file.commit() )
+    {
+        LOG( logWARNING ) << "Cannot write the asset cache entry " << key << ".";
+        return false;
+    }
+    m_bytes += out.data().size() - previous;
+    evict();
+    return true;
+}
+
+void AssetCache::clear() {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    QDir dir( m_directory );
+    for ( const auto& entry : dir.entryList( {"*.rac"}, QDir::Files ) )
+    {
+        dir.remove( entry );
+    }
+    m_bytes = 0;
+}
+
+void AssetCache::setMaxBytes( qint64 maxBytes ) {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_maxBytes = maxBytes;
+    evict();
+}
+
+void AssetCache::evict() {
+    if ( m_bytes <= m_maxBytes ) { return; }
+    QDir dir( m_directory );
+    const auto entries =
+        dir.entryInfoList( {"*.rac"}, QDir::Files, QDir::Time | QDir::Reversed );
+    for ( const auto& entry : entries )
+    {
+        if ( m_bytes <= m_maxBytes ) { break; }
+        if ( dir.remove( entry.fileName() ) ) { m_bytes -= entry.size(); }
+    }
+}
+
+} // namespace IO
+} // namespace Ra
@@ -0,0 +1,85 @@
+#ifndef RADIUMENGINE_ASSETCACHE_HPP
+#define RADIUMENGINE_ASSETCACHE_HPP
+
+#include <Core/Asset/FileData.hpp>
+
+#include <QString>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace Ra {
+namespace IO {
+
+/// Disk cache of the FileData produced by the loaders, so that reopening a file maps its
+/// buffers instead of parsing it and recomputing them.
+///
+/// Entries are keyed by the MD5 of the file content, its canonical directory, its side files, the
+/// name of the loader and the layout Version. The side files of an OBJ file are its .mtl files,
+/// whose content is hashed, and their textures, by size and modification time; for other formats,
+/// the size and modification time of the other files of the directory are used.
+///
+/// Entries hold the geometries of the file: name, type and frame (the loaders flatten the node
+/// hierarchy of the file into the geometry frames), vertex buffers, faces, and Blinn-Phong
+/// material. Files with handles, animations, lights, cameras, volumes or other materials are not
+/// cached.
+///
+/// An entry is a header followed by the geometries, whose arrays are 16 bytes aligned: it is
+/// mapped and the arrays are copied to the containers without parsing. The least recently used
+/// entries are evicted beyond the size limit.
+///
+/// Thread safe: the AsyncAssetLoader uses it from its pool. Entries are mapped and copied without
+/// the lock, which only guards the eviction and the bookkeeping.
+class AssetCache
+{
+  public:
+    /// Version of the layout, to bump when it, or the output of a loader, changes.
+    static constexpr uint32_t Version = 1;
+
+    /// Cache in \p directory, the Qt cache location by default.
+    explicit AssetCache( const QString& directory = QString() );
+
+    /// Key of the file at \p path read by the loader \p loaderName, empty if the file cannot be
+    /// read.
+    std::string key( const QString& path, const std::string& loaderName ) const;
+
+    /// The FileData of \p filename stored under \p key, nullptr (a miss) if there is none.
+    Core::Asset::FileData* load( const std::string& key, const std::string& filename );
+
+    /// Store \p data under \p key. Returns false if \p data cannot be cached, or the cache is
+    /// disabled (size limit of 0).
+    bool store( const std::string& key, const Core::Asset::FileData& data );
+
+    /// Remove all the entries.
+    void clear();
+
+    /// Size limit of the entries, in bytes.
+    void setMaxBytes( qint64 maxBytes );
+    inline qint64 maxBytes() const { return m_maxBytes; }
+    /// Size of the entries, in bytes.
+    inline qint64 bytes() const { return m_bytes; }
+
+    /// Lookups since the cache was created.
+    inline size_t hits() const { return m_hits; }
+    inline size_t misses() const { return m_misses; }
+
+  private:
+    QString entryPath( const std::string& key ) const;
+
+    /// Remove the least recently used entries beyond the size limit. Needs m_mutex.
+    void evict();
+
+    QString m_directory;
+    /// Guards the removal of the entries and m_bytes updates
+    std::mutex m_mutex;
+    std::atomic<qint64> m_maxBytes{qint64( 1 ) << 30};
+    std::atomic<qint64> m_bytes{0};
+    std::atomic<size_t> m_hits{0};
+    std::atomic<size_t> m_misses{0};
+};
+
+} // namespace IO
+} // namespace Ra
+
+#endif // RADIUMENGINE_ASSETCACHE_HPP
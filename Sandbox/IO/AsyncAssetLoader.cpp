@@ -0,0 +1,178 @@
+#include <IO/AsyncAssetLoader.hpp>
+#include <IO/BinaryMeshLoader.hpp>
+#include <MainApplication.hpp>
+
+#include <Core/Utils/Log.hpp>
+#include <Core/Utils/StringUtils.hpp>
+#include <Core/Utils/Timer.hpp>
+#include <Engine/RadiumEngine.hpp>
+
+#include <QFileInfo>
+#include <QRunnable>
+
+#include <functional>
+
+namespace Ra {
+namespace IO {
+
+using namespace Core::Utils; // log
+
+namespace {
+const std::string ParsedExtension = "rparsed";
+
+class ParseTask : public QRunnable
+{
+  public:
+    explicit ParseTask( std::function<void()> task ) : m_task( std::move( task ) ) {}
+    void run() override { m_task(); }
+
+  private:
+    std::function<void()> m_task;
+};
+} // namespace
+
+QString ParsedFileLoader::parsedName( const QString& path ) {
+    const QFileInfo info( path );
+    return info.path() + "/" + info.completeBaseName() + "." +
+           QString::fromStdString( ParsedExtension );
+}
+
+std::vector<std::string> ParsedFileLoader::getFileExtensions() const {
+    return std::vector<std::string>( {"*." + ParsedExtension} );
+}
+
+bool ParsedFileLoader::handleFileExtension( const std::string& extension ) const {
+    return extension == ParsedExtension;
+}
+
+Core::Asset::FileData* ParsedFileLoader::loadFile( const std::string& /*filename*/ ) {
+    return m_next.release();
+}
+
+std::string ParsedFileLoader::name() const {
+    return "Parsed files";
+}
+
+AsyncAssetLoader::AsyncAssetLoader( QObject* parent ) :
+    QObject( parent ),
+    m_parsedFileLoader( std::make_shared<ParsedFileLoader>() ) {
+    Engine::RadiumEngine::getInstance()->registerFileLoader( m_parsedFileLoader );
+    // one slice per frame at the default 60 fps
+    m_timer.setInterval( 16 );
+    connect( &m_timer, &QTimer::timeout, this, &AsyncAssetLoader::addParsedFiles );
+}
+
+AsyncAssetLoader::~AsyncAssetLoader() {
+    cancel();
+    m_pool.waitForDone();
+}
+
+void AsyncAssetLoader::load( const QStringList& paths ) {
+    const unsigned int generation = m_generation;
+    for ( const auto& path : paths )
+    {
+        m_pool.start( new ParseTask( [this, path, generation]() { parse( path, generation ); } ) );
+    }
+    m_total += paths.size();
+    emit progress( m_done, m_total );
+    if ( !m_timer.isActive() ) { m_timer.start(); }
+}
+
+void AsyncAssetLoader::cancel() {
+    ++m_generation;
+    m_pool.clear();
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_parsed.clear();
+    }
+    if ( isLoading() )
+    {
+        LOG( logINFO ) << "Loading cancelled, " << m_total - m_done << " files dropped.";
+        finish();
+    }
+}
+
+void AsyncAssetLoader::parse( const QString& path, unsigned int generation ) {
+    if ( generation != m_generation ) { return; }
+    auto start = Clock::now();
+
+    const std::string filename  = path.toLocal8Bit().data();
+    const std::string extension = getFileExt( filename );
+    std::unique_ptr<Core::Asset::FileData> data;
+    for ( const auto& loader : Engine::RadiumEngine::getInstance()->getFileLoaders() )
+    {
+        if ( loader == m_parsedFileLoader || !loader->handleFileExtension( extension ) )
+        { continue; }
+        // .rbm files are mapped already, and not cached
+        const bool mapped     = dynamic_cast<const BinaryMeshLoader*>( loader.get() ) != nullptr;
+        const std::string key = mapped || m_cache.maxBytes() == 0
+                                    ? std::string()
+                                    : m_cache.key( path, loader->name() );
+        if ( !key.empty() ) { data.reset( m_cache.load( key, filename ) ); }
+        if ( data == nullptr )
+        {
+            {
+                std::unique_lock<std::mutex> lock;
+                if ( !mapped )
+                { lock = std::unique_lock<std::mutex>( loaderMutex( loader.get() ) ); }
+                data.reset( loader->loadFile( filename ) );
+            }
+            if ( data != nullptr && !key.empty() ) { m_cache.store( key, *data ); }
+        }
+        if ( data != nullptr ) { break; }
+    }
+    if ( data == nullptr ) { LOG( logERROR ) << "No loader could read " << filename; }
+    else
+    {
+        LOG( logINFO ) << "Parsed " << filename << " in "
+                       << getIntervalSeconds( start, Clock::now() ) << " s.";
+    }
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( generation == m_generation ) { m_parsed.push_back( {path, std::move( data )} ); }
+}
+
+std::mutex& AsyncAssetLoader::loaderMutex( const Core::Asset::FileLoaderInterface* loader ) {
+    std::lock_guard<std::mutex> lock( m_mutex );
+    auto& mutex = m_loaderMutexes[loader];
+    if ( mutex == nullptr ) { mutex = std::make_unique<std::mutex>(); }
+    return *mutex;
+}
+
+void AsyncAssetLoader::addParsedFiles() {
+    auto start = Clock::now();
+    bool added = false;
+    while ( m_done < m_total &&
+            ( !added || getIntervalMicro( start, Clock::now() ) < m_frameBudget * 1000 ) )
+    {
+        ParsedFile file;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if ( m_parsed.empty() ) { break; }
+            file = std::move( m_parsed.front() );
+            m_parsed.pop_front();
+        }
+        ++m_done;
+        if ( file.data != nullptr )
+        {
+            m_parsedFileLoader->setNext( std::move( file.data ) );
+            mainApp->loadFile( ParsedFileLoader::parsedName( file.path ) );
+            added = true;
+            emit fileLoaded( file.path );
+        }
+        emit progress( m_done, m_total );
+    }
+    // the render objects of the slice are uploaded by the next frame
+    if ( added ) { mainApp->askForUpdate(); }
+    if ( isLoading() && m_done == m_total ) { finish(); }
+}
+
+void AsyncAssetLoader::finish() {
+    m_timer.stop();
+    m_total = 0;
+    m_done  = 0;
+    emit finished();
+}
+
+} // namespace IO
+} // namespace Ra
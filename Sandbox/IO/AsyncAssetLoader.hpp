@@ -0,0 +1,136 @@
+#ifndef RADIUMENGINE_ASYNCASSETLOADER_HPP
+#define RADIUMENGINE_ASYNCASSETLOADER_HPP
+
+#include <Core/Asset/FileData.hpp>
+#include <Core/Asset/FileLoaderInterface.hpp>
+#include <IO/AssetCache.hpp>
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace Ra {
+namespace IO {
+
+/// Loader of the files parsed by the AsyncAssetLoader: RadiumEngine::loadFile is given a name
+/// with the "rparsed" extension, and this loader returns the FileData parsed beforehand, from
+/// which the engine builds the entity.
+class ParsedFileLoader : public Core::Asset::FileLoaderInterface
+{
+  public:
+    /// Name under which the file at \p path is given to the engine. It keeps the base name of
+    /// \p path, which names the entity.
+    static QString parsedName( const QString& path );
+
+    std::vector<std::string> getFileExtensions() const override;
+    bool handleFileExtension( const std::string& extension ) const override;
+    /// Returns the FileData given to setNext(), whatever \p filename.
+    Core::Asset::FileData* loadFile( const std::string& filename ) override;
+    std::string name() const override;
+
+    inline void setNext( std::unique_ptr<Core::Asset::FileData> data ) {
+        m_next = std::move( data );
+    }
+
+  private:
+    std::unique_ptr<Core::Asset::FileData> m_next;
+};
+
+/// Loads files without blocking the user interface.
+///
+/// The files are parsed concurrently, by the loaders of the engine, in a thread pool. Loaders
+/// may keep a state (the Assimp importer does), so each loader parses one file at a time, except
+/// the stateless BinaryMeshLoader: files of different formats, and .rbm files, are parsed in
+/// parallel. The AssetCache is consulted before parsing, and stores the parsed files.
+///
+/// The entities are built on the GUI thread, as the engine, its systems and the item model are
+/// not thread safe: a timer adds the parsed files to the engine, one after the other, for at most
+/// the frame budget per tick, and asks for a frame after each slice. The render objects of a
+/// slice are thus uploaded to the GPU by the next frame, instead of all at the end.
+class AsyncAssetLoader : public QObject
+{
+    Q_OBJECT
+
+  public:
+    /// Registers the ParsedFileLoader in the engine.
+    explicit AsyncAssetLoader( QObject* parent = nullptr );
+    /// Cancels the loading, and waits for the files being parsed.
+    ~AsyncAssetLoader() override;
+
+    /// Queue the files at \p paths.
+    void load( const QStringList& paths );
+
+    inline bool isLoading() const { return m_total > 0; }
+
+    /// Time spent adding parsed files to the engine between two frames, 8 ms by default. A large
+    /// file may exceed it, as each file is added at once.
+    inline void setFrameBudget( int milliseconds ) { m_frameBudget = milliseconds; }
+
+    /// Cache of the parsed files.
+    inline AssetCache& cache() { return m_cache; }
+
+  public slots:
+    /// Drop the files not added to the engine yet. The files being parsed are discarded once
+    /// parsed.
+    void cancel();
+
+  signals:
+    /// Emitted when a file has been added to the engine, or failed to load.
+    void progress( int done, int total );
+
+    /// Emitted when the file at \p path has been added to the engine.
+    void fileLoaded( const QString& path );
+
+    /// Emitted when all the queued files are done, or cancelled.
+    void finished();
+
+  private slots:
+    /// Add parsed files to the engine, within the frame budget.
+    void addParsedFiles();
+
+  private:
+    struct ParsedFile {
+        QString path;
+        /// nullptr if no loader could read the file
+        std::unique_ptr<Core::Asset::FileData> data;
+    };
+
+    /// Parse the file at \p path, in the pool, with the first loader that reads it.
+    void parse( const QString& path, unsigned int generation );
+
+    /// Mutex of a loader with a state.
+    std::mutex& loaderMutex( const Core::Asset::FileLoaderInterface* loader );
+
+    void finish();
+
+    QThreadPool m_pool;
+    QTimer m_timer;
+    int m_frameBudget{8};
+    std::shared_ptr<ParsedFileLoader> m_parsedFileLoader;
+    AssetCache m_cache;
+
+    /// Guards the parsed files and the loader mutexes
+    std::mutex m_mutex;
+    std::deque<ParsedFile> m_parsed;
+    std::map<const Core::Asset::FileLoaderInterface*, std::unique_ptr<std::mutex>>
+        m_loaderMutexes;
+
+    /// Incremented by cancel(): the files parsed for an older generation are dropped
+    std::atomic<unsigned int> m_generation{0};
+    /// Files queued, and added to the engine or failed, since the loading started
+    int m_total{0};
+    int m_done{0};
+};
+
+} // namespace IO
+} // namespace Ra
+
+#endif // RADIUMENGINE_ASYNCASSETLOADER_HPP
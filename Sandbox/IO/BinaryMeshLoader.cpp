@@ -0,0 +1,141 @@
+#include <IO/BinaryMeshLoader.hpp>
+
+#include <Core/Asset/FileData.hpp>
+#include <Core/Asset/GeometryData.hpp>
+#include <Core/Utils/Log.hpp>
+#include <Core/Utils/StringUtils.hpp>
+#include <Core/Utils/Timer.hpp>
+
+#include <QFile>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Ra {
+namespace IO {
+
+using namespace Core::Utils; // log
+
+namespace {
+/// Must match Subdivision::BinaryMeshHeader in CLISubdivider/MeshWriter.hpp
+struct BinaryMeshHeader {
+    static constexpr uint32_t HasNormals = 1;
+
+    char magic[4];
+    uint32_t version;
+    uint32_t faceSize;
+    uint32_t flags;
+    uint64_t vertexCount;
+    uint64_t faceCount;
+};
+static_assert( sizeof( BinaryMeshHeader ) == 32, "BinaryMeshHeader must be packed" );
+
+void copyVector3( const uchar* in, size_t n, Core::Vector3Array& out ) {
+    out.resize( n );
+    if ( std::is_same<Scalar, float>::value && sizeof( Core::Vector3 ) == 3 * sizeof( float ) )
+    { std::memcpy( out.data(), in, n * sizeof( Core::Vector3 ) ); }
+    else
+    {
+        const float* f = reinterpret_cast<const float*>( in );
+        for ( size_t i = 0; i < n; ++i )
+        {
+            out[i] = Core::Vector3( Scalar( f[3 * i] ), Scalar( f[3 * i + 1] ), Scalar( f[3 * i + 2] ) );
+        }
+    }
+}
+} // namespace
+
+std::vector<std::string> BinaryMeshLoader::getFileExtensions() const {
+    return std::vector<std::string>( {"*.rbm"} );
+}
+
+bool BinaryMeshLoader::handleFileExtension( const std::string& extension ) const {
+    return extension.compare( "rbm" ) == 0;
+}
+
+Core::Asset::FileData* BinaryMeshLoader::loadFile( const std::string& filename ) {
+    auto start = Clock::now();
+
+    QFile file( QString::fromStdString( filename ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        LOG( logERROR ) << "Cannot open " << filename;
+        return nullptr;
+    }
+    const auto size = size_t( file.size() );
+    const uchar* data = file.map( 0, file.size() );
+    if ( data == nullptr || size < sizeof( BinaryMeshHeader ) )
+    {
+        LOG( logERROR ) << "Cannot map " << filename;
+        return nullptr;
+    }
+
+    BinaryMeshHeader header;
+    std::memcpy( &header, data, sizeof( header ) );
+    const bool hasNormals = ( header.flags & BinaryMeshHeader::HasNormals ) != 0;
+    // the counts are checked against the file size by division, as a crafted header could make
+    // their products wrap around
+    const uint64_t payload   = size - sizeof( header );
+    const uint64_t perVertex = ( hasNormals ? 2 : 1 ) * 3 * sizeof( float );
+    const uint64_t perFace   = uint64_t( header.faceSize ) * sizeof( uint32_t );
+    const bool validHeader = std::strncmp( header.magic, "RBM", 4 ) == 0 &&
+                             header.version == 1 && header.faceSize >= 3 &&
+                             header.vertexCount <= payload / perVertex;
+    const uint64_t vertexBytes   = validHeader ? header.vertexCount * 3 * sizeof( float ) : 0;
+    const uint64_t faceDataBytes = payload - ( hasNormals ? 2 : 1 ) * vertexBytes;
+    if ( !validHeader || header.faceCount > faceDataBytes / perFace )
+    {
+        LOG( logERROR ) << filename << " is not a valid binary mesh file.";
+        return nullptr;
+    }
+
+    auto geometry = std::make_unique<Core::Asset::GeometryData>(
+        getBaseName( filename, false ),
+        header.faceSize == 3
+            ? Core::Asset::GeometryData::TRI_MESH
+            : ( header.faceSize == 4 ? Core::Asset::GeometryData::QUAD_MESH
+                                     : Core::Asset::GeometryData::POLY_MESH ) );
+    geometry->setFrame( Core::Transform::Identity() );
+
+    const uchar* p = data + sizeof( header );
+    copyVector3( p, header.vertexCount, geometry->getVertices() );
+    p += vertexBytes;
+    if ( hasNormals )
+    {
+        copyVector3( p, header.vertexCount, geometry->getNormals() );
+        p += vertexBytes;
+    }
+
+    auto& faces          = geometry->getFaces();
+    const uint32_t* idx  = reinterpret_cast<const uint32_t*>( p );
+    const size_t indices = size_t( header.faceCount ) * header.faceSize;
+    if ( std::any_of( idx, idx + indices, [&header]( uint32_t i ) {
+             return i >= header.vertexCount;
+         } ) )
+    {
+        LOG( logERROR ) << filename << " has face indices out of its " << header.vertexCount
+                        << " vertices.";
+        return nullptr;
+    }
+    faces.resize( header.faceCount );
+    for ( size_t f = 0; f < header.faceCount; ++f )
+    {
+        faces[f] = Eigen::Map<const Core::VectorNui>( idx + f * header.faceSize,
+                                                       header.faceSize );
+    }
+    file.unmap( const_cast<uchar*>( data ) );
+
+    auto fileData = new Core::Asset::FileData( filename );
+    fileData->m_geometryData.push_back( std::move( geometry ) );
+    fileData->m_loadingTime = getIntervalSeconds( start, Clock::now() );
+    LOG( logINFO ) << "Loaded " << filename << " (" << header.vertexCount << " vertices, "
+                   << header.faceCount << " faces) in " << fileData->m_loadingTime << "s.";
+    return fileData;
+}
+
+std::string BinaryMeshLoader::name() const {
+    return "Radium binary mesh";
+}
+
+} // namespace IO
+} // namespace Ra
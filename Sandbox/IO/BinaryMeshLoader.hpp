@@ -0,0 +1,24 @@
+#ifndef RADIUMENGINE_BINARYMESHLOADER_HPP
+#define RADIUMENGINE_BINARYMESHLOADER_HPP
+
+#include <Core/Asset/FileLoaderInterface.hpp>
+
+namespace Ra {
+namespace IO {
+
+/// Loader for the raw binary mesh container (.rbm) written by Radium-CLI-Subdivider
+/// (see CLISubdivider/README.md for the layout).
+/// The file is memory-mapped and its buffers are copied to the GeometryData without parsing.
+class BinaryMeshLoader : public Core::Asset::FileLoaderInterface
+{
+  public:
+    std::vector<std::string> getFileExtensions() const override;
+    bool handleFileExtension( const std::string& extension ) const override;
+    Core::Asset::FileData* loadFile( const std::string& filename ) override;
+    std::string name() const override;
+};
+
+} // namespace IO
+} // namespace Ra
+
+#endif // RADIUMENGINE_BINARYMESHLOADER_HPP
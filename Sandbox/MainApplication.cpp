@@ -1 +1,24 @@
 #include <MainApplication.hpp>
+
+#include <QMetaEnum>
+#include <QThread>
+
+namespace Ra {
+
+bool MainApplication::notify( QObject* receiver, QEvent* event ) {
+    if ( !m_tracer.isEnabled() || QThread::currentThread() != thread() )
+    { return BaseApplication::notify( receiver, event ); }
+
+    // named before delivery, which may delete the receiver
+    static const QMetaEnum types = QMetaEnum::fromType<QEvent::Type>();
+    const char* type             = types.valueToKey( event->type() );
+    std::string name             = type ? type : "Event " + std::to_string( event->type() );
+    name += std::string( " " ) + receiver->metaObject()->className();
+
+    const auto start   = Core::Utils::Clock::now();
+    const bool handled = BaseApplication::notify( receiver, event );
+    m_tracer.addEvent( std::move( name ), start, Core::Utils::Clock::now() );
+    return handled;
+}
+
+} // namespace Ra
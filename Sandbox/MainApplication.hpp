@@ -1,4 +1,5 @@
 #include <Gui/BaseApplication.hpp>
+#include <Gui/FrameTracer.hpp>
 
 /// Allow singleton-like access to the main app à la qApp.
 #if defined( mainApp )
@@ -11,6 +12,15 @@ class MainApplication : public Ra::Gui::BaseApplication
 {
   public:
     using Ra::Gui::BaseApplication::BaseApplication;
+
+    /// Timeline of the frames, with the Qt events handled by the GUI thread when enabled.
+    inline Gui::FrameTracer& tracer() { return m_tracer; }
+
+    /// Time the events delivered on the GUI thread while the tracer is enabled.
+    bool notify( QObject* receiver, QEvent* event ) override;
+
+  private:
+    Gui::FrameTracer m_tracer;
 };
 
 } // namespace Ra
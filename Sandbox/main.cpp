@@ -1,21 +1,51 @@
+#include <Benchmark.hpp>
 #include <MainApplication.hpp>
 
+#include <Engine/RadiumEngine.hpp>
 #include <Gui/Utils/KeyMappingManager.hpp>
 
 #include <Gui/MainWindow.hpp>
+#include <IO/BinaryMeshLoader.hpp>
 
 class MainWindowFactory : public Ra::Gui::BaseApplication::WindowFactory
 {
   public:
     using Ra::Gui::BaseApplication::WindowFactory::WindowFactory;
     Ra::Gui::MainWindowInterface* createMainWindow() const override {
-        return new Ra::Gui::MainWindow();
+        // called by BaseApplication::initialize once the engine exists, before it loads the files
+        // of the command line, which may be .rbm files
+        Ra::Engine::RadiumEngine::getInstance()->registerFileLoader(
+            std::make_shared<Ra::IO::BinaryMeshLoader>() );
+        m_window = new Ra::Gui::MainWindow();
+        return m_window;
     }
+
+    /// The window created by the application.
+    inline Ra::Gui::MainWindow* window() const { return m_window; }
+
+  private:
+    mutable Ra::Gui::MainWindow* m_window{nullptr};
 };
 
 int main( int argc, char** argv ) {
+    Ra::Benchmark::Options benchmarkOptions;
+    if ( !Ra::Benchmark::extractOptions( argc, argv, benchmarkOptions ) ) { return 1; }
+    const bool benchmark = !benchmarkOptions.output.isEmpty();
+    // no window system needed, unless another platform is asked for
+    if ( benchmark && qEnvironmentVariableIsEmpty( "QT_QPA_PLATFORM" ) )
+    { qputenv( "QT_QPA_PLATFORM", "offscreen" ); }
+
     Ra::MainApplication app( argc, argv );
-    app.initialize( MainWindowFactory() );
-    app.setContinuousUpdate( false );
-    return app.exec();
+    MainWindowFactory factory;
+    app.initialize( factory );
+    if ( !benchmark )
+    {
+        app.setContinuousUpdate( false );
+        return app.exec();
+    }
+
+    Ra::Benchmark bench( benchmarkOptions, factory.window() );
+    bench.start();
+    const int result = app.exec();
+    return bench.succeeded() ? result : 1;
 }